@@ -25,13 +25,22 @@ SOURCES += src/main.cpp \
     src/views/sweep_central.cpp \
     src/views/trace_view.cpp \
     src/model/trace.cpp \
+    src/model/channel_power.cpp \
+    src/model/trace_pool.cpp \
+    src/model/device_acquisition.cpp \
+    src/model/stitched_sweep.cpp \
     src/model/marker.cpp \
     src/model/device_bb60a.cpp \
     src/model/trace_manager.cpp \
     src/widgets/measure_panel.cpp \
     src/model/persistence.cpp \
+    src/model/spectral_density.cpp \
     src/model/audio_settings.cpp \
     src/lib/time_type.cpp \
+    src/lib/perf_timer.cpp \
+    src/lib/simd_kernels.cpp \
+    src/lib/minmax_pyramid.cpp \
+    src/lib/buffer_pool.cpp \
     src/model/playback_toolbar.cpp \
     src/widgets/audio_dialog.cpp \
     src/widgets/status_bar.cpp \
@@ -47,6 +56,7 @@ SOURCES += src/main.cpp \
     src/views/demod_sweep_plot.cpp \
     src/widgets/measuring_receiver_dialog.cpp \
     src/model/device_sa.cpp \
+    src/model/device_sim.cpp \
     src/lib/device_traits.cpp \
     src/views/harmonics_central.cpp \
     src/views/gl_sub_view.cpp \
@@ -58,12 +68,20 @@ SOURCES += src/main.cpp \
     src/views/phase_noise_plot.cpp \
     src/widgets/if_output_dialog.cpp \
     src/widgets/self_test_dialog.cpp \
+    src/widgets/device_monitor_dialog.cpp \
+    src/widgets/device_trace_dialog.cpp \
+    src/widgets/channel_power_dialog.cpp \
     src/model/preferences.cpp
 
 HEADERS += src/mainwindow.h \
     src/lib/frequency.h \
     src/lib/macros.h \
     src/lib/time_type.h \
+    src/lib/perf_timer.h \
+    src/lib/simd_kernels.h \
+    src/lib/simd_fused_impl.h \
+    src/lib/minmax_pyramid.h \
+    src/lib/buffer_pool.h \
     src/lib/bb_lib.h \
     src/lib/amplitude.h \
     src/widgets/entry_widgets.h \
@@ -75,6 +93,10 @@ HEADERS += src/mainwindow.h \
     src/views/sweep_central.h \
     src/views/trace_view.h \
     src/model/trace.h \
+    src/model/channel_power.h \
+    src/model/trace_pool.h \
+    src/model/device_acquisition.h \
+    src/model/stitched_sweep.h \
     src/model/marker.h \
     src/model/device.h \
     src/model/device_bb60a.h \
@@ -82,6 +104,7 @@ HEADERS += src/mainwindow.h \
     src/model/trace_manager.h \
     src/widgets/measure_panel.h \
     src/model/persistence.h \
+    src/model/spectral_density.h \
     src/model/audio_settings.h \
     src/views/idle_view.h \
     src/views/persistence_view.h \
@@ -106,6 +129,7 @@ HEADERS += src/mainwindow.h \
     src/views/demod_sweep_plot.h \
     src/widgets/measuring_receiver_dialog.h \
     src/model/device_sa.h \
+    src/model/device_sim.h \
     src/lib/sa_api.h \
     src/lib/device_traits.h \
     src/views/harmonics_central.h \
@@ -117,6 +141,9 @@ HEADERS += src/mainwindow.h \
     src/views/phase_noise_plot.h \
     src/widgets/if_output_dialog.h \
     src/widgets/self_test_dialog.h \
+    src/widgets/device_monitor_dialog.h \
+    src/widgets/device_trace_dialog.h \
+    src/widgets/channel_power_dialog.h \
     src/version.h
 
 OTHER_FILES += \
@@ -129,6 +156,13 @@ LIBS += \
     -Ldebug -lbb_api \
     -Ldebug -lsa_api
 
+# Link the instrumented API stubs from api_stub/ instead of the device drivers
+api_stub {
+    isEmpty(API_STUB_LIB_DIR): API_STUB_LIB_DIR = $$OUT_PWD/api_stub/lib
+    LIBS = -L$$API_STUB_LIB_DIR -lbb_api -lsa_api
+    QMAKE_RPATHDIR += $$API_STUB_LIB_DIR
+}
+
 INCLUDEPATH += src external_libraries
 
 RC_FILE = bb_app.rc
@@ -0,0 +1,53 @@
+#-------------------------------------------------
+#
+# Console benchmark of the post-acquisition trace pipeline.
+# Builds only the model sources the pipeline touches, no device
+#   libraries are linked.
+# Runs on a QCoreApplication and opens no window, the GUI modules are
+#   linked only because bb_lib and trace_manager use GL and dialog types.
+#
+#-------------------------------------------------
+
+QT += core gui opengl widgets
+
+TARGET = BBAppBench
+TEMPLATE = app
+
+CONFIG += console
+CONFIG -= app_bundle
+
+SOURCES += bench/pipeline_bench.cpp \
+    src/lib/bb_lib.cpp \
+    src/lib/amplitude.cpp \
+    src/lib/frequency.cpp \
+    src/lib/time_type.cpp \
+    src/lib/device_traits.cpp \
+    src/lib/perf_timer.cpp \
+    src/lib/simd_kernels.cpp \
+    src/lib/minmax_pyramid.cpp \
+    src/lib/buffer_pool.cpp \
+    src/model/sweep_settings.cpp \
+    src/model/trace.cpp \
+    src/model/channel_power.cpp \
+    src/model/marker.cpp \
+    src/model/trace_manager.cpp \
+    src/model/persistence.cpp \
+    src/model/spectral_density.cpp \
+    src/model/import_table.cpp \
+    src/kiss_fft/kiss_fft.c
+
+HEADERS += src/lib/bb_lib.h \
+    src/lib/perf_timer.h \
+    src/lib/simd_kernels.h \
+    src/lib/simd_fused_impl.h \
+    src/lib/minmax_pyramid.h \
+    src/lib/buffer_pool.h \
+    src/model/sweep_settings.h \
+    src/model/trace.h \
+    src/model/channel_power.h \
+    src/model/trace_manager.h \
+    src/model/persistence.h \
+    src/model/spectral_density.h \
+    src/model/import_table.h
+
+INCLUDEPATH += src external_libraries
@@ -0,0 +1,13 @@
+#-------------------------------------------------
+#
+# Instrumented stand-ins for the bb_api and sa_api libraries.
+# Link BBApp against them with qmake CONFIG+=api_stub
+# See stub_common.h for the runtime options.
+#
+#-------------------------------------------------
+
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    bb_api \
+    sa_api
@@ -0,0 +1,16 @@
+TEMPLATE = lib
+TARGET = bb_api
+CONFIG -= qt
+CONFIG += c++11
+
+DEFINES += BB_EXPORTS
+
+SOURCES += bb_api_stub.cpp \
+    ../stub_common.cpp
+
+HEADERS += ../stub_common.h \
+    ../../src/lib/bb_api.h
+
+INCLUDEPATH += .. ../../src
+
+DESTDIR = $$OUT_PWD/../lib
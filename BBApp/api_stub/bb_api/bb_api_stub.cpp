@@ -0,0 +1,448 @@
+// Link-time replacement for the BB60 API
+// Tracks enough configuration state to report plausible trace, real-time
+//   and stream geometry, and returns a flat noise floor.
+
+#include "lib/bb_api.h"
+#include "stub_common.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+const char *stub_library_name = "bb_api";
+
+namespace {
+
+const int STUB_SERIAL_BASE = 11000000;
+const unsigned int MAX_TRACE_LEN = 1 << 22;
+const int RT_FRAME_HEIGHT = 100;
+const int IQ_RETURN_LEN = 16384;
+const int AUDIO_LEN = 4096;
+
+struct StubDevice {
+    bool open;
+    int mode;
+    unsigned int detector, scale;
+    double center, span, ref, rbw;
+    int decimation;
+    double iqBandwidth;
+    unsigned int traceLen;
+    double binSize, start;
+    unsigned int noise;
+};
+
+StubDevice devices[BB_MAX_DEVICES];
+
+bool valid(int device)
+{
+    return device >= 0 && device < BB_MAX_DEVICES && devices[device].open;
+}
+
+bbStatus open_device(int *device, int index)
+{
+    if(!device) return bbNullPtrErr;
+    if(index < 0 || index >= stub_device_count()) return bbDeviceNotOpenErr;
+    if(devices[index].open) return bbDeviceAlreadyStreamingErr;
+
+    StubDevice &d = devices[index];
+    memset(&d, 0, sizeof(StubDevice));
+    d.open = true;
+    d.mode = BB_IDLE;
+    d.center = 1.0e9;
+    d.span = 20.0e6;
+    d.ref = -20.0;
+    d.rbw = 10.0e3;
+    d.decimation = 1;
+    d.iqBandwidth = 20.0e6;
+    d.noise = 1234567u + index;
+
+    *device = index;
+    return bbNoError;
+}
+
+float noise_floor(StubDevice &d)
+{
+    float dBm = -100.0f + 3.0f * stub_rand(d.noise);
+    if(d.scale == BB_LIN_SCALE) {
+        return pow(10.0, (dBm + 46.9897) * 0.05);
+    }
+    return dBm;
+}
+
+} // namespace
+
+bbStatus bbGetSerialNumberList(int serialNumbers[8], int *deviceCount)
+{
+    STUB_CALL(bbGetSerialNumberList);
+    if(!serialNumbers || !deviceCount) return bbNullPtrErr;
+
+    *deviceCount = stub_device_count();
+    for(int i = 0; i < *deviceCount; i++) {
+        serialNumbers[i] = STUB_SERIAL_BASE + i;
+    }
+    return bbNoError;
+}
+
+bbStatus bbOpenDeviceBySerialNumber(int *device, int serialNumber)
+{
+    STUB_CALL(bbOpenDeviceBySerialNumber);
+    return open_device(device, serialNumber - STUB_SERIAL_BASE);
+}
+
+bbStatus bbOpenDevice(int *device)
+{
+    STUB_CALL(bbOpenDevice);
+    for(int i = 0; i < stub_device_count(); i++) {
+        if(!devices[i].open) {
+            return open_device(device, i);
+        }
+    }
+    return bbDeviceNotOpenErr;
+}
+
+bbStatus bbCloseDevice(int device)
+{
+    STUB_CALL(bbCloseDevice);
+    if(!valid(device)) return bbDeviceNotOpenErr;
+    devices[device].open = false;
+    return bbNoError;
+}
+
+bbStatus bbConfigureAcquisition(int device, unsigned int detector, unsigned int scale)
+{
+    STUB_CALL(bbConfigureAcquisition);
+    if(!valid(device)) return bbDeviceNotOpenErr;
+    devices[device].detector = detector;
+    devices[device].scale = scale;
+    return bbNoError;
+}
+
+bbStatus bbConfigureCenterSpan(int device, double center, double span)
+{
+    STUB_CALL(bbConfigureCenterSpan);
+    if(!valid(device)) return bbDeviceNotOpenErr;
+    if(span < BB_MIN_SPAN) return bbInvalidSpanErr;
+    devices[device].center = center;
+    devices[device].span = span;
+    return bbNoError;
+}
+
+bbStatus bbConfigureLevel(int device, double ref, double)
+{
+    STUB_CALL(bbConfigureLevel);
+    if(!valid(device)) return bbDeviceNotOpenErr;
+    if(ref > BB_MAX_REFERENCE) return bbReferenceLevelErr;
+    devices[device].ref = ref;
+    return bbNoError;
+}
+
+bbStatus bbConfigureGain(int device, int)
+{
+    STUB_CALL(bbConfigureGain);
+    if(!valid(device)) return bbDeviceNotOpenErr;
+    return bbNoError;
+}
+
+bbStatus bbConfigureSweepCoupling(int device, double rbw, double, double,
+                                  unsigned int, unsigned int)
+{
+    STUB_CALL(bbConfigureSweepCoupling);
+    if(!valid(device)) return bbDeviceNotOpenErr;
+    if(rbw < BB_MIN_BW || rbw > BB_MAX_BW) return bbBandwidthErr;
+    devices[device].rbw = rbw;
+    return bbNoError;
+}
+
+bbStatus bbConfigureWindow(int device, unsigned int)
+{
+    STUB_CALL(bbConfigureWindow);
+    if(!valid(device)) return bbDeviceNotOpenErr;
+    return bbNoError;
+}
+
+bbStatus bbConfigureProcUnits(int device, unsigned int)
+{
+    STUB_CALL(bbConfigureProcUnits);
+    if(!valid(device)) return bbDeviceNotOpenErr;
+    return bbNoError;
+}
+
+bbStatus bbConfigureIO(int device, unsigned int, unsigned int)
+{
+    STUB_CALL(bbConfigureIO);
+    if(!valid(device)) return bbDeviceNotOpenErr;
+    return bbNoError;
+}
+
+bbStatus bbConfigureDemod(int device, int, double, float, float, float, float)
+{
+    STUB_CALL(bbConfigureDemod);
+    if(!valid(device)) return bbDeviceNotOpenErr;
+    return bbNoError;
+}
+
+bbStatus bbConfigureIQ(int device, int downsampleFactor, double bandwidth)
+{
+    STUB_CALL(bbConfigureIQ);
+    if(!valid(device)) return bbDeviceNotOpenErr;
+    if(downsampleFactor < 1 || downsampleFactor > BB_MAX_DECIMATION) {
+        return bbInvalidParameterErr;
+    }
+    devices[device].decimation = downsampleFactor;
+    devices[device].iqBandwidth = bandwidth;
+    return bbNoError;
+}
+
+bbStatus bbConfigureRealTime(int device, double, int)
+{
+    STUB_CALL(bbConfigureRealTime);
+    if(!valid(device)) return bbDeviceNotOpenErr;
+    return bbNoError;
+}
+
+bbStatus bbInitiate(int device, unsigned int mode, unsigned int)
+{
+    STUB_CALL(bbInitiate);
+    if(!valid(device)) return bbDeviceNotOpenErr;
+
+    StubDevice &d = devices[device];
+    d.mode = mode;
+    d.binSize = d.rbw / 2.0;
+    d.traceLen = std::min((unsigned int)(d.span / d.binSize) + 1, MAX_TRACE_LEN);
+    d.binSize = d.span / std::max(d.traceLen - 1, 1u);
+    d.start = d.center - d.span / 2.0;
+    return bbNoError;
+}
+
+bbStatus bbFetchTrace_32f(int device, int arraySize, float *min, float *max)
+{
+    STUB_CALL(bbFetchTrace_32f);
+    if(!valid(device)) return bbDeviceNotOpenErr;
+    if(!min || !max) return bbNullPtrErr;
+
+    StubDevice &d = devices[device];
+    if(d.mode != BB_SWEEPING) return bbDeviceNotConfiguredErr;
+    if(arraySize < (int)d.traceLen) return bbBufferTooSmallErr;
+    if(stub_inject_timeout()) return bbUSBTimeoutErr;
+
+    for(unsigned int i = 0; i < d.traceLen; i++) {
+        min[i] = max[i] = noise_floor(d);
+    }
+    return bbNoError;
+}
+
+bbStatus bbFetchTrace(int device, int arraySize, double *min, double *max)
+{
+    STUB_CALL(bbFetchTrace);
+    if(!valid(device)) return bbDeviceNotOpenErr;
+    if(!min || !max) return bbNullPtrErr;
+
+    StubDevice &d = devices[device];
+    if(d.mode != BB_SWEEPING) return bbDeviceNotConfiguredErr;
+    if(arraySize < (int)d.traceLen) return bbBufferTooSmallErr;
+    if(stub_inject_timeout()) return bbUSBTimeoutErr;
+
+    for(unsigned int i = 0; i < d.traceLen; i++) {
+        min[i] = max[i] = noise_floor(d);
+    }
+    return bbNoError;
+}
+
+bbStatus bbFetchRealTimeFrame(int device, float *sweep, float *frame)
+{
+    STUB_CALL(bbFetchRealTimeFrame);
+    if(!valid(device)) return bbDeviceNotOpenErr;
+    if(!sweep || !frame) return bbNullPtrErr;
+
+    StubDevice &d = devices[device];
+    if(d.mode != BB_REAL_TIME) return bbDeviceNotConfiguredErr;
+    if(stub_inject_timeout()) return bbUSBTimeoutErr;
+
+    memset(frame, 0, sizeof(float) * d.traceLen * RT_FRAME_HEIGHT);
+    for(unsigned int i = 0; i < d.traceLen; i++) {
+        sweep[i] = noise_floor(d);
+        frame[(RT_FRAME_HEIGHT / 10) * d.traceLen + i] = 1.0f;
+    }
+    return bbNoError;
+}
+
+bbStatus bbFetchAudio(int device, float *audio)
+{
+    STUB_CALL(bbFetchAudio);
+    if(!valid(device)) return bbDeviceNotOpenErr;
+    if(!audio) return bbNullPtrErr;
+    if(devices[device].mode != BB_AUDIO_DEMOD) return bbDeviceNotConfiguredErr;
+
+    memset(audio, 0, sizeof(float) * AUDIO_LEN);
+    return bbNoError;
+}
+
+bbStatus bbFetchRaw(int device, float *buffer, int triggers[64])
+{
+    STUB_CALL(bbFetchRaw);
+    if(!valid(device)) return bbDeviceNotOpenErr;
+    if(!buffer) return bbNullPtrErr;
+
+    StubDevice &d = devices[device];
+    if(d.mode != BB_STREAMING) return bbDeviceNotStreamingErr;
+    if(stub_inject_timeout()) return bbUSBTimeoutErr;
+
+    for(int i = 0; i < IQ_RETURN_LEN * 2; i++) {
+        buffer[i] = (stub_rand(d.noise) - 0.5f) * 1.0e-5f;
+    }
+    if(triggers) {
+        memset(triggers, 0, sizeof(int) * 64);
+    }
+    return bbNoError;
+}
+
+bbStatus bbQueryTraceInfo(int device, unsigned int *traceLen, double *binSize, double *start)
+{
+    STUB_CALL(bbQueryTraceInfo);
+    if(!valid(device)) return bbDeviceNotOpenErr;
+    if(!traceLen || !binSize || !start) return bbNullPtrErr;
+
+    StubDevice &d = devices[device];
+    *traceLen = d.traceLen;
+    *binSize = d.binSize;
+    *start = d.start;
+    return bbNoError;
+}
+
+bbStatus bbQueryRealTimeInfo(int device, int *frameWidth, int *frameHeight)
+{
+    STUB_CALL(bbQueryRealTimeInfo);
+    if(!valid(device)) return bbDeviceNotOpenErr;
+    if(!frameWidth || !frameHeight) return bbNullPtrErr;
+
+    *frameWidth = devices[device].traceLen;
+    *frameHeight = RT_FRAME_HEIGHT;
+    return bbNoError;
+}
+
+bbStatus bbQueryTimestamp(int device, unsigned int *seconds, unsigned int *nanoseconds)
+{
+    STUB_CALL(bbQueryTimestamp);
+    if(!valid(device)) return bbDeviceNotOpenErr;
+    if(!seconds || !nanoseconds) return bbNullPtrErr;
+
+    *seconds = *nanoseconds = 0;
+    return bbNoError;
+}
+
+bbStatus bbQueryStreamInfo(int device, int *return_len, double *bandwidth, int *samples_per_sec)
+{
+    STUB_CALL(bbQueryStreamInfo);
+    if(!valid(device)) return bbDeviceNotOpenErr;
+    if(!return_len || !bandwidth || !samples_per_sec) return bbNullPtrErr;
+
+    StubDevice &d = devices[device];
+    *return_len = IQ_RETURN_LEN;
+    *bandwidth = d.iqBandwidth;
+    *samples_per_sec = 40000000 / d.decimation;
+    return bbNoError;
+}
+
+bbStatus bbAbort(int device)
+{
+    STUB_CALL(bbAbort);
+    if(!valid(device)) return bbDeviceNotOpenErr;
+    devices[device].mode = BB_IDLE;
+    return bbNoError;
+}
+
+bbStatus bbPreset(int device)
+{
+    STUB_CALL(bbPreset);
+    if(!valid(device)) return bbDeviceNotOpenErr;
+    return bbNoError;
+}
+
+bbStatus bbSelfCal(int device)
+{
+    STUB_CALL(bbSelfCal);
+    if(!valid(device)) return bbDeviceNotOpenErr;
+    return bbNoError;
+}
+
+bbStatus bbSyncCPUtoGPS(int, int)
+{
+    STUB_CALL(bbSyncCPUtoGPS);
+    return bbGPSErr;
+}
+
+bbStatus bbGetDeviceType(int device, int *type)
+{
+    STUB_CALL(bbGetDeviceType);
+    if(!type) return bbNullPtrErr;
+    *type = valid(device) ? BB_DEVICE_BB60C : BB_DEVICE_NONE;
+    return valid(device) ? bbNoError : bbDeviceNotOpenErr;
+}
+
+bbStatus bbGetSerialNumber(int device, unsigned int *sid)
+{
+    STUB_CALL(bbGetSerialNumber);
+    if(!valid(device)) return bbDeviceNotOpenErr;
+    if(!sid) return bbNullPtrErr;
+    *sid = STUB_SERIAL_BASE + device;
+    return bbNoError;
+}
+
+bbStatus bbGetFirmwareVersion(int device, int *version)
+{
+    STUB_CALL(bbGetFirmwareVersion);
+    if(!valid(device)) return bbDeviceNotOpenErr;
+    if(!version) return bbNullPtrErr;
+    *version = 0;
+    return bbNoError;
+}
+
+bbStatus bbGetDeviceDiagnostics(int device, float *temperature, float *usbVoltage, float *usbCurrent)
+{
+    STUB_CALL(bbGetDeviceDiagnostics);
+    if(!valid(device)) return bbDeviceNotOpenErr;
+    if(temperature) *temperature = 35.0f;
+    if(usbVoltage) *usbVoltage = 5.0f;
+    if(usbCurrent) *usbCurrent = 0.5f;
+    return bbNoError;
+}
+
+const char* bbGetAPIVersion()
+{
+    return "stub";
+}
+
+const char* bbGetErrorString(bbStatus status)
+{
+    switch(status) {
+    case bbNoError: return "No error";
+    case bbDeviceNotOpenErr: return "Device not open";
+    case bbDeviceNotConfiguredErr: return "Device not configured";
+    case bbDeviceNotStreamingErr: return "Device not streaming";
+    case bbNullPtrErr: return "Null pointer";
+    case bbBufferTooSmallErr: return "Buffer too small";
+    case bbInvalidParameterErr: return "Invalid parameter";
+    case bbUSBTimeoutErr: return "USB timeout (injected)";
+    case bbGPSErr: return "GPS not available";
+    case bbBandwidthErr: return "Invalid bandwidth";
+    case bbInvalidSpanErr: return "Invalid span";
+    case bbReferenceLevelErr: return "Invalid reference level";
+    default: return "Stub status";
+    }
+}
+
+void bbConvert_32f16s(const float *src, short *dst, int scaleFactor, int len)
+{
+    float scale = ldexp(1.0f, scaleFactor);
+    for(int i = 0; i < len; i++) {
+        dst[i] = (short)(src[i] * scale);
+    }
+}
+
+void bbConvert_16s32f(const short *src, float *dst, int scaleFactor, int len)
+{
+    float scale = ldexp(1.0f, scaleFactor);
+    for(int i = 0; i < len; i++) {
+        dst[i] = src[i] * scale;
+    }
+}
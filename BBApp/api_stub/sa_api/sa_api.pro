@@ -0,0 +1,16 @@
+TEMPLATE = lib
+TARGET = sa_api
+CONFIG -= qt
+CONFIG += c++11
+
+DEFINES += SA_EXPORTS
+
+SOURCES += sa_api_stub.cpp \
+    ../stub_common.cpp
+
+HEADERS += ../stub_common.h \
+    ../../src/lib/sa_api.h
+
+INCLUDEPATH += .. ../../src
+
+DESTDIR = $$OUT_PWD/../lib
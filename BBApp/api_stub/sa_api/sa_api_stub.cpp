@@ -0,0 +1,519 @@
+// Link-time replacement for the SA44/SA124 API
+// Partial sweeps are returned in quarters to exercise the fast sweep
+//   update range handling.
+
+#include "lib/sa_api.h"
+#include "stub_common.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+const char *stub_library_name = "sa_api";
+
+namespace {
+
+const int STUB_SERIAL_BASE = 12000000;
+const int MAX_SWEEP_LEN = 1 << 22;
+const int RT_FRAME_HEIGHT = 100;
+const int IQ_RETURN_LEN = 4096;
+const int AUDIO_LEN = 4096;
+const int PARTIAL_SWEEP_CHUNKS = 4;
+
+struct StubDevice {
+    bool open;
+    int mode;
+    int detector, scale;
+    double center, span, ref, rbw;
+    int decimation;
+    double iqBandwidth;
+    int sweepLen;
+    double binSize, start;
+    int partialPos;
+    bool tgAttached;
+    unsigned int noise;
+};
+
+StubDevice devices[SA_MAX_DEVICES];
+
+bool valid(int device)
+{
+    return device >= 0 && device < SA_MAX_DEVICES && devices[device].open;
+}
+
+saStatus open_device(int *device, int index)
+{
+    if(!device) return saNullPtrErr;
+    if(index < 0 || index >= stub_device_count()) return saDeviceNotFoundErr;
+    if(devices[index].open) return saDeviceNotIdleErr;
+
+    StubDevice &d = devices[index];
+    memset(&d, 0, sizeof(StubDevice));
+    d.open = true;
+    d.mode = SA_IDLE;
+    d.center = 1.0e9;
+    d.span = 1.0e6;
+    d.ref = -20.0;
+    d.rbw = 1.0e3;
+    d.decimation = 1;
+    d.iqBandwidth = 250.0e3;
+    d.noise = 7654321u + index;
+
+    *device = index;
+    return saNoError;
+}
+
+float noise_floor(StubDevice &d)
+{
+    float dBm = -110.0f + 3.0f * stub_rand(d.noise);
+    if(d.scale == SA_LIN_SCALE) {
+        return pow(10.0, (dBm + 46.9897) * 0.05);
+    }
+    return dBm;
+}
+
+void fill_sweep(StubDevice &d, float *min, float *max, int from, int to)
+{
+    for(int i = from; i < to; i++) {
+        min[i] = max[i] = noise_floor(d);
+    }
+}
+
+} // namespace
+
+saStatus saGetSerialNumberList(int serialNumbers[8], int *deviceCount)
+{
+    STUB_CALL(saGetSerialNumberList);
+    if(!serialNumbers || !deviceCount) return saNullPtrErr;
+
+    *deviceCount = stub_device_count();
+    for(int i = 0; i < *deviceCount; i++) {
+        serialNumbers[i] = STUB_SERIAL_BASE + i;
+    }
+    return saNoError;
+}
+
+saStatus saOpenDeviceBySerialNumber(int *device, int serialNumber)
+{
+    STUB_CALL(saOpenDeviceBySerialNumber);
+    return open_device(device, serialNumber - STUB_SERIAL_BASE);
+}
+
+saStatus saOpenDevice(int *device)
+{
+    STUB_CALL(saOpenDevice);
+    for(int i = 0; i < stub_device_count(); i++) {
+        if(!devices[i].open) {
+            return open_device(device, i);
+        }
+    }
+    return saDeviceNotFoundErr;
+}
+
+saStatus saCloseDevice(int device)
+{
+    STUB_CALL(saCloseDevice);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    devices[device].open = false;
+    return saNoError;
+}
+
+saStatus saPreset(int device)
+{
+    STUB_CALL(saPreset);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    return saNoError;
+}
+
+saStatus saGetSerialNumber(int device, int *serial)
+{
+    STUB_CALL(saGetSerialNumber);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    if(!serial) return saNullPtrErr;
+    *serial = STUB_SERIAL_BASE + device;
+    return saNoError;
+}
+
+saStatus saGetFirmwareString(int device, char firmwareString[16])
+{
+    STUB_CALL(saGetFirmwareString);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    if(!firmwareString) return saNullPtrErr;
+    strcpy(firmwareString, "stub");
+    return saNoError;
+}
+
+saStatus saGetDeviceType(int device, saDeviceType *device_type)
+{
+    STUB_CALL(saGetDeviceType);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    if(!device_type) return saNullPtrErr;
+    *device_type = saDeviceTypeSA44B;
+    return saNoError;
+}
+
+saStatus saConfigAcquisition(int device, int detector, int scale)
+{
+    STUB_CALL(saConfigAcquisition);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    devices[device].detector = detector;
+    devices[device].scale = scale;
+    return saNoError;
+}
+
+saStatus saConfigCenterSpan(int device, double center, double span)
+{
+    STUB_CALL(saConfigCenterSpan);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    if(span < SA_MIN_SPAN) return saInvalidParameterErr;
+    devices[device].center = center;
+    devices[device].span = span;
+    return saNoError;
+}
+
+saStatus saConfigLevel(int device, double ref)
+{
+    STUB_CALL(saConfigLevel);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    devices[device].ref = ref;
+    return saNoError;
+}
+
+saStatus saConfigGainAtten(int device, int, int, bool)
+{
+    STUB_CALL(saConfigGainAtten);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    return saNoError;
+}
+
+saStatus saConfigSweepCoupling(int device, double rbw, double, bool)
+{
+    STUB_CALL(saConfigSweepCoupling);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    if(rbw < SA_MIN_RBW || rbw > SA_MAX_RBW) return saBandwidthErr;
+    devices[device].rbw = rbw;
+    return saNoError;
+}
+
+saStatus saConfigProcUnits(int device, int)
+{
+    STUB_CALL(saConfigProcUnits);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    return saNoError;
+}
+
+saStatus saConfigIQ(int device, int decimation, double bandwidth)
+{
+    STUB_CALL(saConfigIQ);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    if(decimation < 1 || decimation > SA_MAX_IQ_DECIMATION) return saInvalidParameterErr;
+    devices[device].decimation = decimation;
+    devices[device].iqBandwidth = bandwidth;
+    return saNoError;
+}
+
+saStatus saConfigAudio(int device, int, double, double, double, double, double)
+{
+    STUB_CALL(saConfigAudio);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    return saNoError;
+}
+
+saStatus saConfigRealTime(int device, double, int)
+{
+    STUB_CALL(saConfigRealTime);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    return saNoError;
+}
+
+saStatus saEnableExternalReference(int device)
+{
+    STUB_CALL(saEnableExternalReference);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    return saExternalReferenceNotFound;
+}
+
+saStatus saInitiate(int device, int mode, int)
+{
+    STUB_CALL(saInitiate);
+    if(!valid(device)) return saDeviceNotOpenErr;
+
+    StubDevice &d = devices[device];
+    d.mode = mode;
+    d.binSize = d.rbw / 2.0;
+    d.sweepLen = std::min((int)(d.span / d.binSize) + 1, MAX_SWEEP_LEN);
+    d.binSize = d.span / std::max(d.sweepLen - 1, 1);
+    d.start = d.center - d.span / 2.0;
+    d.partialPos = 0;
+    return saNoError;
+}
+
+saStatus saAbort(int device)
+{
+    STUB_CALL(saAbort);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    devices[device].mode = SA_IDLE;
+    return saNoError;
+}
+
+saStatus saQuerySweepInfo(int device, int *sweepLength, double *startFreq, double *binSize)
+{
+    STUB_CALL(saQuerySweepInfo);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    if(!sweepLength || !startFreq || !binSize) return saNullPtrErr;
+
+    StubDevice &d = devices[device];
+    *sweepLength = d.sweepLen;
+    *startFreq = d.start;
+    *binSize = d.binSize;
+    return saNoError;
+}
+
+saStatus saQueryStreamInfo(int device, int *returnLen, double *bandwidth, double *samplesPerSecond)
+{
+    STUB_CALL(saQueryStreamInfo);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    if(!returnLen || !bandwidth || !samplesPerSecond) return saNullPtrErr;
+
+    StubDevice &d = devices[device];
+    *returnLen = IQ_RETURN_LEN;
+    *bandwidth = d.iqBandwidth;
+    *samplesPerSecond = SA_IQ_SAMPLE_RATE / d.decimation;
+    return saNoError;
+}
+
+saStatus saQueryRealTimeFrameInfo(int device, int *imageWidth, int *imageHeight)
+{
+    STUB_CALL(saQueryRealTimeFrameInfo);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    if(!imageWidth || !imageHeight) return saNullPtrErr;
+
+    *imageWidth = devices[device].sweepLen;
+    *imageHeight = RT_FRAME_HEIGHT;
+    return saNoError;
+}
+
+saStatus saGetSweep_32f(int device, float *min, float *max)
+{
+    STUB_CALL(saGetSweep_32f);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    if(!min || !max) return saNullPtrErr;
+
+    StubDevice &d = devices[device];
+    if(d.mode != SA_SWEEPING && d.mode != SA_TG_SWEEP) return saNotConfiguredErr;
+    if(stub_inject_timeout()) return saUSBCommErr;
+
+    fill_sweep(d, min, max, 0, d.sweepLen);
+    return saNoError;
+}
+
+saStatus saGetSweep_64f(int device, double *min, double *max)
+{
+    STUB_CALL(saGetSweep_64f);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    if(!min || !max) return saNullPtrErr;
+
+    StubDevice &d = devices[device];
+    if(d.mode != SA_SWEEPING && d.mode != SA_TG_SWEEP) return saNotConfiguredErr;
+    if(stub_inject_timeout()) return saUSBCommErr;
+
+    for(int i = 0; i < d.sweepLen; i++) {
+        min[i] = max[i] = noise_floor(d);
+    }
+    return saNoError;
+}
+
+saStatus saGetPartialSweep_32f(int device, float *min, float *max, int *start, int *stop)
+{
+    STUB_CALL(saGetPartialSweep_32f);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    if(!min || !max || !start || !stop) return saNullPtrErr;
+
+    StubDevice &d = devices[device];
+    if(d.mode != SA_SWEEPING && d.mode != SA_TG_SWEEP) return saNotConfiguredErr;
+    if(stub_inject_timeout()) return saUSBCommErr;
+
+    if(d.partialPos >= d.sweepLen) {
+        d.partialPos = 0;
+    }
+    int chunk = std::max(d.sweepLen / PARTIAL_SWEEP_CHUNKS, 1);
+    int to = std::min(d.partialPos + chunk, d.sweepLen);
+    fill_sweep(d, min, max, d.partialPos, to);
+
+    *start = d.partialPos;
+    *stop = to;
+    d.partialPos = to;
+    return saNoError;
+}
+
+saStatus saGetPartialSweep_64f(int device, double *min, double *max, int *start, int *stop)
+{
+    STUB_CALL(saGetPartialSweep_64f);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    if(!min || !max || !start || !stop) return saNullPtrErr;
+
+    StubDevice &d = devices[device];
+    if(d.mode != SA_SWEEPING && d.mode != SA_TG_SWEEP) return saNotConfiguredErr;
+    if(stub_inject_timeout()) return saUSBCommErr;
+
+    for(int i = 0; i < d.sweepLen; i++) {
+        min[i] = max[i] = noise_floor(d);
+    }
+    *start = 0;
+    *stop = d.sweepLen;
+    return saNoError;
+}
+
+saStatus saGetRealTimeFrame(int device, float *sweep, float *frame)
+{
+    STUB_CALL(saGetRealTimeFrame);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    if(!sweep || !frame) return saNullPtrErr;
+
+    StubDevice &d = devices[device];
+    if(d.mode != SA_REAL_TIME) return saNotConfiguredErr;
+    if(stub_inject_timeout()) return saUSBCommErr;
+
+    memset(frame, 0, sizeof(float) * d.sweepLen * RT_FRAME_HEIGHT);
+    for(int i = 0; i < d.sweepLen; i++) {
+        sweep[i] = noise_floor(d);
+        frame[(RT_FRAME_HEIGHT / 10) * d.sweepLen + i] = 1.0f;
+    }
+    return saNoError;
+}
+
+saStatus saGetIQ_32f(int device, float *iq)
+{
+    STUB_CALL(saGetIQ_32f);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    if(!iq) return saNullPtrErr;
+
+    StubDevice &d = devices[device];
+    if(d.mode != SA_IQ) return saNotConfiguredErr;
+    if(stub_inject_timeout()) return saUSBCommErr;
+
+    for(int i = 0; i < IQ_RETURN_LEN * 2; i++) {
+        iq[i] = (stub_rand(d.noise) - 0.5f) * 1.0e-5f;
+    }
+    return saNoError;
+}
+
+saStatus saGetIQ_64f(int device, double *iq)
+{
+    STUB_CALL(saGetIQ_64f);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    if(!iq) return saNullPtrErr;
+
+    StubDevice &d = devices[device];
+    if(d.mode != SA_IQ) return saNotConfiguredErr;
+    if(stub_inject_timeout()) return saUSBCommErr;
+
+    for(int i = 0; i < IQ_RETURN_LEN * 2; i++) {
+        iq[i] = (stub_rand(d.noise) - 0.5f) * 1.0e-5f;
+    }
+    return saNoError;
+}
+
+saStatus saGetAudio(int device, float *audio)
+{
+    STUB_CALL(saGetAudio);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    if(!audio) return saNullPtrErr;
+    if(devices[device].mode != SA_AUDIO) return saNotConfiguredErr;
+
+    memset(audio, 0, sizeof(float) * AUDIO_LEN);
+    return saNoError;
+}
+
+saStatus saQueryTemperature(int device, float *temp)
+{
+    STUB_CALL(saQueryTemperature);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    if(!temp) return saNullPtrErr;
+    *temp = 35.0f;
+    return saNoError;
+}
+
+saStatus saQueryDiagnostics(int device, float *voltage)
+{
+    STUB_CALL(saQueryDiagnostics);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    if(!voltage) return saNullPtrErr;
+    *voltage = 5.0f;
+    return saNoError;
+}
+
+saStatus saAttachTg(int device)
+{
+    STUB_CALL(saAttachTg);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    return saTrackingGeneratorNotFound;
+}
+
+saStatus saIsTgAttached(int device, bool *attached)
+{
+    STUB_CALL(saIsTgAttached);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    if(!attached) return saNullPtrErr;
+    *attached = devices[device].tgAttached;
+    return saNoError;
+}
+
+saStatus saConfigTgSweep(int device, int, bool, bool)
+{
+    STUB_CALL(saConfigTgSweep);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    return saTrackingGeneratorNotFound;
+}
+
+saStatus saStoreTgThru(int device, int)
+{
+    STUB_CALL(saStoreTgThru);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    return saTrackingGeneratorNotFound;
+}
+
+saStatus saSetTg(int device, double, double)
+{
+    STUB_CALL(saSetTg);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    return saTrackingGeneratorNotFound;
+}
+
+saStatus saConfigIFOutput(int device, double, double, int, int)
+{
+    STUB_CALL(saConfigIFOutput);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    return saNoError;
+}
+
+saStatus saSelfTest(int device, saSelfTestResults *results)
+{
+    STUB_CALL(saSelfTest);
+    if(!valid(device)) return saDeviceNotOpenErr;
+    if(!results) return saNullPtrErr;
+    memset(results, 0, sizeof(saSelfTestResults));
+    return saNoError;
+}
+
+const char* saGetAPIVersion()
+{
+    return "stub";
+}
+
+const char* saGetErrorString(saStatus code)
+{
+    switch(code) {
+    case saNoError: return "No error";
+    case saDeviceNotOpenErr: return "Device not open";
+    case saDeviceNotFoundErr: return "Device not found";
+    case saNotConfiguredErr: return "Device not configured";
+    case saNullPtrErr: return "Null pointer";
+    case saInvalidParameterErr: return "Invalid parameter";
+    case saUSBCommErr: return "USB communication error (injected)";
+    case saBandwidthErr: return "Invalid bandwidth";
+    case saTrackingGeneratorNotFound: return "Tracking generator not found";
+    case saExternalReferenceNotFound: return "External reference not found";
+    default: return "Stub status";
+    }
+}
@@ -0,0 +1,142 @@
+#include "stub_common.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+namespace {
+
+typedef std::chrono::steady_clock clock;
+
+long long env_int(const char *name, long long default_val)
+{
+    const char *val = getenv(name);
+    if(!val || !*val) {
+        return default_val;
+    }
+    return atoll(val);
+}
+
+// Lock-free singly linked list of every StubCall constructed
+std::atomic<StubCall*> call_list(nullptr);
+
+// Writes the call-count report when the library unloads
+class StubReport {
+public:
+    StubReport() :
+        epoch(clock::now()),
+        trace(env_int("API_STUB_TRACE", 0) != 0)
+    {}
+
+    ~StubReport()
+    {
+        std::vector<StubCall*> calls;
+        for(StubCall *c = call_list.load(); c; c = c->next) {
+            calls.push_back(c);
+        }
+        std::sort(calls.begin(), calls.end(), [](StubCall *a, StubCall *b) {
+            return strcmp(a->name, b->name) < 0;
+        });
+
+        const char *path = getenv("API_STUB_LOG");
+        FILE *f = (path && *path) ? fopen(path, "a") : nullptr;
+        if(!f) f = stderr;
+
+        fprintf(f, "%s stub call report\n", stub_library_name);
+        fprintf(f, "%-28s %10s %14s %12s\n", "function", "calls", "total ms", "mean us");
+        for(StubCall *c : calls) {
+            long long n = c->count.load();
+            double total_ms = c->total_ns.load() * 1.0e-6;
+            fprintf(f, "%-28s %10lld %14.3f %12.3f\n", c->name, n, total_ms,
+                    (n > 0) ? (total_ms * 1.0e3 / n) : 0.0);
+        }
+
+        if(f != stderr) fclose(f);
+    }
+
+    clock::time_point epoch;
+    bool trace;
+};
+
+StubReport& report()
+{
+    static StubReport r;
+    return r;
+}
+
+void wait_ns(long long ns)
+{
+    if(ns <= 0) {
+        return;
+    }
+
+    // Sleep for the bulk, spin the remainder for sub-ms accuracy
+    clock::time_point until = clock::now() + std::chrono::nanoseconds(ns);
+    if(ns > 2000000) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(ns - 1000000));
+    }
+    while(clock::now() < until) {}
+}
+
+} // namespace
+
+StubCall::StubCall(const char *function_name) :
+    name(function_name),
+    count(0),
+    total_ns(0)
+{
+    // Construct the report first so it outlives every StubCall
+    report();
+
+    std::string per_call = std::string("API_STUB_LATENCY_") + name;
+    long long us = env_int(per_call.c_str(), env_int("API_STUB_LATENCY_US", 0));
+    latency_ns = us * 1000;
+
+    next = call_list.load();
+    while(!call_list.compare_exchange_weak(next, this)) {}
+}
+
+StubScope::StubScope(StubCall &c) :
+    call(c),
+    start(clock::now())
+{
+    if(report().trace) {
+        double t = std::chrono::duration<double>(start - report().epoch).count();
+        fprintf(stderr, "%12.6f %s\n", t, call.name);
+    }
+    wait_ns(call.latency_ns);
+}
+
+StubScope::~StubScope()
+{
+    call.count++;
+    call.total_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                clock::now() - start).count();
+}
+
+bool stub_inject_timeout()
+{
+    static const long long every = env_int("API_STUB_TIMEOUT_EVERY", 0);
+    static std::atomic<long long> fetches(0);
+
+    if(every <= 0) {
+        return false;
+    }
+    return (++fetches % every) == 0;
+}
+
+int stub_device_count()
+{
+    long long n = env_int("API_STUB_DEVICES", 1);
+    return (int)std::min(std::max(n, 0LL), 8LL);
+}
+
+float stub_rand(unsigned int &state)
+{
+    state = state * 1664525u + 1013904223u;
+    return (state >> 8) * (1.0f / 16777216.0f);
+}
@@ -0,0 +1,55 @@
+#ifndef STUB_COMMON_H
+#define STUB_COMMON_H
+
+#include <atomic>
+#include <chrono>
+
+// Shared instrumentation for the bb_api/sa_api stub libraries
+//
+// Environment variables
+//   API_STUB_LATENCY_US          Default latency added to every call
+//   API_STUB_LATENCY_<function>  Latency in us for a single entry point,
+//                                  i.e. API_STUB_LATENCY_bbFetchTrace_32f=8000
+//   API_STUB_TIMEOUT_EVERY       Every Nth fetch returns a USB timeout
+//   API_STUB_DEVICES             Number of devices reported, default 1
+//   API_STUB_LOG                 Call-count report path, stderr by default
+//   API_STUB_TRACE               Non-zero to log every call as it happens
+
+// One instrumented API entry point, registered on first use
+class StubCall {
+public:
+    StubCall(const char *function_name);
+
+    const char *name;
+    long long latency_ns;
+    std::atomic<long long> count;
+    std::atomic<long long> total_ns;
+    StubCall *next;
+};
+
+// Counts, delays and times one call, declare at the top of every stub
+class StubScope {
+public:
+    StubScope(StubCall &c);
+    ~StubScope();
+
+private:
+    StubCall &call;
+    std::chrono::steady_clock::time_point start;
+};
+
+#define STUB_CALL(fn) \
+    static StubCall fn##_call(#fn); \
+    StubScope fn##_scope(fn##_call) /* end */
+
+// Defined by each stub library, labels the call report
+extern const char *stub_library_name;
+
+// True if the current fetch should fail with a timeout
+bool stub_inject_timeout();
+// Number of devices the stub reports as connected
+int stub_device_count();
+// Cheap deterministic noise in [0,1)
+float stub_rand(unsigned int &state);
+
+#endif // STUB_COMMON_H
@@ -0,0 +1,364 @@
+/*
+ * Headless benchmark of the post-acquisition sweep pipeline.
+ * Runs each stage on seeded synthetic traces from 1k to 4M bins and
+ *   reports ns/bin and Mbins/sec per stage.
+ *
+ * Usage: BBAppBench [--sizes 1024,65536,...] [--bins-per-size N]
+ *                   [--seed N] [--csv file]
+ */
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QTemporaryFile>
+#include <QTextStream>
+#include <QFile>
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "model/trace.h"
+#include "model/trace_manager.h"
+#include "model/import_table.h"
+#include "model/persistence.h"
+#include "model/spectral_density.h"
+#include "model/sweep_settings.h"
+#include "lib/simd_kernels.h"
+
+enum BenchStage {
+    StageRefOffset,
+    StagePathLoss,
+    StageDbmToMv,
+    StageSignalPeak,
+    StagePeakList,
+    StagePeakHop,
+    StageLimitLine,
+    StageCorrections,
+    StageTraceUpdate,
+    StageTraceUpdateFused,
+    StageNormalize,
+    StagePersistence,
+    StageDensity,
+    StageRealTimeRgba,
+    StageChannelPower,
+    StageOccupiedBW,
+    StageUpdateTraces,
+    STAGE_COUNT
+};
+
+static const char *stage_names[STAGE_COUNT] = {
+    "ApplyOffset",
+    "PathLossTable::Apply",
+    "dbm_to_mv",
+    "GetSignalPeak",
+    "GetPeakList",
+    "NextPeakRight (all peaks)",
+    "LimitLineTable::Apply",
+    "CorrectionStage::Apply",
+    "Trace::Update x6",
+    "Trace::UpdateAll x6",
+    "normalize_trace",
+    "Persistence::Accumulate",
+    "SpectralDensity::Accumulate",
+    "simdIntensityToRgba_32f",
+    "ChannelPower::Update",
+    "GetOccupiedBandwidth",
+    "UpdateTraces (total)"
+};
+
+static const double BENCH_CENTER = 1.0e9;
+static const double BENCH_SPAN = 100.0e6;
+
+// Write a two column CSV table, flat across the whole span
+static bool write_table(QTemporaryFile &file, double min, double max)
+{
+    if(!file.open()) {
+        return false;
+    }
+    QTextStream out(&file);
+    for(int i = 0; i <= 10; i++) {
+        double mhz = (BENCH_CENTER - BENCH_SPAN) * 1.0e-6 + i * (BENCH_SPAN * 2.0e-7);
+        out << mhz << ", " << min << ", " << max << "\n";
+    }
+    out.flush();
+    file.close();
+    return true;
+}
+
+// Noise floor with a handful of tones, deterministic for a given seed
+static void build_trace(Trace &t, const SweepSettings &ss, int len, unsigned int seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> noise(-3.0f, 3.0f);
+
+    double bin = BENCH_SPAN / len;
+    t.SetSettings(ss);
+    t.SetSize(len);
+    t.SetFreq(bin, BENCH_CENTER - BENCH_SPAN / 2.0);
+    t.SetUpdateRange(0, len);
+
+    for(int i = 0; i < len; i++) {
+        float n = noise(rng);
+        t.Min()[i] = -110.0f + n - 3.0f;
+        t.Max()[i] = -110.0f + n + 3.0f;
+    }
+
+    for(int k = 1; k <= 8; k++) {
+        int center = (len * k) / 9;
+        int width = bb_lib::max2(len / 1000, 1);
+        for(int i = center - width; i <= center + width && i < len; i++) {
+            t.Min()[i] = t.Max()[i] = -20.0f - 5.0f * k;
+        }
+    }
+}
+
+struct StageTimes {
+    StageTimes() { for(int i = 0; i < STAGE_COUNT; i++) ns[i] = 0; }
+    qint64 ns[STAGE_COUNT];
+};
+
+static void run_size(int len, int iterations, unsigned int seed,
+                     const QString &pathLossFile, const QString &limitFile,
+                     StageTimes &times)
+{
+    SweepSettings ss;
+    ss.setCenter(BENCH_CENTER);
+    ss.setSpan(BENCH_SPAN);
+
+    Trace source, work;
+    build_trace(source, ss, len, seed);
+
+    PathLossTable pathLoss;
+    pathLoss.Import(pathLossFile);
+    LimitLineTable limitLine;
+    limitLine.Import(limitFile);
+    CorrectionStage corrections;
+
+    // One trace of each type, the sixth a second normal trace
+    TraceType types[TRACE_COUNT] = { NORMAL, MAX_HOLD, MIN_HOLD, MIN_AND_MAX, AVERAGE, NORMAL };
+    Trace traces[TRACE_COUNT];
+    for(int i = 0; i < TRACE_COUNT; i++) {
+        traces[i].SetType(types[i]);
+    }
+
+    TraceManager manager;
+    for(int i = 0; i < TRACE_COUNT; i++) {
+        manager.setActiveIndex(i);
+        manager.setType(types[i]);
+        manager.setUpdate(true);
+    }
+    manager.setRefOffset(1.0);
+    manager.SetChannelPower(true, BENCH_SPAN / 20.0, BENCH_SPAN / 10.0);
+    manager.SetOccupiedBandwidth(true, 99.0);
+
+    ChannelPower channelPower;
+    channelPower.Configure(true, BENCH_SPAN / 20.0, BENCH_SPAN / 10.0);
+    OccupiedBandwidthInfo ocbw;
+    ocbw.enabled = true;
+    Persistence persistence;
+    SpectralDensity density;
+    density.Configure(true, 0, 512, -130.0, 0.0, 0, 0);
+    GLVector normalized;
+
+    QElapsedTimer timer;
+    double peak_freq, peak_amp;
+    std::vector<int> peaks;
+    std::vector<float> linear(len);
+
+    // Real-time frame sized as the BB60 1024x256 frames, sparse hits
+    std::vector<float> rtAlpha(1024 * 256, 0.0f);
+    std::vector<unsigned char> rtRgba(rtAlpha.size() * 4);
+    for(size_t i = 0; i < rtAlpha.size(); i += 7) {
+        rtAlpha[i] = (float)(i % 100) / 50.0f;
+    }
+
+    // The first iteration warms caches and allocations, not timed
+    for(int iter = 0; iter <= iterations; iter++) {
+        StageTimes local;
+
+        work.Copy(source);
+        work.SetSettings(*source.GetSettings());
+        work.SetUpdateRange(0, len);
+
+        timer.start();
+        work.ApplyOffset((iter & 1) ? 1.0 : -1.0);
+        local.ns[StageRefOffset] = timer.nsecsElapsed();
+
+        timer.start();
+        pathLoss.Apply(&work);
+        local.ns[StagePathLoss] = timer.nsecsElapsed();
+
+        // Linear scale display conversion, on a copy
+        std::copy(work.Max(), work.Max() + len, linear.begin());
+        timer.start();
+        bb_lib::dbm_to_mv(&linear[0], len);
+        local.ns[StageDbmToMv] = timer.nsecsElapsed();
+
+        timer.start();
+        work.GetSignalPeak(&peak_freq, &peak_amp);
+        local.ns[StageSignalPeak] = timer.nsecsElapsed();
+
+        // Reuses the stats computed for the peak, builds the peak table
+        timer.start();
+        work.GetPeakList(peaks);
+        local.ns[StagePeakList] = timer.nsecsElapsed();
+
+        // Marker peak right from the first bin to the last peak
+        timer.start();
+        for(int ix = work.NextPeakRight(-1); ix >= 0; ix = work.NextPeakRight(ix)) {
+        }
+        local.ns[StagePeakHop] = timer.nsecsElapsed();
+
+        timer.start();
+        limitLine.Apply(&work);
+        local.ns[StageLimitLine] = timer.nsecsElapsed();
+
+        // The three stages above in one pass
+        timer.start();
+        corrections.Apply(&work, (iter & 1) ? 1.0 : -1.0, pathLoss, limitLine);
+        local.ns[StageCorrections] = timer.nsecsElapsed();
+
+        timer.start();
+        for(int i = 0; i < TRACE_COUNT; i++) {
+            traces[i].Update(work);
+        }
+        local.ns[StageTraceUpdate] = timer.nsecsElapsed();
+
+        timer.start();
+        Trace::UpdateAll(traces, TRACE_COUNT, work);
+        local.ns[StageTraceUpdateFused] = timer.nsecsElapsed();
+
+        timer.start();
+        normalize_trace(&work, normalized, QPoint(1280, 720));
+        local.ns[StageNormalize] = timer.nsecsElapsed();
+
+        timer.start();
+        persistence.Accumulate(&work);
+        // Includes the worker drawing the sweep
+        persistence.Flush();
+        local.ns[StagePersistence] = timer.nsecsElapsed();
+
+        timer.start();
+        density.Accumulate(&work);
+        local.ns[StageDensity] = timer.nsecsElapsed();
+
+        timer.start();
+        simdIntensityToRgba_32f(&rtAlpha[0], &rtRgba[0], (int)rtAlpha.size());
+        local.ns[StageRealTimeRgba] = timer.nsecsElapsed();
+
+        timer.start();
+        channelPower.Update(&work);
+        local.ns[StageChannelPower] = timer.nsecsElapsed();
+
+        timer.start();
+        work.GetOccupiedBandwidth(ocbw);
+        local.ns[StageOccupiedBW] = timer.nsecsElapsed();
+
+        work.Copy(source);
+        work.SetSettings(*source.GetSettings());
+        work.SetUpdateRange(0, len);
+
+        timer.start();
+        manager.UpdateTraces(&work);
+        local.ns[StageUpdateTraces] = timer.nsecsElapsed();
+
+        if(iter > 0) {
+            for(int i = 0; i < STAGE_COUNT; i++) {
+                times.ns[i] += local.ns[i];
+            }
+        }
+    }
+}
+
+static QList<int> parse_sizes(const QString &arg)
+{
+    QList<int> sizes;
+    foreach(const QString &s, arg.split(',', QString::SkipEmptyParts)) {
+        bool ok;
+        int n = s.trimmed().toInt(&ok);
+        if(ok && n >= 16) sizes.push_back(n);
+    }
+    return sizes;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QList<int> sizes;
+    for(int n = 1024; n <= 4 * 1024 * 1024; n *= 4) {
+        sizes.push_back(n);
+    }
+    qint64 binsPerSize = 64 * 1024 * 1024;
+    unsigned int seed = 1;
+    QString csvPath;
+
+    QStringList args = app.arguments();
+    for(int i = 1; i < args.size(); i++) {
+        if(args[i] == "--sizes" && i + 1 < args.size()) {
+            sizes = parse_sizes(args[++i]);
+        } else if(args[i] == "--bins-per-size" && i + 1 < args.size()) {
+            binsPerSize = args[++i].toLongLong();
+        } else if(args[i] == "--seed" && i + 1 < args.size()) {
+            seed = args[++i].toUInt();
+        } else if(args[i] == "--csv" && i + 1 < args.size()) {
+            csvPath = args[++i];
+        } else {
+            fprintf(stderr, "Usage: BBAppBench [--sizes n,n,...] [--bins-per-size n] "
+                    "[--seed n] [--csv file]\n");
+            return 1;
+        }
+    }
+
+    if(sizes.empty() || binsPerSize <= 0) {
+        fprintf(stderr, "No sizes to run\n");
+        return 1;
+    }
+
+    // Small path-loss correction, limits wide enough that every bin is tested
+    QTemporaryFile pathLossFile, limitFile;
+    if(!write_table(pathLossFile, 2.0, 2.0) || !write_table(limitFile, -200.0, 50.0)) {
+        fprintf(stderr, "Unable to create temporary import tables\n");
+        return 1;
+    }
+
+    QFile csv(csvPath);
+    QTextStream csvOut;
+    if(!csvPath.isEmpty()) {
+        if(!csv.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            fprintf(stderr, "Unable to open %s\n", qPrintable(csvPath));
+            return 1;
+        }
+        csvOut.setDevice(&csv);
+        csvOut << "bins,iterations,stage,ns_per_bin,mbins_per_sec\n";
+    }
+
+    printf("SIMD kernels: %s\n", simdLevelName(simdLevel()));
+    printf("%10s %6s  %-26s %10s %12s\n", "bins", "iters", "stage", "ns/bin", "Mbins/sec");
+
+    foreach(int len, sizes) {
+        int iterations = (int)bb_lib::max2(binsPerSize / len, (qint64)3);
+        iterations = bb_lib::min2(iterations, 10000);
+
+        StageTimes times;
+        run_size(len, iterations, seed, pathLossFile.fileName(), limitFile.fileName(), times);
+
+        double bins = (double)len * iterations;
+        for(int i = 0; i < STAGE_COUNT; i++) {
+            double nsPerBin = times.ns[i] / bins;
+            double mbinsPerSec = (nsPerBin > 0.0) ? (1.0e3 / nsPerBin) : 0.0;
+            printf("%10d %6d  %-26s %10.3f %12.1f\n", len, iterations,
+                   stage_names[i], nsPerBin, mbinsPerSec);
+            if(csvOut.device()) {
+                csvOut << len << "," << iterations << "," << stage_names[i] << ","
+                       << nsPerBin << "," << mbinsPerSec << "\n";
+            }
+        }
+        printf("\n");
+        fflush(stdout);
+    }
+
+    return 0;
+}
@@ -790,6 +790,19 @@ double bb_lib::sa44a_get_best_rbw(const SweepSettings *ss)
     return rbw;
 }
 
+static double unit_clamp(double v)
+{
+    return bb_lib::min2(bb_lib::max2(v, 0.0), 1.0);
+}
+
+void bb_lib::persistence_color(double l, unsigned char *rgb)
+{
+    double mg = unit_clamp(4.0 * l - 3.0);
+    rgb[0] = (unsigned char)(255.0 * unit_clamp((l - 0.5) * 4.0) + 0.5);
+    rgb[1] = (unsigned char)(255.0 * (unit_clamp(4.0 * l) - mg) + 0.5);
+    rgb[2] = (unsigned char)(255.0 * unit_clamp((0.5 - l) * 4.0) + 0.5);
+}
+
 // Get Users MyDocuments path, append application directory
 QString bb_lib::get_my_documents_path()
 {
@@ -901,8 +914,72 @@ void normalize_trace(const Trace *t,
                      Amplitude refLevel,
                      double dBdiv)
 {
-    normalize_trace(t->Min(), t->Max(), t->Length(), v,
-                    grat_size, refLevel, dBdiv);
+    normalize_trace(t, 0, t->Length(), v, grat_size, refLevel, dBdiv);
+}
+
+// Same output as the buffer version over bins [first, last), pixel
+//   min/max are read from the trace pyramid, O(pixels * log(bins))
+void normalize_trace(const Trace *t,
+                     int first,
+                     int last,
+                     GLVector &v,
+                     QPoint grat_size,
+                     Amplitude refLevel,
+                     double dBdiv)
+{
+    int length = last - first;
+
+    // Less samples than pixels, nothing to reduce
+    if(length < grat_size.x()) {
+        normalize_trace(t->Min() + first, t->Max() + first, bb_lib::max2(length, 0),
+                        v, grat_size, refLevel, dBdiv);
+        return;
+    }
+
+    v.clear();
+
+    double step = (float)(grat_size.x()) / ( length - 1 );   // Step size
+    double ref;                       // Value representing the top of graticule
+    double botRef;                    // Value representing bottom of graticule
+    double xScale = 1.0 / (double)grat_size.x();
+    double yScale;
+
+    if(refLevel.IsLogScale()) {
+        ref = refLevel.ConvertToUnits(AmpUnits::DBM);
+        botRef = ref - 10.0 * dBdiv;
+        yScale = 1.0 / (10.0 * dBdiv);
+    } else {
+        ref = refLevel.Val();
+        botRef = 0.0;
+        yScale = (1.0 / ref);
+    }
+
+    v.reserve(grat_size.x() * 4);
+
+    // Pixel p ends at the first bin past the previous pixel where
+    //   (bin + 1) * step > p, as the bin by bin walk places them
+    int begin = 0;
+    for(int currentPix = 0; begin < length; currentPix++) {
+        int end = bb_lib::max2(begin, (int)(currentPix / step));
+        while(end < length && (end + 1) * step <= currentPix) {
+            end++;
+        }
+        if(end >= length) {
+            break;
+        }
+
+        float min, max;
+        t->GetMinMax(first + begin, first + end + 1, &min, &max);
+        if(!(min < (float)ref)) min = ref;
+        if(!(max > (float)botRef)) max = botRef;
+
+        v.push_back(xScale * currentPix);
+        v.push_back(yScale * (min - botRef));
+        v.push_back(xScale * currentPix);
+        v.push_back(yScale * (max - botRef));
+
+        begin = end + 1;
+    }
 }
 
 //// Normalize frequency domain trace
@@ -1217,8 +1294,8 @@ void demod_am(const complex_f *src, float *dst, int len)
 {
     for(int i = 0; i < len; i++) {
         dst[i] = src[i].re * src[i].re + src[i].im * src[i].im;
-        dst[i] = 10.0 * log10(dst[i]);
     }
+    simdLinToDb_32f(dst, dst, len, 10.0, 0.0);
 
     // if(linScale), convert to milliVolts?
 //    for(int i = 0; i < len; i++) {
@@ -24,6 +24,7 @@
 #include "kiss_fft/kissfft.hh"
 
 #include "lib/device_traits.h"
+#include "lib/simd_kernels.h"
 
 class Trace;
 
@@ -227,14 +228,17 @@ inline void sphereToCart(float theta, float phi, float rho,
     *z = rho*cos(phi);
 }
 
+// Cache line alignment, also covers AVX loads
+static const int SIMD_ALIGNMENT = 64;
+
 inline float* simdMalloc_32f(int len)
 {
-    return (float*)_aligned_malloc(len * sizeof(float), 32);
+    return (float*)_aligned_malloc(len * sizeof(float), SIMD_ALIGNMENT);
 }
 
 inline complex_f* simdMalloc_32fc(int len)
 {
-    return (complex_f*)_aligned_malloc(len * sizeof(complex_f), 32);
+    return (complex_f*)_aligned_malloc(len * sizeof(complex_f), SIMD_ALIGNMENT);
 }
 
 inline void simdFree(void *ptr)
@@ -375,16 +379,12 @@ inline _Type lerp(_Type a, _Type b, float p) {
 // dB to linear voltage correction
 // Used for path-loss corrections
 inline void db_to_lin(float *srcDst, int len) {
-    for(int i = 0; i < len; i++) {
-        srcDst[i] = pow(10, srcDst[i] * 0.05);
-    }
+    simdDbToLin_32f(srcDst, srcDst, len, 0.05, 0.0);
 }
 
 // Convert dBm value to mV
 inline void dbm_to_mv(float *srcDst, int len) {
-    for(int i = 0; i < len; i++) {
-        srcDst[i] = pow(10,(srcDst[i] + 46.9897) * 0.05);
-    }
+    simdDbToLin_32f(srcDst, srcDst, len, 0.05, 46.9897);
 }
 
 // a ^ n
@@ -433,6 +433,10 @@ inline double frac_between(double start, double stop, double f) {
     return (f - start) / (stop - start);
 }
 
+// Persistence/density colormap, blue -> green -> red -> magenta for
+//   l in [0.0, 1.0], matches persist_fs, rgb[3]
+void persistence_color(double l, unsigned char *rgb);
+
 // Get the closest index representative of the bw parameter
 int get_native_bw_index(double bw);
 // Get next bandwidth in sequence
@@ -552,6 +556,9 @@ bool isOpenGLCompatible();
 void normalize_trace(const Trace *t, GLVector &vector, QPoint grat_size);
 void normalize_trace(const Trace *t, GLVector &vector, QPoint grat_size,
                      Amplitude refLevel, double div);
+// Bins [first, last) of the trace across the graticule
+void normalize_trace(const Trace *t, int first, int last, GLVector &vector,
+                     QPoint grat_size, Amplitude refLevel, double div);
 void normalize_trace(const float *sweepMin, const float *sweepMax,
                      int length, GLVector &v, QPoint grat_size,
                      Amplitude refLevel, double dBdiv);
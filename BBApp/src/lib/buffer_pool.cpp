@@ -0,0 +1,91 @@
+#include "buffer_pool.h"
+#include "bb_lib.h"
+
+// Smallest class 2^10 floats, 4kB
+static const int MIN_SIZE_CLASS = 10;
+static const int SIZE_CLASS_COUNT = 31;
+// Buffers kept per class, more are freed on release
+static const int MAX_CACHED_PER_CLASS = 16;
+// Total kept across all classes, 128 MiB, a few large sweeps
+//   can not pin the cache at its per class limit
+static const long long MAX_CACHED_BYTES = 128LL * 1024 * 1024;
+
+BufferPool& BufferPool::Instance()
+{
+    static BufferPool pool;
+    return pool;
+}
+
+BufferPool::BufferPool() :
+    cache(SIZE_CLASS_COUNT),
+    cachedBytes(0)
+{
+
+}
+
+BufferPool::~BufferPool()
+{
+    Trim();
+}
+
+int BufferPool::SizeClass(int len)
+{
+    int k = MIN_SIZE_CLASS;
+    while(k < SIZE_CLASS_COUNT - 1 && (1 << k) < len) {
+        k++;
+    }
+    return k;
+}
+
+long long BufferPool::ClassBytes(int k)
+{
+    return (long long)sizeof(float) << k;
+}
+
+float* BufferPool::Acquire(int len, int *capacity)
+{
+    int k = SizeClass(len);
+    *capacity = 1 << k;
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if(!cache[k].empty()) {
+            float *buf = cache[k].back();
+            cache[k].pop_back();
+            cachedBytes -= ClassBytes(k);
+            return buf;
+        }
+    }
+
+    return simdMalloc_32f(*capacity);
+}
+
+void BufferPool::Release(float *buf, int capacity)
+{
+    if(!buf) return;
+
+    int k = SizeClass(capacity);
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if((int)cache[k].size() < MAX_CACHED_PER_CLASS &&
+                cachedBytes + ClassBytes(k) <= MAX_CACHED_BYTES) {
+            cache[k].push_back(buf);
+            cachedBytes += ClassBytes(k);
+            return;
+        }
+    }
+
+    simdFree(buf);
+}
+
+void BufferPool::Trim()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    for(size_t k = 0; k < cache.size(); k++) {
+        for(size_t i = 0; i < cache[k].size(); i++) {
+            simdFree(cache[k][i]);
+        }
+        cache[k].clear();
+    }
+    cachedBytes = 0;
+}
@@ -0,0 +1,45 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <mutex>
+#include <vector>
+
+#include "macros.h"
+
+/*
+ * Process wide cache of aligned float buffers in power of two size
+ *   classes, from simdMalloc_32f()
+ * Buffers of a released class are handed to the next request of the
+ *   same class, so traces that change size between modes and spans
+ *   reuse the same few allocations.
+ * The cache is bounded in total bytes, releases past the bound are freed.
+ */
+class BufferPool {
+public:
+    static BufferPool& Instance();
+
+    // Returns a buffer of at least len floats, *capacity is the size
+    //   class the buffer belongs to
+    float* Acquire(int len, int *capacity);
+    // buf and capacity from Acquire(), buf may be null
+    void Release(float *buf, int capacity);
+    // Free every cached buffer
+    void Trim();
+
+private:
+    BufferPool();
+    ~BufferPool();
+
+    static int SizeClass(int len);
+    static long long ClassBytes(int k);
+
+    std::mutex mtx;
+    // Cached buffers of 2^k floats for each class k
+    std::vector<std::vector<float*> > cache;
+    long long cachedBytes; // Sum over every cached buffer
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(BufferPool)
+};
+
+#endif // BUFFER_POOL_H
@@ -0,0 +1,96 @@
+#include "minmax_pyramid.h"
+
+static inline float min_of(float a, float b) { return (b < a) ? b : a; }
+static inline float max_of(float a, float b) { return (b > a) ? b : a; }
+
+MinMaxPyramid::MinMaxPyramid() :
+    length(0)
+{
+
+}
+
+MinMaxPyramid::~MinMaxPyramid()
+{
+
+}
+
+void MinMaxPyramid::Clear()
+{
+    length = 0;
+    levelMin.clear();
+    levelMax.clear();
+}
+
+// Only whole blocks are stored, level k has len >> (k + 1) entries
+void MinMaxPyramid::Update(const float *srcMin, const float *srcMax,
+                           int len, int start, int stop)
+{
+    if(len != length) {
+        length = len;
+        levelMin.clear();
+        levelMax.clear();
+        for(int k = 0; (len >> (k + 1)) > 0; k++) {
+            levelMin.push_back(std::vector<float>(len >> (k + 1)));
+            levelMax.push_back(std::vector<float>(len >> (k + 1)));
+        }
+        start = 0;
+        stop = len;
+    }
+
+    if(start < 0) start = 0;
+    if(stop > len) stop = len;
+
+    for(int k = 0; k < (int)levelMin.size() && start < stop; k++) {
+        const float *childMin = (k == 0) ? srcMin : &levelMin[k - 1][0];
+        const float *childMax = (k == 0) ? srcMax : &levelMax[k - 1][0];
+        float *dstMin = &levelMin[k][0];
+        float *dstMax = &levelMax[k][0];
+
+        int first = start >> (k + 1);
+        int last = (stop - 1) >> (k + 1);
+        if(last >= (int)levelMin[k].size()) {
+            last = (int)levelMin[k].size() - 1;
+        }
+
+        for(int j = first; j <= last; j++) {
+            dstMin[j] = min_of(childMin[2 * j], childMin[2 * j + 1]);
+            dstMax[j] = max_of(childMax[2 * j], childMax[2 * j + 1]);
+        }
+    }
+}
+
+// Climbs to the largest aligned block that fits, then steps back down
+//   through the levels for the remainder of the range
+void MinMaxPyramid::Query(const float *srcMin, const float *srcMax, int start, int stop,
+                          float *min, float *max) const
+{
+    float mn = srcMin[start];
+    float mx = srcMax[start];
+
+    int levels = levelMin.size();
+    int pos = start;
+    int level = 0; // Block size 1 << level, 0 is the source
+
+    while(pos < stop) {
+        while(level < levels && (pos & ((2 << level) - 1)) == 0 &&
+              pos + (2 << level) <= stop) {
+            level++;
+        }
+        while(pos + (1 << level) > stop) {
+            level--;
+        }
+
+        if(level == 0) {
+            mn = min_of(mn, srcMin[pos]);
+            mx = max_of(mx, srcMax[pos]);
+        } else {
+            mn = min_of(mn, levelMin[level - 1][pos >> level]);
+            mx = max_of(mx, levelMax[level - 1][pos >> level]);
+        }
+
+        pos += 1 << level;
+    }
+
+    *min = mn;
+    *max = mx;
+}
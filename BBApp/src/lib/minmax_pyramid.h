@@ -0,0 +1,40 @@
+#ifndef MINMAX_PYRAMID_H
+#define MINMAX_PYRAMID_H
+
+#include <vector>
+
+#include "macros.h"
+
+/*
+ * Min/max reduction of a pair of buffers in power of two blocks
+ * Level k holds the min of the min buffer and the max of the max buffer
+ *   over blocks of 2^(k+1) bins, the source buffers are level 0 and are
+ *   not copied, so they are passed to every call.
+ * A range query combines at most two blocks per level, O(log n)
+ *   regardless of the length of the range.
+ */
+class MinMaxPyramid {
+public:
+    MinMaxPyramid();
+    ~MinMaxPyramid();
+
+    // Rebuild the blocks covering [start, stop) after the source changed
+    //   there, a new length rebuilds everything
+    void Update(const float *srcMin, const float *srcMax, int len, int start, int stop);
+    void Clear();
+
+    int Length() const { return length; }
+
+    // Min of srcMin and max of srcMax over [start, stop), stop > start
+    void Query(const float *srcMin, const float *srcMax, int start, int stop,
+               float *min, float *max) const;
+
+private:
+    int length;
+    std::vector<std::vector<float> > levelMin, levelMax;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(MinMaxPyramid)
+};
+
+#endif // MINMAX_PYRAMID_H
@@ -0,0 +1,172 @@
+#include "perf_timer.h"
+
+#include <cmath>
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QTextStream>
+
+static const char *stage_names[PERF_STAGE_COUNT] = {
+    "Fetch",
+    "Reconfigure",
+    "Corrections",
+    "TraceUpdate",
+    "Record",
+    "Normalize",
+    "Persistence",
+    "Density",
+    "Markers",
+    "Demod",
+    "Paint"
+};
+
+PerfStats& PerfStats::Instance()
+{
+    static PerfStats stats;
+    return stats;
+}
+
+const char* PerfStats::StageName(PerfStage stage)
+{
+    return stage_names[stage];
+}
+
+PerfStats::PerfStats() :
+    enabled(false),
+    sweeps(0),
+    lastSweeps(0),
+    lastSnapshot(std::chrono::steady_clock::now())
+{
+    for(int s = 0; s < PERF_STAGE_COUNT; s++) {
+        for(int b = 0; b < PERF_BUCKET_COUNT; b++) {
+            buckets[s][b] = 0;
+            lastBuckets[s][b] = 0;
+        }
+    }
+}
+
+// Bucket 0 holds everything under 256ns, then 4 buckets per octave
+int PerfStats::BucketIndex(long long ns)
+{
+    if(ns < 256) {
+        return 0;
+    }
+
+    int exp;
+    double mantissa = frexp((double)ns, &exp); // [0.5, 1.0)
+    int index = (exp - 9) * 4 + (int)((mantissa - 0.5) * 8.0) + 1;
+    return (index < PERF_BUCKET_COUNT) ? index : PERF_BUCKET_COUNT - 1;
+}
+
+double PerfStats::BucketLimit(int index)
+{
+    if(index == 0) {
+        return 0.256;
+    }
+
+    int exp = (index - 1) / 4 + 9;
+    int sub = (index - 1) % 4;
+    return ldexp(0.5 + (sub + 1) / 8.0, exp) * 1.0e-3;
+}
+
+void PerfStats::Snapshot(PerfSnapshot &snapshot)
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    snapshot.seconds = std::chrono::duration<double>(now - lastSnapshot).count();
+    lastSnapshot = now;
+
+    unsigned int currentSweeps = sweeps.load(std::memory_order_relaxed);
+    unsigned int sweepDelta = currentSweeps - lastSweeps;
+    lastSweeps = currentSweeps;
+    snapshot.sweepsPerSec = (snapshot.seconds > 0.0) ? sweepDelta / snapshot.seconds : 0.0;
+
+    for(int s = 0; s < PERF_STAGE_COUNT; s++) {
+        unsigned int delta[PERF_BUCKET_COUNT];
+        long long total = 0;
+
+        for(int b = 0; b < PERF_BUCKET_COUNT; b++) {
+            unsigned int current = buckets[s][b].load(std::memory_order_relaxed);
+            delta[b] = current - lastBuckets[s][b];
+            lastBuckets[s][b] = current;
+            total += delta[b];
+        }
+
+        PerfStageStats &stats = snapshot.stages[s];
+        stats.count = total;
+        stats.p50us = stats.p99us = 0.0;
+        if(total == 0) {
+            continue;
+        }
+
+        long long p50 = (total + 1) / 2, p99 = (total * 99 + 99) / 100;
+        long long running = 0;
+        bool have50 = false;
+        for(int b = 0; b < PERF_BUCKET_COUNT; b++) {
+            running += delta[b];
+            if(!have50 && running >= p50) {
+                stats.p50us = BucketLimit(b);
+                have50 = true;
+            }
+            if(running >= p99) {
+                stats.p99us = BucketLimit(b);
+                break;
+            }
+        }
+    }
+}
+
+static QString format_us(double us)
+{
+    if(us >= 1000.0) {
+        return QString::number(us * 1.0e-3, 'f', 1) + "ms";
+    }
+    return QString::number(us, 'f', 0) + "us";
+}
+
+// Only stages that ran during the interval are listed
+QString PerfStats::Summary(const PerfSnapshot &snapshot)
+{
+    QString summary = QString::number(snapshot.sweepsPerSec, 'f', 1) + " sweeps/s";
+
+    for(int s = 0; s < PERF_STAGE_COUNT; s++) {
+        const PerfStageStats &stats = snapshot.stages[s];
+        if(stats.count == 0) {
+            continue;
+        }
+        summary += QString("  %1 %2/%3").arg(stage_names[s])
+                .arg(format_us(stats.p50us)).arg(format_us(stats.p99us));
+    }
+
+    return summary;
+}
+
+bool PerfStats::AppendCsv(const QString &path, const PerfSnapshot &snapshot, qint64 maxBytes)
+{
+    QFileInfo info(path);
+    if(info.exists() && info.size() > maxBytes) {
+        QFile::remove(path + ".1");
+        QFile::rename(path, path + ".1");
+    }
+
+    QFile file(path);
+    bool newFile = !file.exists();
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        return false;
+    }
+
+    QTextStream out(&file);
+    if(newFile) {
+        out << "time,seconds,sweeps_per_sec,stage,count,p50_us,p99_us\n";
+    }
+
+    QString time = QDateTime::currentDateTime().toString(Qt::ISODate);
+    for(int s = 0; s < PERF_STAGE_COUNT; s++) {
+        const PerfStageStats &stats = snapshot.stages[s];
+        out << time << "," << snapshot.seconds << "," << snapshot.sweepsPerSec << ","
+            << stage_names[s] << "," << stats.count << ","
+            << stats.p50us << "," << stats.p99us << "\n";
+    }
+
+    return true;
+}
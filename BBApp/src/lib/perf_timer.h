@@ -0,0 +1,119 @@
+#ifndef PERF_TIMER_H
+#define PERF_TIMER_H
+
+#include <atomic>
+#include <chrono>
+
+#include <QString>
+
+#include "macros.h"
+
+// Hot path stages timed across all acquisition loops and views
+enum PerfStage {
+    PerfFetch = 0,       // Device sweep/IQ/frame retrieval
+    PerfReconfigure,     // Device sweep reconfiguration
+    PerfCorrections,     // Offsets, path-loss and limit lines
+    PerfTraceUpdate,     // Trace type (max hold, average, ...) updates
+    PerfRecord,          // Sweep and IQ recording
+    PerfNormalize,       // Persist/waterfall trace normalization
+    PerfPersistence,     // Persistence accumulation
+    PerfDensity,         // Spectral density histogram
+    PerfMarkers,         // Marker solving
+    PerfDemod,           // IQ demodulation and receiver stats
+    PerfPaint,           // OpenGL paint of the active view
+    PERF_STAGE_COUNT
+};
+
+// Log spaced latency buckets, 4 per octave starting at 256ns
+static const int PERF_BUCKET_COUNT = 128;
+
+// Percentiles over the interval between two snapshots
+struct PerfStageStats {
+    long long count;
+    double p50us, p99us;
+};
+
+struct PerfSnapshot {
+    double seconds; // Length of the interval
+    double sweepsPerSec;
+    PerfStageStats stages[PERF_STAGE_COUNT];
+};
+
+/*
+ * Process wide lock-free latency histograms, one per stage
+ * Recording a sample is one relaxed atomic increment, completed sweeps
+ *   are counted separately with CountSweep()
+ * Histograms are cumulative, Snapshot() reports the delta since
+ *   the previous snapshot so no thread ever resets a counter
+ */
+class PerfStats {
+public:
+    static PerfStats& Instance();
+
+    static const char* StageName(PerfStage stage);
+
+    bool Enabled() const { return enabled.load(std::memory_order_relaxed); }
+    void SetEnabled(bool enable) { enabled = enable; }
+
+    void Record(PerfStage stage, long long ns) {
+        buckets[stage][BucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+    }
+    // Call once per completed sweep/capture of any acquisition loop
+    void CountSweep() {
+        sweeps.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Only call from a single thread, typically a GUI timer
+    void Snapshot(PerfSnapshot &snapshot);
+    // Single line summary for the status bar
+    static QString Summary(const PerfSnapshot &snapshot);
+    // Append one row per stage to a CSV file, the file is rolled
+    //   over to <path>.1 once it exceeds maxBytes
+    static bool AppendCsv(const QString &path, const PerfSnapshot &snapshot,
+                          qint64 maxBytes = 8 * 1024 * 1024);
+
+private:
+    PerfStats();
+
+    static int BucketIndex(long long ns);
+    // Upper bound of bucket in microseconds
+    static double BucketLimit(int index);
+
+    std::atomic<bool> enabled;
+    std::atomic<unsigned int> buckets[PERF_STAGE_COUNT][PERF_BUCKET_COUNT];
+    std::atomic<unsigned int> sweeps;
+
+    // Snapshot state, owned by the snapshot thread
+    unsigned int lastBuckets[PERF_STAGE_COUNT][PERF_BUCKET_COUNT];
+    unsigned int lastSweeps;
+    std::chrono::steady_clock::time_point lastSnapshot;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(PerfStats)
+};
+
+// Time the enclosing scope, does nothing when stats are disabled
+class PerfScope {
+public:
+    PerfScope(PerfStage s) : stage(s), active(PerfStats::Instance().Enabled()) {
+        if(active) start = std::chrono::steady_clock::now();
+    }
+    ~PerfScope() {
+        if(active) {
+            PerfStats::Instance().Record(stage,
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count());
+        }
+    }
+
+private:
+    PerfStage stage;
+    bool active;
+    std::chrono::steady_clock::time_point start;
+};
+
+#define PERF_SCOPE_CAT(a, b) a##b
+#define PERF_SCOPE_NAME(line) PERF_SCOPE_CAT(perf_scope_, line)
+#define PERF_SCOPE(stage) PerfScope PERF_SCOPE_NAME(__LINE__)(stage)
+
+#endif // PERF_TIMER_H
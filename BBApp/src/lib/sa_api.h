@@ -1,10 +1,14 @@
 #ifndef __SA_API_H__
 #define __SA_API_H__
 
-#ifdef SA_EXPORTS
-#define SA_API __declspec(dllexport)
-#else
-#define SA_API __declspec(dllimport)
+#if defined(_WIN32) || defined(_WIN64)
+    #ifdef SA_EXPORTS
+        #define SA_API __declspec(dllexport)
+    #else
+        #define SA_API __declspec(dllimport)
+    #endif
+#else // Linux
+    #define SA_API
 #endif
 
 #define SA_MAX_DEVICES 8
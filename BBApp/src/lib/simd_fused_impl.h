@@ -0,0 +1,176 @@
+// Fused trace update kernels
+// No include guard, simd_kernels.cpp includes this once per instruction
+//   set inside a namespace that defines Vec, the scalar tail uses VecScalar
+
+// Per bin update of one target, mn/mx are the input min/max
+template<class V, int Op>
+struct TraceOp;
+
+template<class V>
+struct TraceOp<V, SimdTraceCopy> {
+    static inline void Apply(const SimdTraceTarget &t, int i,
+                             typename V::T mn, typename V::T mx) {
+        V::store(t.min + i, mn);
+        V::store(t.max + i, mx);
+    }
+};
+
+template<class V>
+struct TraceOp<V, SimdTraceMaxHold> {
+    static inline void Apply(const SimdTraceTarget &t, int i,
+                             typename V::T, typename V::T mx) {
+        typename V::T m = V::max(V::load(t.max + i), mx);
+        V::store(t.max + i, m);
+        V::store(t.min + i, m);
+    }
+};
+
+template<class V>
+struct TraceOp<V, SimdTraceMinHold> {
+    static inline void Apply(const SimdTraceTarget &t, int i,
+                             typename V::T mn, typename V::T) {
+        typename V::T m = V::min(V::load(t.min + i), mn);
+        V::store(t.min + i, m);
+        V::store(t.max + i, m);
+    }
+};
+
+template<class V>
+struct TraceOp<V, SimdTraceMinMax> {
+    static inline void Apply(const SimdTraceTarget &t, int i,
+                             typename V::T mn, typename V::T mx) {
+        V::store(t.min + i, V::min(V::load(t.min + i), mn));
+        V::store(t.max + i, V::max(V::load(t.max + i), mx));
+    }
+};
+
+template<class V>
+struct TraceOp<V, SimdTraceAverage> {
+    static inline void Apply(const SimdTraceTarget &t, int i,
+                             typename V::T mn, typename V::T mx) {
+        typename V::T keep = V::set1(t.keep), add = V::set1(t.add);
+        V::store(t.min + i, V::add(V::mul(V::load(t.min + i), keep), V::mul(mn, add)));
+        V::store(t.max + i, V::add(V::mul(V::load(t.max + i), keep), V::mul(mx, add)));
+    }
+};
+
+// Placeholder for unused slots of a specialized kernel
+template<class V>
+struct TraceOp<V, SimdTraceNone> {
+    static inline void Apply(const SimdTraceTarget&, int, typename V::T, typename V::T) {}
+};
+
+template<class V>
+static inline void apply_op(const SimdTraceTarget &t, int i,
+                            typename V::T mn, typename V::T mx)
+{
+    switch(t.op) {
+    case SimdTraceCopy: TraceOp<V, SimdTraceCopy>::Apply(t, i, mn, mx); break;
+    case SimdTraceMaxHold: TraceOp<V, SimdTraceMaxHold>::Apply(t, i, mn, mx); break;
+    case SimdTraceMinHold: TraceOp<V, SimdTraceMinHold>::Apply(t, i, mn, mx); break;
+    case SimdTraceMinMax: TraceOp<V, SimdTraceMinMax>::Apply(t, i, mn, mx); break;
+    case SimdTraceAverage: TraceOp<V, SimdTraceAverage>::Apply(t, i, mn, mx); break;
+    default: break;
+    }
+}
+
+// Up to three targets with the operations fixed at compile time
+template<int Op0, int Op1, int Op2>
+static void fused_specialized(const float *srcMin, const float *srcMax,
+                              const SimdTraceTarget *t, int len)
+{
+    int i = 0;
+    for(; i + Vec::W <= len; i += Vec::W) {
+        Vec::T mn = Vec::load(srcMin + i), mx = Vec::load(srcMax + i);
+        TraceOp<Vec, Op0>::Apply(t[0], i, mn, mx);
+        TraceOp<Vec, Op1>::Apply(t[1], i, mn, mx);
+        TraceOp<Vec, Op2>::Apply(t[2], i, mn, mx);
+    }
+    for(; i < len; i++) {
+        float mn = srcMin[i], mx = srcMax[i];
+        TraceOp<VecScalar, Op0>::Apply(t[0], i, mn, mx);
+        TraceOp<VecScalar, Op1>::Apply(t[1], i, mn, mx);
+        TraceOp<VecScalar, Op2>::Apply(t[2], i, mn, mx);
+    }
+}
+
+// Any combination, the operation is chosen per target per vector
+static void fused_generic(const float *srcMin, const float *srcMax,
+                          const SimdTraceTarget *t, int count, int len)
+{
+    int i = 0;
+    for(; i + Vec::W <= len; i += Vec::W) {
+        Vec::T mn = Vec::load(srcMin + i), mx = Vec::load(srcMax + i);
+        for(int k = 0; k < count; k++) {
+            apply_op<Vec>(t[k], i, mn, mx);
+        }
+    }
+    for(; i < len; i++) {
+        float mn = srcMin[i], mx = srcMax[i];
+        for(int k = 0; k < count; k++) {
+            apply_op<VecScalar>(t[k], i, mn, mx);
+        }
+    }
+}
+
+#define FUSED_OPS(a, b, c) (((a) << 8) | ((b) << 4) | (c))
+
+// Targets are sorted by operation, unused slots are SimdTraceNone
+static void fused_update(const float *srcMin, const float *srcMax,
+                         const SimdTraceTarget *t, int count, int len)
+{
+    if(count > 3) {
+        fused_generic(srcMin, srcMax, t, count, len);
+        return;
+    }
+
+    switch(FUSED_OPS(t[0].op, t[1].op, t[2].op)) {
+    // A single active trace
+    case FUSED_OPS(SimdTraceCopy, SimdTraceNone, SimdTraceNone):
+        fused_specialized<SimdTraceCopy, SimdTraceNone, SimdTraceNone>(srcMin, srcMax, t, len);
+        break;
+    case FUSED_OPS(SimdTraceMaxHold, SimdTraceNone, SimdTraceNone):
+        fused_specialized<SimdTraceMaxHold, SimdTraceNone, SimdTraceNone>(srcMin, srcMax, t, len);
+        break;
+    case FUSED_OPS(SimdTraceMinHold, SimdTraceNone, SimdTraceNone):
+        fused_specialized<SimdTraceMinHold, SimdTraceNone, SimdTraceNone>(srcMin, srcMax, t, len);
+        break;
+    case FUSED_OPS(SimdTraceMinMax, SimdTraceNone, SimdTraceNone):
+        fused_specialized<SimdTraceMinMax, SimdTraceNone, SimdTraceNone>(srcMin, srcMax, t, len);
+        break;
+    case FUSED_OPS(SimdTraceAverage, SimdTraceNone, SimdTraceNone):
+        fused_specialized<SimdTraceAverage, SimdTraceNone, SimdTraceNone>(srcMin, srcMax, t, len);
+        break;
+    // Live trace with one hold/average trace
+    case FUSED_OPS(SimdTraceCopy, SimdTraceMaxHold, SimdTraceNone):
+        fused_specialized<SimdTraceCopy, SimdTraceMaxHold, SimdTraceNone>(srcMin, srcMax, t, len);
+        break;
+    case FUSED_OPS(SimdTraceCopy, SimdTraceMinHold, SimdTraceNone):
+        fused_specialized<SimdTraceCopy, SimdTraceMinHold, SimdTraceNone>(srcMin, srcMax, t, len);
+        break;
+    case FUSED_OPS(SimdTraceCopy, SimdTraceMinMax, SimdTraceNone):
+        fused_specialized<SimdTraceCopy, SimdTraceMinMax, SimdTraceNone>(srcMin, srcMax, t, len);
+        break;
+    case FUSED_OPS(SimdTraceCopy, SimdTraceAverage, SimdTraceNone):
+        fused_specialized<SimdTraceCopy, SimdTraceAverage, SimdTraceNone>(srcMin, srcMax, t, len);
+        break;
+    case FUSED_OPS(SimdTraceMaxHold, SimdTraceAverage, SimdTraceNone):
+        fused_specialized<SimdTraceMaxHold, SimdTraceAverage, SimdTraceNone>(srcMin, srcMax, t, len);
+        break;
+    case FUSED_OPS(SimdTraceMaxHold, SimdTraceMinHold, SimdTraceNone):
+        fused_specialized<SimdTraceMaxHold, SimdTraceMinHold, SimdTraceNone>(srcMin, srcMax, t, len);
+        break;
+    // Live, hold and average, the usual monitoring setup
+    case FUSED_OPS(SimdTraceCopy, SimdTraceMaxHold, SimdTraceAverage):
+        fused_specialized<SimdTraceCopy, SimdTraceMaxHold, SimdTraceAverage>(srcMin, srcMax, t, len);
+        break;
+    case FUSED_OPS(SimdTraceCopy, SimdTraceMaxHold, SimdTraceMinHold):
+        fused_specialized<SimdTraceCopy, SimdTraceMaxHold, SimdTraceMinHold>(srcMin, srcMax, t, len);
+        break;
+    default:
+        fused_generic(srcMin, srcMax, t, count, len);
+        break;
+    }
+}
+
+#undef FUSED_OPS
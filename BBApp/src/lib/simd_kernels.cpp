@@ -0,0 +1,1133 @@
+#include "simd_kernels.h"
+
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// GCC/Clang only emit instructions for the targets enabled per function,
+//   MSVC accepts any intrinsic
+#if defined(SIMD_X86) && defined(__GNUC__)
+#define SIMD_TARGET_SSE2 __attribute__((target("sse2")))
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SIMD_TARGET_SSE2
+#define SIMD_TARGET_AVX2
+#endif
+
+// Running state of the stats kernels, sums are relative to the first
+//   value to limit cancellation in the variance
+struct StatsAccum {
+    float max;
+    int maxIndex;
+    float min;
+    double shift;
+    double sum, sumSq;
+};
+
+// dst = 10^((src + offset) * scale), scale > 0
+// The vector levels compute 2^(x * k) as 2^n * 2^f, see exp_params()
+struct ExpParams {
+    double scale, offset; // Scalar level
+    float k; // scale * log2(10)
+    float cHi, cLo; // 1 / k split so n * cHi is exact
+    float offsetF;
+    float xMin, xMax; // Keeps 2^n a normal float
+};
+
+// dst = scale * log10(src) + offset
+struct LogParams {
+    double scale, offset; // Scalar level
+    float lnScale; // scale / ln(10)
+    float offsetF;
+};
+
+struct SimdKernels {
+    void (*max)(const float*, float*, int);
+    void (*min)(const float*, float*, int);
+    void (*maxHold)(const float*, float*, float*, int);
+    void (*minHold)(const float*, float*, float*, int);
+    void (*average)(const float*, float*, float, float, int);
+    void (*addC)(float, float*, int);
+    void (*fusedTrace)(const float*, const float*, const SimdTraceTarget*, int, int);
+    void (*stats)(const float*, int, StatsAccum*);
+    void (*cumulativePower)(const float*, double*, int, const ExpParams*);
+    void (*dbToLin)(const float*, float*, int, const ExpParams*);
+    void (*linToDb)(const float*, float*, int, const LogParams*);
+    bool (*correctLimit)(float*, float*, const float*, bool, const float*, const float*,
+                         float*, int);
+    void (*intensityToRgba)(const float*, unsigned char*, int);
+};
+
+// Vector abstractions for the fused kernels
+struct VecScalar {
+    typedef float T;
+    enum { W = 1 };
+    static inline T load(const float *p) { return *p; }
+    static inline void store(float *p, T v) { *p = v; }
+    static inline T max(T a, T b) { return (a > b) ? a : b; }
+    static inline T min(T a, T b) { return (a < b) ? a : b; }
+    static inline T mul(T a, T b) { return a * b; }
+    static inline T add(T a, T b) { return a + b; }
+    static inline T set1(float f) { return f; }
+};
+
+namespace simd_scalar {
+typedef VecScalar Vec;
+#include "simd_fused_impl.h"
+}
+
+/*
+ * Scalar, also finishes the tail of the vector kernels
+ * max/min match bb_lib::max2/min2 operand order, which is also the
+ *   order _mm_max_ps/_mm_min_ps resolve NaNs in
+ */
+static void max_scalar(const float *src, float *srcDst, int len)
+{
+    for(int i = 0; i < len; i++) {
+        srcDst[i] = (srcDst[i] > src[i]) ? srcDst[i] : src[i];
+    }
+}
+
+static void min_scalar(const float *src, float *srcDst, int len)
+{
+    for(int i = 0; i < len; i++) {
+        srcDst[i] = (srcDst[i] < src[i]) ? srcDst[i] : src[i];
+    }
+}
+
+static void max_hold_scalar(const float *src, float *hold, float *copy, int len)
+{
+    for(int i = 0; i < len; i++) {
+        copy[i] = hold[i] = (hold[i] > src[i]) ? hold[i] : src[i];
+    }
+}
+
+static void min_hold_scalar(const float *src, float *hold, float *copy, int len)
+{
+    for(int i = 0; i < len; i++) {
+        copy[i] = hold[i] = (hold[i] < src[i]) ? hold[i] : src[i];
+    }
+}
+
+static void average_scalar(const float *src, float *srcDst, float keep, float add, int len)
+{
+    for(int i = 0; i < len; i++) {
+        srcDst[i] = srcDst[i] * keep + src[i] * add;
+    }
+}
+
+static void add_c_scalar(float value, float *srcDst, int len)
+{
+    for(int i = 0; i < len; i++) {
+        srcDst[i] += value;
+    }
+}
+
+// Continues the accumulation from index begin
+// Strict compares keep the first index of the max and skip NaNs
+static void stats_scalar_from(const float *src, int begin, int len, StatsAccum *a)
+{
+    for(int i = begin; i < len; i++) {
+        float v = src[i];
+        if(v > a->max) {
+            a->max = v;
+            a->maxIndex = i;
+        }
+        if(v < a->min) {
+            a->min = v;
+        }
+        double d = (double)v - a->shift;
+        a->sum += d;
+        a->sumSq += d * d;
+    }
+}
+
+static void stats_scalar(const float *src, int len, StatsAccum *a)
+{
+    stats_scalar_from(src, 0, len, a);
+}
+
+// Continues the running sum in dst from index begin
+static void cumulative_power_scalar_from(const float *src, double *dst, int begin, int len,
+                                         const ExpParams *p)
+{
+    double sum = dst[begin];
+    for(int i = begin; i < len; i++) {
+        sum += pow(10, (src[i] + p->offset) * p->scale);
+        dst[i + 1] = sum;
+    }
+}
+
+static void cumulative_power_scalar(const float *src, double *dst, int len, const ExpParams *p)
+{
+    cumulative_power_scalar_from(src, dst, 0, len, p);
+}
+
+static void db_to_lin_scalar(const float *src, float *dst, int len, const ExpParams *p)
+{
+    for(int i = 0; i < len; i++) {
+        dst[i] = pow(10, (src[i] + p->offset) * p->scale);
+    }
+}
+
+static void lin_to_db_scalar(const float *src, float *dst, int len, const LogParams *p)
+{
+    for(int i = 0; i < len; i++) {
+        dst[i] = p->scale * log10((double)src[i]) + p->offset;
+    }
+}
+
+// corr, limMin/limMax and margin may be null, the loop invariant
+//   branches are left for the compiler to hoist
+static bool correct_limit_scalar(float *min, float *max, const float *corr, bool multiply,
+                                 const float *limMin, const float *limMax, float *margin,
+                                 int len)
+{
+    bool passed = true;
+    for(int i = 0; i < len; i++) {
+        float lo = min[i], hi = max[i];
+        if(corr) {
+            if(multiply) {
+                lo *= corr[i];
+                hi *= corr[i];
+            } else {
+                lo += corr[i];
+                hi += corr[i];
+            }
+            min[i] = lo;
+            max[i] = hi;
+        }
+        if(limMin) {
+            if(lo < limMin[i] || hi > limMax[i]) {
+                passed = false;
+            }
+            if(margin) {
+                float below = limMin[i] - lo, above = hi - limMax[i];
+                margin[i] = (above > below) ? above : below;
+            }
+        }
+    }
+    return passed;
+}
+
+// Clamped the same way as the vector levels, NaN and values <= 0 give 0
+static void intensity_to_rgba_scalar(const float *src, unsigned char *dst, int len)
+{
+    for(int i = 0; i < len; i++) {
+        float v = src[i] * 255.0f;
+        v = (v > 0.0f) ? v : 0.0f;
+        v = (v < 255.0f) ? v : 255.0f;
+        unsigned char g = (unsigned char)(int)v;
+        dst[i*4] = dst[i*4+1] = dst[i*4+2] = g;
+        dst[i*4+3] = (src[i] > 0.0f) ? 255 : 0;
+    }
+}
+
+#ifdef SIMD_X86
+
+/*
+ * 10^(x*s) = 2^n * 2^(r/C), C = 1/(s*log2(10)), n = round(x/C)
+ * r = x - n*C is reduced with C split in two so n*C_HI is exact,
+ *   2^f for f in [-0.5, 0.5] is the Cephes exp2f polynomial
+ */
+static const float EXP2_P[6] = {
+    1.535336188319500e-4f, 1.339887440266574e-3f, 9.618437357674640e-3f,
+    5.550332471162809e-2f, 2.402264791363012e-1f, 6.931472028550421e-1f
+};
+
+/*
+ * ln(x) = e*ln(2) + ln(m), m in [sqrt(0.5), sqrt(2)) from the float
+ *   exponent and mantissa, ln(1 + t) is the Cephes logf polynomial
+ * ln(2) is split in two as in the exp reduction
+ */
+static const float LN2_HI = 0.693359375f;
+static const float LN2_LO = -2.12194440e-4f;
+static const float LOG_P[9] = {
+    7.0376836292e-2f, -1.1514610310e-1f, 1.1676998740e-1f,
+    -1.2420140846e-1f, 1.4249322787e-1f, -1.6668057665e-1f,
+    2.0000714765e-1f, -2.4999993993e-1f, 3.3333331174e-1f
+};
+
+// Fold per lane max/index/min into the accumulator, ties go to the
+//   lowest index so the result matches the scalar scan
+static void stats_merge_lanes(const float *max, const int *index, const float *min,
+                              int lanes, StatsAccum *a)
+{
+    for(int l = 0; l < lanes; l++) {
+        if(max[l] > a->max || (max[l] == a->max && index[l] < a->maxIndex)) {
+            a->max = max[l];
+            a->maxIndex = index[l];
+        }
+        if(min[l] < a->min) {
+            a->min = min[l];
+        }
+    }
+}
+
+// The fused kernels are templates, so the target is set for a whole
+//   region rather than per function
+#if defined(__clang__)
+#define SIMD_REGION_BEGIN(isa) \
+    _Pragma("clang attribute push (__attribute__((target(\"" isa "\"))), apply_to = function)")
+#define SIMD_REGION_END _Pragma("clang attribute pop")
+#elif defined(__GNUC__)
+#define SIMD_PRAGMA(x) _Pragma(#x)
+#define SIMD_REGION_BEGIN(isa) _Pragma("GCC push_options") SIMD_PRAGMA(GCC target(isa))
+#define SIMD_REGION_END _Pragma("GCC pop_options")
+#else
+#define SIMD_REGION_BEGIN(isa)
+#define SIMD_REGION_END
+#endif
+
+SIMD_REGION_BEGIN("sse2")
+namespace simd_sse2 {
+struct VecSSE2 {
+    typedef __m128 T;
+    enum { W = 4 };
+    static inline T load(const float *p) { return _mm_loadu_ps(p); }
+    static inline void store(float *p, T v) { _mm_storeu_ps(p, v); }
+    static inline T max(T a, T b) { return _mm_max_ps(a, b); }
+    static inline T min(T a, T b) { return _mm_min_ps(a, b); }
+    static inline T mul(T a, T b) { return _mm_mul_ps(a, b); }
+    static inline T add(T a, T b) { return _mm_add_ps(a, b); }
+    static inline T set1(float f) { return _mm_set1_ps(f); }
+};
+typedef VecSSE2 Vec;
+#include "simd_fused_impl.h"
+}
+SIMD_REGION_END
+
+SIMD_REGION_BEGIN("avx2")
+namespace simd_avx2 {
+struct VecAVX2 {
+    typedef __m256 T;
+    enum { W = 8 };
+    static inline T load(const float *p) { return _mm256_loadu_ps(p); }
+    static inline void store(float *p, T v) { _mm256_storeu_ps(p, v); }
+    static inline T max(T a, T b) { return _mm256_max_ps(a, b); }
+    static inline T min(T a, T b) { return _mm256_min_ps(a, b); }
+    static inline T mul(T a, T b) { return _mm256_mul_ps(a, b); }
+    static inline T add(T a, T b) { return _mm256_add_ps(a, b); }
+    static inline T set1(float f) { return _mm256_set1_ps(f); }
+};
+typedef VecAVX2 Vec;
+#include "simd_fused_impl.h"
+}
+SIMD_REGION_END
+
+SIMD_TARGET_SSE2 static void max_sse2(const float *src, float *srcDst, int len)
+{
+    int i = 0;
+    for(; i + 4 <= len; i += 4) {
+        _mm_storeu_ps(srcDst + i, _mm_max_ps(_mm_loadu_ps(srcDst + i), _mm_loadu_ps(src + i)));
+    }
+    max_scalar(src + i, srcDst + i, len - i);
+}
+
+SIMD_TARGET_SSE2 static void min_sse2(const float *src, float *srcDst, int len)
+{
+    int i = 0;
+    for(; i + 4 <= len; i += 4) {
+        _mm_storeu_ps(srcDst + i, _mm_min_ps(_mm_loadu_ps(srcDst + i), _mm_loadu_ps(src + i)));
+    }
+    min_scalar(src + i, srcDst + i, len - i);
+}
+
+SIMD_TARGET_SSE2 static void max_hold_sse2(const float *src, float *hold, float *copy, int len)
+{
+    int i = 0;
+    for(; i + 4 <= len; i += 4) {
+        __m128 m = _mm_max_ps(_mm_loadu_ps(hold + i), _mm_loadu_ps(src + i));
+        _mm_storeu_ps(hold + i, m);
+        _mm_storeu_ps(copy + i, m);
+    }
+    max_hold_scalar(src + i, hold + i, copy + i, len - i);
+}
+
+SIMD_TARGET_SSE2 static void min_hold_sse2(const float *src, float *hold, float *copy, int len)
+{
+    int i = 0;
+    for(; i + 4 <= len; i += 4) {
+        __m128 m = _mm_min_ps(_mm_loadu_ps(hold + i), _mm_loadu_ps(src + i));
+        _mm_storeu_ps(hold + i, m);
+        _mm_storeu_ps(copy + i, m);
+    }
+    min_hold_scalar(src + i, hold + i, copy + i, len - i);
+}
+
+// Separate multiply and add, no FMA, results match the scalar kernel
+SIMD_TARGET_SSE2 static void average_sse2(const float *src, float *srcDst,
+                                          float keep, float add, int len)
+{
+    __m128 k = _mm_set1_ps(keep), a = _mm_set1_ps(add);
+    int i = 0;
+    for(; i + 4 <= len; i += 4) {
+        __m128 v = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(srcDst + i), k),
+                              _mm_mul_ps(_mm_loadu_ps(src + i), a));
+        _mm_storeu_ps(srcDst + i, v);
+    }
+    average_scalar(src + i, srcDst + i, keep, add, len - i);
+}
+
+SIMD_TARGET_SSE2 static void add_c_sse2(float value, float *srcDst, int len)
+{
+    __m128 v = _mm_set1_ps(value);
+    int i = 0;
+    for(; i + 4 <= len; i += 4) {
+        _mm_storeu_ps(srcDst + i, _mm_add_ps(_mm_loadu_ps(srcDst + i), v));
+    }
+    add_c_scalar(value, srcDst + i, len - i);
+}
+
+SIMD_TARGET_SSE2 static inline __m128 exp10_sse2(__m128 x, const ExpParams *c)
+{
+    x = _mm_add_ps(x, _mm_set1_ps(c->offsetF));
+    x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(c->xMin)), _mm_set1_ps(c->xMax));
+
+    // Round to nearest under the default rounding mode
+    __m128i n = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(c->k)));
+    __m128 nf = _mm_cvtepi32_ps(n);
+    __m128 r = _mm_sub_ps(_mm_sub_ps(x, _mm_mul_ps(nf, _mm_set1_ps(c->cHi))),
+                          _mm_mul_ps(nf, _mm_set1_ps(c->cLo)));
+    __m128 f = _mm_mul_ps(r, _mm_set1_ps(c->k));
+
+    __m128 p = _mm_set1_ps(EXP2_P[0]);
+    for(int k = 1; k < 6; k++) {
+        p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(EXP2_P[k]));
+    }
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.0f));
+
+    __m128i e = _mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23);
+    return _mm_mul_ps(p, _mm_castsi128_ps(e));
+}
+
+// Zero gives -inf, negative and NaN give NaN, +inf stays +inf
+SIMD_TARGET_SSE2 static inline __m128 log10_sse2(__m128 x, const LogParams *c)
+{
+    __m128 zero = _mm_setzero_ps();
+    __m128 inf = _mm_set1_ps(HUGE_VALF);
+    __m128 isZero = _mm_cmpeq_ps(x, zero);
+    __m128 isInf = _mm_cmpeq_ps(x, inf);
+    __m128 isNan = _mm_or_ps(_mm_cmplt_ps(x, zero), _mm_cmpunord_ps(x, x));
+
+    // Denormals are scaled by 2^25 into the normal range, the special
+    //   cases are clamped here and patched below
+    __m128 denorm = _mm_cmplt_ps(x, _mm_set1_ps(FLT_MIN));
+    x = _mm_max_ps(x, _mm_set1_ps(FLT_MIN / 33554432.0f));
+    x = _mm_min_ps(x, _mm_set1_ps(FLT_MAX));
+    x = _mm_or_ps(_mm_andnot_ps(denorm, x),
+                  _mm_and_ps(denorm, _mm_mul_ps(x, _mm_set1_ps(33554432.0f))));
+    __m128i bits = _mm_castps_si128(x);
+    __m128 e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(126)));
+    e = _mm_sub_ps(e, _mm_and_ps(denorm, _mm_set1_ps(25.0f)));
+    __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)),
+                                             _mm_set1_epi32(0x3f000000)));
+
+    // m in [0.5, 1), below sqrt(0.5) use 2m and e - 1
+    __m128 small = _mm_cmplt_ps(m, _mm_set1_ps(0.707106781186547524f));
+    __m128 one = _mm_set1_ps(1.0f);
+    e = _mm_sub_ps(e, _mm_and_ps(small, one));
+    __m128 t = _mm_sub_ps(_mm_add_ps(m, _mm_and_ps(small, m)), one);
+    __m128 z = _mm_mul_ps(t, t);
+
+    __m128 y = _mm_set1_ps(LOG_P[0]);
+    for(int k = 1; k < 9; k++) {
+        y = _mm_add_ps(_mm_mul_ps(y, t), _mm_set1_ps(LOG_P[k]));
+    }
+    y = _mm_mul_ps(_mm_mul_ps(y, t), z);
+    y = _mm_add_ps(y, _mm_mul_ps(e, _mm_set1_ps(LN2_LO)));
+    y = _mm_sub_ps(y, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+    __m128 ln = _mm_add_ps(_mm_add_ps(t, y), _mm_mul_ps(e, _mm_set1_ps(LN2_HI)));
+
+    __m128 v = _mm_add_ps(_mm_mul_ps(ln, _mm_set1_ps(c->lnScale)), _mm_set1_ps(c->offsetF));
+    v = _mm_or_ps(_mm_andnot_ps(isZero, v), _mm_and_ps(isZero, _mm_sub_ps(zero, inf)));
+    v = _mm_or_ps(_mm_andnot_ps(isInf, v), _mm_and_ps(isInf, inf));
+    return _mm_or_ps(v, isNan);
+}
+
+// Conversion is vectorized, the running sum stays in order in double
+SIMD_TARGET_SSE2 static void cumulative_power_sse2(const float *src, double *dst, int len,
+                                                   const ExpParams *c)
+{
+    float lin[4];
+    double sum = dst[0];
+    int i = 0;
+    for(; i + 4 <= len; i += 4) {
+        _mm_storeu_ps(lin, exp10_sse2(_mm_loadu_ps(src + i), c));
+        for(int k = 0; k < 4; k++) {
+            sum += lin[k];
+            dst[i + k + 1] = sum;
+        }
+    }
+    cumulative_power_scalar_from(src, dst, i, len, c);
+}
+
+SIMD_TARGET_SSE2 static void db_to_lin_sse2(const float *src, float *dst, int len,
+                                            const ExpParams *c)
+{
+    int i = 0;
+    for(; i + 4 <= len; i += 4) {
+        _mm_storeu_ps(dst + i, exp10_sse2(_mm_loadu_ps(src + i), c));
+    }
+    db_to_lin_scalar(src + i, dst + i, len - i, c);
+}
+
+SIMD_TARGET_SSE2 static void lin_to_db_sse2(const float *src, float *dst, int len,
+                                            const LogParams *c)
+{
+    int i = 0;
+    for(; i + 4 <= len; i += 4) {
+        _mm_storeu_ps(dst + i, log10_sse2(_mm_loadu_ps(src + i), c));
+    }
+    lin_to_db_scalar(src + i, dst + i, len - i, c);
+}
+
+// Failures are collected in a mask, no early exit
+SIMD_TARGET_SSE2 static bool correct_limit_sse2(float *min, float *max, const float *corr,
+                                                bool multiply, const float *limMin,
+                                                const float *limMax, float *margin, int len)
+{
+    __m128 fail = _mm_setzero_ps();
+    int i = 0;
+    for(; i + 4 <= len; i += 4) {
+        __m128 lo = _mm_loadu_ps(min + i), hi = _mm_loadu_ps(max + i);
+        if(corr) {
+            __m128 c = _mm_loadu_ps(corr + i);
+            lo = multiply ? _mm_mul_ps(lo, c) : _mm_add_ps(lo, c);
+            hi = multiply ? _mm_mul_ps(hi, c) : _mm_add_ps(hi, c);
+            _mm_storeu_ps(min + i, lo);
+            _mm_storeu_ps(max + i, hi);
+        }
+        if(limMin) {
+            __m128 lmin = _mm_loadu_ps(limMin + i), lmax = _mm_loadu_ps(limMax + i);
+            fail = _mm_or_ps(fail, _mm_or_ps(_mm_cmplt_ps(lo, lmin), _mm_cmpgt_ps(hi, lmax)));
+            if(margin) {
+                _mm_storeu_ps(margin + i, _mm_max_ps(_mm_sub_ps(hi, lmax), _mm_sub_ps(lmin, lo)));
+            }
+        }
+    }
+
+    bool passed = (_mm_movemask_ps(fail) == 0);
+    return correct_limit_scalar(min + i, max + i, corr ? corr + i : nullptr, multiply,
+                                limMin ? limMin + i : nullptr, limMax ? limMax + i : nullptr,
+                                margin ? margin + i : nullptr, len - i) && passed;
+}
+
+// Gray level in the low three bytes, alpha from the > 0 mask
+// _mm_max_ps returns the second operand for NaN, NaN clamps to 0
+SIMD_TARGET_SSE2 static void intensity_to_rgba_sse2(const float *src, unsigned char *dst, int len)
+{
+    const __m128 scale = _mm_set1_ps(255.0f), zero = _mm_setzero_ps();
+    const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+    int i = 0;
+    for(; i + 4 <= len; i += 4) {
+        __m128 x = _mm_loadu_ps(src + i);
+        __m128 v = _mm_min_ps(_mm_max_ps(_mm_mul_ps(x, scale), zero), scale);
+        __m128i g = _mm_cvttps_epi32(v);
+        g = _mm_or_si128(g, _mm_or_si128(_mm_slli_epi32(g, 8), _mm_slli_epi32(g, 16)));
+        __m128i a = _mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(x, zero)), alpha);
+        _mm_storeu_si128((__m128i*)(dst + i*4), _mm_or_si128(g, a));
+    }
+    intensity_to_rgba_scalar(src + i, dst + i*4, len - i);
+}
+
+// _mm_max_ps/_mm_min_ps return the second operand for NaN, the running
+//   value is passed second so NaNs are skipped as in the scalar scan
+SIMD_TARGET_SSE2 static void stats_sse2(const float *src, int len, StatsAccum *a)
+{
+    __m128 vmax = _mm_set1_ps(a->max), vmin = _mm_set1_ps(a->min);
+    __m128d shift = _mm_set1_pd(a->shift);
+    __m128i vix = _mm_set1_epi32(a->maxIndex);
+    __m128i cur = _mm_setr_epi32(0, 1, 2, 3), step = _mm_set1_epi32(4);
+    __m128d s0 = _mm_setzero_pd(), s1 = _mm_setzero_pd();
+    __m128d q0 = _mm_setzero_pd(), q1 = _mm_setzero_pd();
+
+    int i = 0;
+    for(; i + 4 <= len; i += 4) {
+        __m128 v = _mm_loadu_ps(src + i);
+        __m128i gt = _mm_castps_si128(_mm_cmpgt_ps(v, vmax));
+        vix = _mm_or_si128(_mm_and_si128(gt, cur), _mm_andnot_si128(gt, vix));
+        vmax = _mm_max_ps(v, vmax);
+        vmin = _mm_min_ps(v, vmin);
+        cur = _mm_add_epi32(cur, step);
+
+        __m128d lo = _mm_sub_pd(_mm_cvtps_pd(v), shift);
+        __m128d hi = _mm_sub_pd(_mm_cvtps_pd(_mm_movehl_ps(v, v)), shift);
+        s0 = _mm_add_pd(s0, lo);
+        s1 = _mm_add_pd(s1, hi);
+        q0 = _mm_add_pd(q0, _mm_mul_pd(lo, lo));
+        q1 = _mm_add_pd(q1, _mm_mul_pd(hi, hi));
+    }
+
+    float maxLanes[4], minLanes[4];
+    int ixLanes[4];
+    double sums[2], sumSqs[2];
+    _mm_storeu_ps(maxLanes, vmax);
+    _mm_storeu_ps(minLanes, vmin);
+    _mm_storeu_si128((__m128i*)ixLanes, vix);
+    _mm_storeu_pd(sums, _mm_add_pd(s0, s1));
+    _mm_storeu_pd(sumSqs, _mm_add_pd(q0, q1));
+
+    stats_merge_lanes(maxLanes, ixLanes, minLanes, 4, a);
+    a->sum += sums[0] + sums[1];
+    a->sumSq += sumSqs[0] + sumSqs[1];
+
+    stats_scalar_from(src, i, len, a);
+}
+
+SIMD_TARGET_AVX2 static void max_avx2(const float *src, float *srcDst, int len)
+{
+    int i = 0;
+    for(; i + 8 <= len; i += 8) {
+        _mm256_storeu_ps(srcDst + i, _mm256_max_ps(_mm256_loadu_ps(srcDst + i),
+                                                   _mm256_loadu_ps(src + i)));
+    }
+    max_scalar(src + i, srcDst + i, len - i);
+}
+
+SIMD_TARGET_AVX2 static void min_avx2(const float *src, float *srcDst, int len)
+{
+    int i = 0;
+    for(; i + 8 <= len; i += 8) {
+        _mm256_storeu_ps(srcDst + i, _mm256_min_ps(_mm256_loadu_ps(srcDst + i),
+                                                   _mm256_loadu_ps(src + i)));
+    }
+    min_scalar(src + i, srcDst + i, len - i);
+}
+
+SIMD_TARGET_AVX2 static void max_hold_avx2(const float *src, float *hold, float *copy, int len)
+{
+    int i = 0;
+    for(; i + 8 <= len; i += 8) {
+        __m256 m = _mm256_max_ps(_mm256_loadu_ps(hold + i), _mm256_loadu_ps(src + i));
+        _mm256_storeu_ps(hold + i, m);
+        _mm256_storeu_ps(copy + i, m);
+    }
+    max_hold_scalar(src + i, hold + i, copy + i, len - i);
+}
+
+SIMD_TARGET_AVX2 static void min_hold_avx2(const float *src, float *hold, float *copy, int len)
+{
+    int i = 0;
+    for(; i + 8 <= len; i += 8) {
+        __m256 m = _mm256_min_ps(_mm256_loadu_ps(hold + i), _mm256_loadu_ps(src + i));
+        _mm256_storeu_ps(hold + i, m);
+        _mm256_storeu_ps(copy + i, m);
+    }
+    min_hold_scalar(src + i, hold + i, copy + i, len - i);
+}
+
+SIMD_TARGET_AVX2 static void average_avx2(const float *src, float *srcDst,
+                                          float keep, float add, int len)
+{
+    __m256 k = _mm256_set1_ps(keep), a = _mm256_set1_ps(add);
+    int i = 0;
+    for(; i + 8 <= len; i += 8) {
+        __m256 v = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(srcDst + i), k),
+                                 _mm256_mul_ps(_mm256_loadu_ps(src + i), a));
+        _mm256_storeu_ps(srcDst + i, v);
+    }
+    average_scalar(src + i, srcDst + i, keep, add, len - i);
+}
+
+SIMD_TARGET_AVX2 static void add_c_avx2(float value, float *srcDst, int len)
+{
+    __m256 v = _mm256_set1_ps(value);
+    int i = 0;
+    for(; i + 8 <= len; i += 8) {
+        _mm256_storeu_ps(srcDst + i, _mm256_add_ps(_mm256_loadu_ps(srcDst + i), v));
+    }
+    add_c_scalar(value, srcDst + i, len - i);
+}
+
+SIMD_TARGET_AVX2 static void stats_avx2(const float *src, int len, StatsAccum *a)
+{
+    __m256 vmax = _mm256_set1_ps(a->max), vmin = _mm256_set1_ps(a->min);
+    __m256d shift = _mm256_set1_pd(a->shift);
+    __m256i vix = _mm256_set1_epi32(a->maxIndex);
+    __m256i cur = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), step = _mm256_set1_epi32(8);
+    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+    __m256d q0 = _mm256_setzero_pd(), q1 = _mm256_setzero_pd();
+
+    int i = 0;
+    for(; i + 8 <= len; i += 8) {
+        __m256 v = _mm256_loadu_ps(src + i);
+        __m256i gt = _mm256_castps_si256(_mm256_cmp_ps(v, vmax, _CMP_GT_OQ));
+        vix = _mm256_blendv_epi8(vix, cur, gt);
+        vmax = _mm256_max_ps(v, vmax);
+        vmin = _mm256_min_ps(v, vmin);
+        cur = _mm256_add_epi32(cur, step);
+
+        // Separate multiply and add, no FMA, like the SSE2 kernel
+        __m256d lo = _mm256_sub_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(v)), shift);
+        __m256d hi = _mm256_sub_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)), shift);
+        s0 = _mm256_add_pd(s0, lo);
+        s1 = _mm256_add_pd(s1, hi);
+        q0 = _mm256_add_pd(q0, _mm256_mul_pd(lo, lo));
+        q1 = _mm256_add_pd(q1, _mm256_mul_pd(hi, hi));
+    }
+
+    float maxLanes[8], minLanes[8];
+    int ixLanes[8];
+    double sums[4], sumSqs[4];
+    _mm256_storeu_ps(maxLanes, vmax);
+    _mm256_storeu_ps(minLanes, vmin);
+    _mm256_storeu_si256((__m256i*)ixLanes, vix);
+    _mm256_storeu_pd(sums, _mm256_add_pd(s0, s1));
+    _mm256_storeu_pd(sumSqs, _mm256_add_pd(q0, q1));
+
+    stats_merge_lanes(maxLanes, ixLanes, minLanes, 8, a);
+    a->sum += (sums[0] + sums[1]) + (sums[2] + sums[3]);
+    a->sumSq += (sumSqs[0] + sumSqs[1]) + (sumSqs[2] + sumSqs[3]);
+
+    stats_scalar_from(src, i, len, a);
+}
+
+SIMD_TARGET_AVX2 static inline __m256 exp10_avx2(__m256 x, const ExpParams *c)
+{
+    x = _mm256_add_ps(x, _mm256_set1_ps(c->offsetF));
+    x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(c->xMin)), _mm256_set1_ps(c->xMax));
+
+    __m256i n = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(c->k)));
+    __m256 nf = _mm256_cvtepi32_ps(n);
+    __m256 r = _mm256_sub_ps(_mm256_sub_ps(x, _mm256_mul_ps(nf, _mm256_set1_ps(c->cHi))),
+                             _mm256_mul_ps(nf, _mm256_set1_ps(c->cLo)));
+    __m256 f = _mm256_mul_ps(r, _mm256_set1_ps(c->k));
+
+    __m256 p = _mm256_set1_ps(EXP2_P[0]);
+    for(int k = 1; k < 6; k++) {
+        p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(EXP2_P[k]));
+    }
+    p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(1.0f));
+
+    __m256i e = _mm256_slli_epi32(_mm256_add_epi32(n, _mm256_set1_epi32(127)), 23);
+    return _mm256_mul_ps(p, _mm256_castsi256_ps(e));
+}
+
+SIMD_TARGET_AVX2 static inline __m256 log10_avx2(__m256 x, const LogParams *c)
+{
+    __m256 zero = _mm256_setzero_ps();
+    __m256 inf = _mm256_set1_ps(HUGE_VALF);
+    __m256 isZero = _mm256_cmp_ps(x, zero, _CMP_EQ_OQ);
+    __m256 isInf = _mm256_cmp_ps(x, inf, _CMP_EQ_OQ);
+    __m256 isNan = _mm256_cmp_ps(x, zero, _CMP_NGE_UQ);
+
+    __m256 denorm = _mm256_cmp_ps(x, _mm256_set1_ps(FLT_MIN), _CMP_LT_OQ);
+    x = _mm256_max_ps(x, _mm256_set1_ps(FLT_MIN / 33554432.0f));
+    x = _mm256_min_ps(x, _mm256_set1_ps(FLT_MAX));
+    x = _mm256_blendv_ps(x, _mm256_mul_ps(x, _mm256_set1_ps(33554432.0f)), denorm);
+    __m256i bits = _mm256_castps_si256(x);
+    __m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23),
+                                                   _mm256_set1_epi32(126)));
+    e = _mm256_sub_ps(e, _mm256_and_ps(denorm, _mm256_set1_ps(25.0f)));
+    __m256 m = _mm256_castsi256_ps(_mm256_or_si256(
+                   _mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)),
+                   _mm256_set1_epi32(0x3f000000)));
+
+    __m256 small = _mm256_cmp_ps(m, _mm256_set1_ps(0.707106781186547524f), _CMP_LT_OQ);
+    __m256 one = _mm256_set1_ps(1.0f);
+    e = _mm256_sub_ps(e, _mm256_and_ps(small, one));
+    __m256 t = _mm256_sub_ps(_mm256_add_ps(m, _mm256_and_ps(small, m)), one);
+    __m256 z = _mm256_mul_ps(t, t);
+
+    // Separate multiply and add, no FMA, like the SSE2 kernel
+    __m256 y = _mm256_set1_ps(LOG_P[0]);
+    for(int k = 1; k < 9; k++) {
+        y = _mm256_add_ps(_mm256_mul_ps(y, t), _mm256_set1_ps(LOG_P[k]));
+    }
+    y = _mm256_mul_ps(_mm256_mul_ps(y, t), z);
+    y = _mm256_add_ps(y, _mm256_mul_ps(e, _mm256_set1_ps(LN2_LO)));
+    y = _mm256_sub_ps(y, _mm256_mul_ps(z, _mm256_set1_ps(0.5f)));
+    __m256 ln = _mm256_add_ps(_mm256_add_ps(t, y), _mm256_mul_ps(e, _mm256_set1_ps(LN2_HI)));
+
+    __m256 v = _mm256_add_ps(_mm256_mul_ps(ln, _mm256_set1_ps(c->lnScale)),
+                             _mm256_set1_ps(c->offsetF));
+    v = _mm256_blendv_ps(v, _mm256_sub_ps(zero, inf), isZero);
+    v = _mm256_blendv_ps(v, inf, isInf);
+    return _mm256_or_ps(v, isNan);
+}
+
+SIMD_TARGET_AVX2 static void cumulative_power_avx2(const float *src, double *dst, int len,
+                                                   const ExpParams *c)
+{
+    float lin[8];
+    double sum = dst[0];
+    int i = 0;
+    for(; i + 8 <= len; i += 8) {
+        _mm256_storeu_ps(lin, exp10_avx2(_mm256_loadu_ps(src + i), c));
+        for(int k = 0; k < 8; k++) {
+            sum += lin[k];
+            dst[i + k + 1] = sum;
+        }
+    }
+    cumulative_power_scalar_from(src, dst, i, len, c);
+}
+
+SIMD_TARGET_AVX2 static void db_to_lin_avx2(const float *src, float *dst, int len,
+                                            const ExpParams *c)
+{
+    int i = 0;
+    for(; i + 8 <= len; i += 8) {
+        _mm256_storeu_ps(dst + i, exp10_avx2(_mm256_loadu_ps(src + i), c));
+    }
+    db_to_lin_scalar(src + i, dst + i, len - i, c);
+}
+
+SIMD_TARGET_AVX2 static void lin_to_db_avx2(const float *src, float *dst, int len,
+                                            const LogParams *c)
+{
+    int i = 0;
+    for(; i + 8 <= len; i += 8) {
+        _mm256_storeu_ps(dst + i, log10_avx2(_mm256_loadu_ps(src + i), c));
+    }
+    lin_to_db_scalar(src + i, dst + i, len - i, c);
+}
+
+SIMD_TARGET_AVX2 static bool correct_limit_avx2(float *min, float *max, const float *corr,
+                                                bool multiply, const float *limMin,
+                                                const float *limMax, float *margin, int len)
+{
+    __m256 fail = _mm256_setzero_ps();
+    int i = 0;
+    for(; i + 8 <= len; i += 8) {
+        __m256 lo = _mm256_loadu_ps(min + i), hi = _mm256_loadu_ps(max + i);
+        if(corr) {
+            __m256 c = _mm256_loadu_ps(corr + i);
+            lo = multiply ? _mm256_mul_ps(lo, c) : _mm256_add_ps(lo, c);
+            hi = multiply ? _mm256_mul_ps(hi, c) : _mm256_add_ps(hi, c);
+            _mm256_storeu_ps(min + i, lo);
+            _mm256_storeu_ps(max + i, hi);
+        }
+        if(limMin) {
+            __m256 lmin = _mm256_loadu_ps(limMin + i), lmax = _mm256_loadu_ps(limMax + i);
+            __m256 below = _mm256_cmp_ps(lo, lmin, _CMP_LT_OQ);
+            __m256 above = _mm256_cmp_ps(hi, lmax, _CMP_GT_OQ);
+            fail = _mm256_or_ps(fail, _mm256_or_ps(below, above));
+            if(margin) {
+                _mm256_storeu_ps(margin + i, _mm256_max_ps(_mm256_sub_ps(hi, lmax),
+                                                           _mm256_sub_ps(lmin, lo)));
+            }
+        }
+    }
+
+    bool passed = (_mm256_movemask_ps(fail) == 0);
+    return correct_limit_scalar(min + i, max + i, corr ? corr + i : nullptr, multiply,
+                                limMin ? limMin + i : nullptr, limMax ? limMax + i : nullptr,
+                                margin ? margin + i : nullptr, len - i) && passed;
+}
+
+SIMD_TARGET_AVX2 static void intensity_to_rgba_avx2(const float *src, unsigned char *dst, int len)
+{
+    const __m256 scale = _mm256_set1_ps(255.0f), zero = _mm256_setzero_ps();
+    const __m256i alpha = _mm256_set1_epi32((int)0xFF000000);
+    int i = 0;
+    for(; i + 8 <= len; i += 8) {
+        __m256 x = _mm256_loadu_ps(src + i);
+        __m256 v = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(x, scale), zero), scale);
+        __m256i g = _mm256_cvttps_epi32(v);
+        g = _mm256_or_si256(g, _mm256_or_si256(_mm256_slli_epi32(g, 8), _mm256_slli_epi32(g, 16)));
+        __m256i a = _mm256_and_si256(_mm256_castps_si256(_mm256_cmp_ps(x, zero, _CMP_GT_OQ)), alpha);
+        _mm256_storeu_si256((__m256i*)(dst + i*4), _mm256_or_si256(g, a));
+    }
+    intensity_to_rgba_scalar(src + i, dst + i*4, len - i);
+}
+
+static void cpuid(int leaf, int subLeaf, unsigned int regs[4])
+{
+#if defined(_MSC_VER)
+    int r[4];
+    __cpuidex(r, leaf, subLeaf);
+    for(int i = 0; i < 4; i++) regs[i] = (unsigned int)r[i];
+#else
+    __cpuid_count(leaf, subLeaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// Extended control register, the OS must save the YMM state for AVX
+static unsigned long long xgetbv0()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned int lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((unsigned long long)hi << 32) | lo;
+#endif
+}
+
+static SimdLevel detect_level()
+{
+    unsigned int regs[4];
+    cpuid(0, 0, regs);
+    unsigned int maxLeaf = regs[0];
+
+    cpuid(1, 0, regs);
+    bool sse2 = (regs[3] & (1u << 26)) != 0;
+    bool osxsave = (regs[2] & (1u << 27)) != 0;
+    bool avx = (regs[2] & (1u << 28)) != 0;
+
+    if(!sse2) {
+        return SimdScalar;
+    }
+
+    if(maxLeaf >= 7 && osxsave && avx && (xgetbv0() & 0x6) == 0x6) {
+        cpuid(7, 0, regs);
+        if(regs[1] & (1u << 5)) {
+            return SimdAVX2;
+        }
+    }
+
+    return SimdSSE2;
+}
+
+#else
+
+static SimdLevel detect_level()
+{
+    return SimdScalar;
+}
+
+#endif // SIMD_X86
+
+// Per call constants of the conversions
+static void exp_params(double scale, double offset, ExpParams *c)
+{
+    double k = scale * 3.321928094887362; // log2(10)
+    double inv = 1.0 / k;
+
+    // Keep 12 significant bits in cHi so n * cHi is exact for |n| < 2^12
+    int exp;
+    double m = frexp(inv, &exp);
+    double hi = ldexp(floor(m * 4096.0) / 4096.0, exp);
+
+    c->scale = scale;
+    c->offset = offset;
+    c->k = (float)k;
+    c->cHi = (float)hi;
+    c->cLo = (float)(inv - hi);
+    c->offsetF = (float)offset;
+    c->xMin = (float)(-126.0 * inv);
+    c->xMax = (float)(127.0 * inv);
+}
+
+static void log_params(double scale, double offset, LogParams *c)
+{
+    c->scale = scale;
+    c->offset = offset;
+    c->lnScale = (float)(scale * 0.4342944819032518); // 1 / ln(10)
+    c->offsetF = (float)offset;
+}
+
+static const SimdKernels kernel_table[] = {
+    { max_scalar, min_scalar, max_hold_scalar, min_hold_scalar, average_scalar, add_c_scalar,
+      simd_scalar::fused_update, stats_scalar, cumulative_power_scalar,
+      db_to_lin_scalar, lin_to_db_scalar, correct_limit_scalar,
+      intensity_to_rgba_scalar },
+#ifdef SIMD_X86
+    { max_sse2, min_sse2, max_hold_sse2, min_hold_sse2, average_sse2, add_c_sse2,
+      simd_sse2::fused_update, stats_sse2, cumulative_power_sse2,
+      db_to_lin_sse2, lin_to_db_sse2, correct_limit_sse2,
+      intensity_to_rgba_sse2 },
+    { max_avx2, min_avx2, max_hold_avx2, min_hold_avx2, average_avx2, add_c_avx2,
+      simd_avx2::fused_update, stats_avx2, cumulative_power_avx2,
+      db_to_lin_avx2, lin_to_db_avx2, correct_limit_avx2,
+      intensity_to_rgba_avx2 }
+#endif
+};
+
+static SimdLevel select_level()
+{
+    SimdLevel level = detect_level();
+
+    const char *env = getenv("BBAPP_SIMD");
+    if(env) {
+        if(strcmp(env, "scalar") == 0 && level > SimdScalar) level = SimdScalar;
+        if(strcmp(env, "sse2") == 0 && level > SimdSSE2) level = SimdSSE2;
+    }
+
+    return level;
+}
+
+// Selected during static initialization, before any trace is updated
+static const SimdLevel cpu_level = detect_level();
+static SimdLevel active_level = select_level();
+static const SimdKernels *kernels = &kernel_table[active_level];
+
+SimdLevel simdLevel()
+{
+    return active_level;
+}
+
+const char* simdLevelName(SimdLevel level)
+{
+    switch(level) {
+    case SimdAVX2: return "AVX2";
+    case SimdSSE2: return "SSE2";
+    default: return "Scalar";
+    }
+}
+
+SimdLevel simdSetLevel(SimdLevel level)
+{
+    active_level = (level < cpu_level) ? level : cpu_level;
+    kernels = &kernel_table[active_level];
+    return active_level;
+}
+
+void simdMax_32f(const float *src, float *srcDst, int len)
+{
+    kernels->max(src, srcDst, len);
+}
+
+void simdMin_32f(const float *src, float *srcDst, int len)
+{
+    kernels->min(src, srcDst, len);
+}
+
+void simdMaxHold_32f(const float *src, float *hold, float *copy, int len)
+{
+    kernels->maxHold(src, hold, copy, len);
+}
+
+void simdMinHold_32f(const float *src, float *hold, float *copy, int len)
+{
+    kernels->minHold(src, hold, copy, len);
+}
+
+void simdAverage_32f(const float *src, float *srcDst, float keep, float add, int len)
+{
+    kernels->average(src, srcDst, keep, add, len);
+}
+
+void simdAddC_32f(float value, float *srcDst, int len)
+{
+    kernels->addC(value, srcDst, len);
+}
+
+void simdFusedTraceUpdate_32f(const float *srcMin, const float *srcMax,
+                              const SimdTraceTarget *targets, int count, int len)
+{
+    if(count <= 0 || len <= 0) {
+        return;
+    }
+
+    // Sort by operation so each combination maps to one specialization,
+    //   pad to three targets for the specialized kernels
+    SimdTraceTarget sorted[SIMD_MAX_TRACE_TARGETS];
+    int n = 0;
+    for(int k = 0; k < count && n < SIMD_MAX_TRACE_TARGETS; k++, n++) {
+        int j = n;
+        while(j > 0 && sorted[j - 1].op > targets[k].op) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = targets[k];
+    }
+    for(int k = n; k < 3; k++) {
+        sorted[k].op = SimdTraceNone;
+        sorted[k].min = sorted[k].max = nullptr;
+        sorted[k].keep = sorted[k].add = 0.0f;
+    }
+
+    kernels->fusedTrace(srcMin, srcMax, sorted, n, len);
+}
+
+void simdStats_32f(const float *src, int len, float floor, SimdStats *stats)
+{
+    if(len <= 0) {
+        stats->max = floor;
+        stats->maxIndex = 0;
+        stats->min = 0.0f;
+        stats->mean = stats->variance = 0.0;
+        return;
+    }
+
+    StatsAccum a;
+    a.max = floor;
+    a.maxIndex = 0;
+    a.min = src[0];
+    a.shift = src[0];
+    a.sum = a.sumSq = 0.0;
+
+    kernels->stats(src, len, &a);
+
+    double offset = a.sum / len;
+    stats->max = a.max;
+    stats->maxIndex = a.maxIndex;
+    stats->min = a.min;
+    stats->mean = a.shift + offset;
+    double variance = a.sumSq / len - offset * offset;
+    stats->variance = (variance > 0.0) ? variance : 0.0;
+}
+
+void simdCumulativePower_32f(const float *src, double *dst, int len, bool logScale)
+{
+    dst[0] = 0.0;
+    if(len <= 0) {
+        return;
+    }
+
+    if(logScale) {
+        ExpParams c;
+        exp_params(0.1, 0.0, &c);
+        kernels->cumulativePower(src, dst, len, &c);
+        return;
+    }
+
+    // mV^2 is a multiply, no vector path needed
+    double sum = 0.0;
+    for(int i = 0; i < len; i++) {
+        sum += (double)src[i] * src[i];
+        dst[i + 1] = sum;
+    }
+}
+
+void simdDbToLin_32f(const float *src, float *dst, int len, double scale, double offset)
+{
+    if(len <= 0) {
+        return;
+    }
+
+    ExpParams c;
+    exp_params(scale, offset, &c);
+    kernels->dbToLin(src, dst, len, &c);
+}
+
+void simdLinToDb_32f(const float *src, float *dst, int len, double scale, double offset)
+{
+    if(len <= 0) {
+        return;
+    }
+
+    LogParams c;
+    log_params(scale, offset, &c);
+    kernels->linToDb(src, dst, len, &c);
+}
+
+bool simdCorrectLimit_32f(float *min, float *max, const float *corr, bool multiply,
+                          const float *limMin, const float *limMax, float *margin, int len)
+{
+    if(len <= 0 || (!corr && !limMin)) {
+        return true;
+    }
+
+    return kernels->correctLimit(min, max, corr, multiply, limMin, limMax,
+                                 limMin ? margin : nullptr, len);
+}
+
+void simdIntensityToRgba_32f(const float *src, unsigned char *dst, int len)
+{
+    kernels->intensityToRgba(src, dst, len);
+}
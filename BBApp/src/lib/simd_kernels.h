@@ -0,0 +1,109 @@
+#ifndef SIMD_KERNELS_H
+#define SIMD_KERNELS_H
+
+/*
+ * Vectorized kernels with a scalar fallback
+ * The instruction set is chosen once at startup from CPUID, it can be
+ *   lowered with the BBAPP_SIMD environment variable (scalar, sse2, avx2)
+ *   to compare results and timings between implementations.
+ * Pointers do not need to be aligned and may alias only where noted.
+ */
+
+enum SimdLevel {
+    SimdScalar = 0,
+    SimdSSE2,
+    SimdAVX2
+};
+
+// Level used by the dispatched kernels
+SimdLevel simdLevel();
+const char* simdLevelName(SimdLevel level);
+// Force a level, clamped to what the CPU supports, returns the level set
+// Not thread safe, only for benchmarks and verification
+SimdLevel simdSetLevel(SimdLevel level);
+
+// Trace detector kernels
+// srcDst[i] = max(srcDst[i], src[i])
+void simdMax_32f(const float *src, float *srcDst, int len);
+// srcDst[i] = min(srcDst[i], src[i])
+void simdMin_32f(const float *src, float *srcDst, int len);
+// hold[i] = copy[i] = max(hold[i], src[i])
+void simdMaxHold_32f(const float *src, float *hold, float *copy, int len);
+// hold[i] = copy[i] = min(hold[i], src[i])
+void simdMinHold_32f(const float *src, float *hold, float *copy, int len);
+// srcDst[i] = srcDst[i] * keep + src[i] * add
+void simdAverage_32f(const float *src, float *srcDst, float keep, float add, int len);
+// srcDst[i] += value
+void simdAddC_32f(float value, float *srcDst, int len);
+
+// Fused trace update, applies every target from a single pass over
+//   the input so each input bin is read once
+enum SimdTraceOp {
+    SimdTraceCopy = 0,  // min/max = input min/max
+    SimdTraceMaxHold,   // min = max = max(max, input max)
+    SimdTraceMinHold,   // min = max = min(min, input min)
+    SimdTraceMinMax,    // min = min(min, input min), max = max(max, input max)
+    SimdTraceAverage,   // min/max = min/max * keep + input min/max * add
+    SimdTraceNone = 15
+};
+
+struct SimdTraceTarget {
+    SimdTraceOp op;
+    float *min, *max; // Must not alias the input or other targets
+    float keep, add; // SimdTraceAverage only
+};
+
+static const int SIMD_MAX_TRACE_TARGETS = 16;
+
+// Common combinations of up to three targets use kernels specialized
+//   at compile time, target order does not matter
+void simdFusedTraceUpdate_32f(const float *srcMin, const float *srcMax,
+                              const SimdTraceTarget *targets, int count, int len);
+
+// Single pass summary of a buffer
+struct SimdStats {
+    float max; // Largest value above the floor, otherwise the floor
+    int maxIndex; // First index of max, 0 if no value is above the floor
+    float min;
+    double mean, variance;
+};
+
+// Sums are accumulated in double, the order differs between levels so
+//   mean/variance can differ in the last bits, max/min/maxIndex do not
+void simdStats_32f(const float *src, int len, float floor, SimdStats *stats);
+
+// Running sum of the linear power of a trace, dst has len + 1 values,
+//   dst[0] = 0, dst[i + 1] = dst[i] + lin(src[i])
+// lin() is mW from dBm when logScale, otherwise mV^2 from mV
+// The vector levels convert dBm in single precision, relative error
+//   about 1e-7 per bin against the scalar pow()
+void simdCumulativePower_32f(const float *src, double *dst, int len, bool logScale);
+
+// Batch amplitude conversions, src and dst may be the same buffer
+// dst[i] = 10^((src[i] + offset) * scale), scale > 0
+//   dB to voltage ratio, scale 0.05
+//   dBm to mV, scale 0.05 and offset 46.9897
+//   dBm to mW, scale 0.1
+// The vector levels clamp the result to the normal float range
+void simdDbToLin_32f(const float *src, float *dst, int len, double scale, double offset);
+// dst[i] = scale * log10(src[i]) + offset
+// 0 gives -inf, negative values and NaN give NaN
+void simdLinToDb_32f(const float *src, float *dst, int len, double scale, double offset);
+// The vector levels use exp2/log2 polynomials in single precision,
+//   results stay within 2e-4 dB of the scalar pow()/log10()
+
+// Trace corrections and limit test in one pass
+// min[i] and max[i] are offset by corr[i], or scaled when multiply
+// Returns false if any limMin[i] > min[i] or max[i] > limMax[i] after
+//   the correction, corr or limMin/limMax may be null to skip either
+// margin[i] = max(max[i] - limMax[i], limMin[i] - min[i]) when not null,
+//   positive for the bins that fail
+bool simdCorrectLimit_32f(float *min, float *max, const float *corr, bool multiply,
+                          const float *limMin, const float *limMax, float *margin, int len);
+
+// Real-time frame intensity to 8-bit RGBA, len pixels, dst is len * 4 bytes
+// Gray = src[i] * 255 truncated and clamped to [0, 255], alpha 255 where
+//   src[i] > 0, the colormap is applied by the real-time shader
+void simdIntensityToRgba_32f(const float *src, unsigned char *dst, int len);
+
+#endif // SIMD_KERNELS_H
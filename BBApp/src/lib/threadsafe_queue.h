@@ -2,66 +2,183 @@
 #define THREADSAFE_QUEUE_H
 
 #include "bb_lib.h"
+#include "macros.h"
 
-#include <mutex>
 #include <array>
 #include <atomic>
+#include <thread>
 
-// "Queue" is implemented as a array with rolling indices
-// This is to reduce memory (de)allocation
-// Only used for storing a circular buffer of vectors for
-//   a real-time trace buffer
+// Single producer / single consumer ring of preallocated items
+// Items are written and read in place to avoid (de)allocation,
+//   used for the persistence/waterfall trace buffer
+//
+// Producer: AcquireWrite(), fill item, CommitWrite()
+// Consumer: AcquireRead(), use item, ReleaseRead(), until
+//   AcquireRead() returns nullptr
+//
+// An item is never handed to the producer while the consumer holds
+//   it, a read can not be torn by a concurrent write.
+// Indices are free running and wrap as unsigned integers.
+//
+// Memory order: head is released on commit and acquired by the consumer
+//   so item contents are visible. tail is advanced with acq_rel RMWs and
+//   acquired by the producer, which makes the consumer's claim in reading
+//   visible with it. ReleaseRead() releases reading so the consumer's
+//   reads finish before the producer reuses the slot. Counters are relaxed.
 
-// Manually synchronized, push new things on the front
-//   before incrementing the size.
-// Pull things off the back, incrementing each time, until
-//   a nullptr is returned.
+#define QUEUE_CACHE_LINE 64
+
+enum QueuePolicy {
+    // A full queue drops the oldest unread item
+    // If the consumer holds the slot that would be written, the new
+    //   item is dropped instead
+    QueueOverwriteOldest,
+    // A full queue blocks the producer until the consumer releases an item
+    // Only use when the consumer is guaranteed to run
+    QueueBlock
+};
+
+struct QueueCounters {
+    unsigned long long produced; // Committed by the producer
+    unsigned long long consumed; // Acquired by the consumer
+    unsigned long long dropped; // Overwritten or rejected when full
+};
 
 template<class _Type, int _Size>
 class ThreadSafeQueue {
 public:
-    ThreadSafeQueue() {
-        front = 0;
-        back = 0;
+    ThreadSafeQueue(QueuePolicy queuePolicy = QueueOverwriteOldest) :
+        policy(queuePolicy)
+    {
+        static_assert(_Size > 1, "ThreadSafeQueue requires at least two items");
+        head = 0;
+        produced = 0;
+        dropped = 0;
+        tail = 0;
+        reading = NOT_READING;
+        consumed = 0;
     }
 
     ~ThreadSafeQueue() {}
 
-    _Type* Front() {
-        return &safe_queue[front];
+    // Producer, returns the item to fill or nullptr if the new item
+    //   was dropped. Must be followed by CommitWrite() when non-null.
+    _Type* AcquireWrite() {
+        unsigned int h = head.load(std::memory_order_relaxed);
+
+        while(true) {
+            unsigned int t = tail.load(std::memory_order_acquire);
+            if(h - t >= (unsigned int)_Size) {
+                if(policy == QueueBlock) {
+                    std::this_thread::yield();
+                } else if(tail.compare_exchange_strong(t, t + 1,
+                                                       std::memory_order_acq_rel,
+                                                       std::memory_order_acquire)) {
+                    // The consumer had not claimed the oldest item
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                }
+                continue;
+            }
+
+            // A claimed item is always behind the tail, once there is
+            //   room only an item claimed earlier can alias the write slot
+            if(reading.load(std::memory_order_acquire) == (h % _Size)) {
+                if(policy == QueueBlock) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+
+            return &ring[h % _Size];
+        }
+    }
+
+    // Producer, publish the item returned by AcquireWrite()
+    void CommitWrite() {
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        produced.fetch_add(1, std::memory_order_relaxed);
     }
 
-    // Front allowed to wrap on back
-    // This would be a loss of data
-    void IncrementFront() {
-        if(front >= (_Size-1)) {
-            front = 0;
-        } else {
-            front += 1;
+    // Consumer, returns the oldest unread item or nullptr if empty
+    // Must be followed by ReleaseRead() when non-null
+    const _Type* AcquireRead() {
+        while(true) {
+            unsigned int t = tail.load(std::memory_order_relaxed);
+            if(t == head.load(std::memory_order_acquire)) {
+                return nullptr;
+            }
+
+            // Mark the slot before claiming so the producer never
+            //   sees it unmarked while it is owned by the consumer,
+            //   the claim releases the mark
+            reading.store(t % _Size, std::memory_order_relaxed);
+            if(tail.compare_exchange_strong(t, t + 1,
+                                            std::memory_order_acq_rel,
+                                            std::memory_order_relaxed)) {
+                consumed.fetch_add(1, std::memory_order_relaxed);
+                return &ring[t % _Size];
+            }
+            // Producer overwrote the oldest item, try the next one
+            reading.store(NOT_READING, std::memory_order_relaxed);
         }
     }
 
-    _Type* Back() {
-        if(back == front)
-            return nullptr;
-        return &safe_queue[back];
+    // Consumer, return the item from AcquireRead() to the producer
+    void ReleaseRead() {
+        reading.store(NOT_READING, std::memory_order_release);
     }
 
-    void IncrementBack() {
-        if(back == front)
-            return;
-        if(back >= (_Size-1)) {
-            back = 0;
-        } else {
-            back += 1;
+    // Consumer, skip all unread items without counting them as consumed
+    void Discard() {
+        unsigned int t = tail.load(std::memory_order_relaxed);
+        unsigned int h = head.load(std::memory_order_acquire);
+        while(t != h && !tail.compare_exchange_weak(t, h, std::memory_order_acq_rel,
+                                                    std::memory_order_relaxed)) {
+            h = head.load(std::memory_order_acquire);
         }
     }
 
+    // Safe from either thread, values are a snapshot
+    QueueCounters Counters() const {
+        QueueCounters c;
+        c.produced = produced.load(std::memory_order_relaxed);
+        c.consumed = consumed.load(std::memory_order_relaxed);
+        c.dropped = dropped.load(std::memory_order_relaxed);
+        return c;
+    }
+
+    // Approximate number of unread items
+    int Count() const {
+        return (int)(head.load(std::memory_order_relaxed) -
+                     tail.load(std::memory_order_relaxed));
+    }
     int Size() const { return _Size; }
+    QueuePolicy Policy() const { return policy; }
+
+private:
+    static const unsigned int NOT_READING = 0xFFFFFFFF;
+
+    const QueuePolicy policy;
+
+    // Producer owned, padded away from the consumer indices
+    char padStart[QUEUE_CACHE_LINE];
+    std::atomic<unsigned int> head;
+    std::atomic<unsigned long long> produced, dropped;
+    char padProducer[QUEUE_CACHE_LINE];
+
+    // Consumer owned, tail is also advanced by the producer when
+    //   overwriting the oldest item
+    std::atomic<unsigned int> tail;
+    std::atomic<unsigned int> reading; // Slot held by the consumer
+    std::atomic<unsigned long long> consumed;
+    char padConsumer[QUEUE_CACHE_LINE];
+
+    std::array<_Type, _Size> ring;
 
 private:
-    std::atomic<int> front, back;
-    std::array<_Type, _Size> safe_queue;
+    DISALLOW_COPY_AND_ASSIGN(ThreadSafeQueue)
 };
 
 #endif // THREADSAFE_QUEUE_H
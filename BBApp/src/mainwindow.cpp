@@ -6,8 +6,10 @@
 #include "widgets/measuring_receiver_dialog.h"
 #include "widgets/if_output_dialog.h"
 #include "widgets/self_test_dialog.h"
+#include "widgets/device_monitor_dialog.h"
 
 #include "version.h"
+#include "lib/perf_timer.h"
 
 #include <QFile>
 #include <QSplitter>
@@ -16,10 +18,12 @@
 #include <QInputDialog>
 #include <QtPrintSupport>
 #include <QMessageBox>
+#include <QTimer>
 
 static const QString utilitiesTgControlString = "Tracking Generator Controls";
 static const QString utilitiesIFOutputString = "SA124 IF Output";
 static const QString utilitiesSelfTestString = "Self Test";
+static const QString utilitiesDeviceMonitorString = "Multi-Device Monitor";
 
 // Static status bar
 BBStatusBar *MainWindow::status_bar;
@@ -66,6 +70,24 @@ MainWindow::MainWindow(QWidget *parent)
     status_bar = new BBStatusBar();
     setStatusBar(status_bar);
 
+    perfTimer = new QTimer(this);
+    perfTimer->setInterval(1000);
+    connect(perfTimer, SIGNAL(timeout()), this, SLOT(updatePerfStats()));
+    perfCsvPath = QString::fromLocal8Bit(qgetenv("BBAPP_PERF_CSV"));
+    if(perfCsvPath.isEmpty()) {
+        perfCsvPath = session->prefs.perfCsvPath;
+    }
+    // Environment overrides the preference without saving it
+    bool perfEnabled = session->prefs.perfStatsEnabled;
+    QByteArray perfEnv = qgetenv("BBAPP_PERF");
+    if(!perfEnv.isEmpty()) {
+        perfEnabled = (perfEnv != "0");
+    }
+    PerfStats::Instance().SetEnabled(perfEnabled);
+    if(perfEnabled) {
+        perfTimer->start();
+    }
+
     InitMenuBar();
 
     QToolBar *toolBar = new QToolBar();
@@ -270,6 +292,12 @@ void MainWindow::InitMenuBar()
     manual_gain->setCheckable(true);
     connect(manual_gain, SIGNAL(toggled(bool)), sweep_panel, SLOT(enableManualGainAtten(bool)));
     connect(manual_gain, SIGNAL(toggled(bool)), demodPanel, SLOT(enableManualGainAtten(bool)));
+    QAction *perf_action = settings_menu->addAction(tr("Show Performance Stats"));
+    perf_action->setCheckable(true);
+    connect(perf_action, SIGNAL(triggered(bool)), this, SLOT(enablePerfStats(bool)));
+    QAction *stitch_action = settings_menu->addAction(tr("Stitch Sweeps Across Devices"));
+    stitch_action->setCheckable(true);
+    connect(stitch_action, SIGNAL(triggered(bool)), this, SLOT(enableStitchedSweeps(bool)));
     connect(settings_menu, SIGNAL(aboutToShow()), this, SLOT(aboutToShowSettingsMenu()));
 
     // Mode Select Menu
@@ -324,6 +352,7 @@ void MainWindow::InitMenuBar()
     utilities_menu->addAction(tgPanel->toggleEnableAction());
     utilities_menu->addAction(utilitiesIFOutputString, this, SLOT(startSA124IFOutput()));
     utilities_menu->addAction(utilitiesSelfTestString, this, SLOT(startSelfTest()));
+    utilities_menu->addAction(utilitiesDeviceMonitorString, this, SLOT(startDeviceMonitor()));
     connect(utilities_menu, SIGNAL(aboutToShow()), this, SLOT(aboutToShowUtilitiesMenu()));
 
     help_menu = main_menu->addMenu(tr("Help"));
@@ -449,6 +478,12 @@ void MainWindow::aboutToShowSettingsMenu()
         if(a->text() == tr("Spur Reject")) {
             a->setChecked(session->sweep_settings->Rejection());
         }
+        if(a->text() == tr("Show Performance Stats")) {
+            a->setChecked(PerfStats::Instance().Enabled());
+        }
+        if(a->text() == tr("Stitch Sweeps Across Devices")) {
+            a->setChecked(session->prefs.stitchedSweeps);
+        }
     }
 }
 
@@ -513,6 +548,8 @@ void MainWindow::OpenDevice(QMap<QString, QVariant> devInfoMap)
     QString openLabel;
     if(devInfoMap["Series"].toInt() == saSeries) {
         openLabel = "Connecting Device\nEstimated 6 seconds\n";
+    } else if(devInfoMap["Series"].toInt() == simSeries) {
+        openLabel = "Connecting Simulator";
     } else {
         openLabel = "Connecting Device\nEstimated 3 seconds";
     }
@@ -520,12 +557,10 @@ void MainWindow::OpenDevice(QMap<QString, QVariant> devInfoMap)
     SHProgressDialog pd(openLabel, this);
     pd.show();
 
-    Device *device;
-    if(devInfoMap["Series"].toInt() == saSeries) {
-        device = new DeviceSA(&session->prefs);
-    } else {
-        device = new DeviceBB60A(&session->prefs);
-    }
+    // Additional devices must match the primary device series
+    session->RemoveAllDevices();
+
+    Device *device = session->CreateDevice((DeviceSeries)devInfoMap["Series"].toInt());
 
     // Replace the old device with the new one
     Device *tempDevice = session->device;
@@ -571,7 +606,10 @@ void MainWindow::Preset()
 
     QMap<QString, QVariant> devInfoMap;
     DeviceType devType = session->device->GetDeviceType();
-    if(devType == DeviceTypeBB60A || devType == DeviceTypeBB60C) {
+    if(session->device->IsSimulated()) {
+        devInfoMap["Series"] = simSeries;
+        devInfoMap["SerialNumber"] = session->device->SerialNumber();
+    } else if(devType == DeviceTypeBB60A || devType == DeviceTypeBB60C) {
         devInfoMap["Series"] = bbSeries;
         if(devType == DeviceTypeBB60A) {
             devInfoMap["SerialNumber"] = 0;
@@ -632,11 +670,7 @@ void MainWindow::connectDeviceUponOpen()
     DeviceConnectionInfo item = list.at(0);
     QMap<QString, QVariant> devInfo;
 
-    if(item.series == saSeries) {
-        devInfo["Series"] = saSeries;
-    } else {
-        devInfo["Series"] = bbSeries;
-    }
+    devInfo["Series"] = item.series;
     devInfo["SerialNumber"] = item.serialNumber;
 
     OpenDevice(devInfo);
@@ -667,6 +701,9 @@ void MainWindow::populateConnectMenu()
         if(item.series == saSeries) {
             label += "SA44/124:  ";
             infoMap["Series"] = saSeries;
+        } else if(item.series == simSeries) {
+            label += "Simulator:  ";
+            infoMap["Series"] = simSeries;
         } else {
             label += "BB60C:  ";
             infoMap["Series"] = bbSeries;
@@ -699,6 +736,8 @@ void MainWindow::disconnectDevice()
     session->LoadDefaults();
     session->trace_manager->Reset();
 
+    // Additional devices must match the primary device series
+    session->RemoveAllDevices();
     session->device->CloseDevice();
 
     status_bar->SetMessage("");
@@ -736,6 +775,8 @@ void MainWindow::deviceConnected(bool success)
         session->LoadDefaults();
         connect(session->device, SIGNAL(connectionIssues()),
                 this, SLOT(forceDisconnectDevice()));
+        connect(session->device, SIGNAL(diagnosticsChanged(const QString&)),
+                status_bar, SLOT(SetDiagnostics(const QString&)), Qt::UniqueConnection);
 
         sweep_panel->DeviceConnected(session->device->GetDeviceType());
 
@@ -1036,6 +1077,14 @@ void MainWindow::startSelfTest()
     centralStack->CurrentWidget()->changeMode(temp_mode);
 }
 
+// Non-modal, the primary device continues sweeping
+void MainWindow::startDeviceMonitor()
+{
+    DeviceMonitorDialog *dlg = new DeviceMonitorDialog(session, this);
+    dlg->setAttribute(Qt::WA_DeleteOnClose);
+    dlg->show();
+}
+
 void MainWindow::aboutToShowTimebaseMenu()
 {
     for(QAction *a : timebase_menu->actions()) {
@@ -1063,6 +1112,44 @@ void MainWindow::showPreferencesDialog()
     prefDlg.exec();
 }
 
+void MainWindow::enablePerfStats(bool enable)
+{
+    session->prefs.perfStatsEnabled = enable;
+    PerfStats::Instance().SetEnabled(enable);
+
+    if(enable) {
+        // Discard samples from before the stats were shown
+        PerfSnapshot snapshot;
+        PerfStats::Instance().Snapshot(snapshot);
+        perfTimer->start();
+    } else {
+        perfTimer->stop();
+        status_bar->SetPerformance(QString());
+    }
+}
+
+// Takes effect on the next sweep reconfigure
+void MainWindow::enableStitchedSweeps(bool enable)
+{
+    session->prefs.stitchedSweeps = enable;
+    session->sweep_settings->EmitUpdated();
+}
+
+void MainWindow::updatePerfStats()
+{
+    PerfSnapshot snapshot;
+    PerfStats::Instance().Snapshot(snapshot);
+    status_bar->SetPerformance(PerfStats::Summary(snapshot));
+
+    if(!perfCsvPath.isEmpty()) {
+        if(!PerfStats::AppendCsv(perfCsvPath, snapshot)) {
+            // Stop trying after the first failure
+            status_bar->SetMessage(tr("Unable to write ") + perfCsvPath);
+            perfCsvPath.clear();
+        }
+    }
+}
+
 // String for our "About" box
 QChar trademark_char(short(174));
 QChar copyright_char(short(169));
@@ -19,6 +19,8 @@
 #include "views/tg_central.h"
 #include "views/phase_noise_central.h"
 
+class QTimer;
+
 class MainWindow : public QMainWindow {
     Q_OBJECT
 
@@ -75,6 +77,9 @@ private:
     PhaseNoiseCentral *phaseNoiseCentral;
 
     static BBStatusBar *status_bar;
+    // Refreshes the performance stats in the status bar
+    QTimer *perfTimer;
+    QString perfCsvPath;
 
     // Used for opening/closing BB60
     //std::thread device_thread;
@@ -126,9 +131,13 @@ private slots:
     void startMeasuringReceiever();
     void startSA124IFOutput();
     void startSelfTest();
+    void startDeviceMonitor();
     void aboutToShowTimebaseMenu();
     void timebaseChanged(QAction *a);
     void showPreferencesDialog();
+    void enablePerfStats(bool enable);
+    void updatePerfStats();
+    void enableStitchedSweeps(bool enable);
     void showAboutBox();
 
 signals:
@@ -0,0 +1,173 @@
+#include "channel_power.h"
+#include "lib/bb_lib.h"
+
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+
+// Plans larger than this are truncated
+static const int MAX_CHANNEL_COUNT = 4096;
+
+ChannelPower::ChannelPower() :
+    enabled(false),
+    planType(ChannelPlanAdjacent),
+    reference(-1)
+{
+
+}
+
+ChannelPower::~ChannelPower()
+{
+
+}
+
+void ChannelPower::Configure(bool ch_enable, double ch_width, double ch_spacing)
+{
+    QMutexLocker guard(&lock);
+
+    channels.clear();
+    channels.push_back(ChannelDef(-ch_spacing, ch_width));
+    channels.push_back(ChannelDef(0.0, ch_width));
+    channels.push_back(ChannelDef(ch_spacing, ch_width));
+    channels[0].label = "Lower";
+    channels[1].label = "Main";
+    channels[2].label = "Upper";
+
+    SetPlan(ch_enable, ChannelPlanAdjacent, 1);
+}
+
+void ChannelPower::ConfigureRaster(bool ch_enable, double first_center,
+                                   double ch_spacing, double ch_width, int count)
+{
+    QMutexLocker guard(&lock);
+
+    bb_lib::clamp(count, 1, MAX_CHANNEL_COUNT);
+
+    channels.clear();
+    for(int i = 0; i < count; i++) {
+        channels.push_back(ChannelDef(first_center + i * ch_spacing, ch_width));
+        channels.back().label = QString::number(i + 1);
+    }
+
+    SetPlan(ch_enable, ChannelPlanRaster, -1);
+}
+
+void ChannelPower::ConfigureCustom(bool ch_enable, const std::vector<ChannelDef> &plan,
+                                   int ref_channel)
+{
+    QMutexLocker guard(&lock);
+
+    channels = plan;
+    if((int)channels.size() > MAX_CHANNEL_COUNT) {
+        channels.resize(MAX_CHANNEL_COUNT);
+    }
+
+    SetPlan(ch_enable, ChannelPlanCustom, ref_channel);
+}
+
+// Call with the lock held
+void ChannelPower::SetPlan(bool ch_enable, ChannelPlanType type, int ref_channel)
+{
+    enabled = ch_enable;
+    planType = type;
+    reference = (ref_channel < (int)channels.size()) ? ref_channel : -1;
+
+    results.resize(channels.size());
+    for(size_t i = 0; i < results.size(); i++) {
+        results[i].label = channels[i].label;
+        results[i].start = results[i].stop = 0.0;
+        results[i].power = results[i].relative = 0.0;
+        results[i].inView = false;
+    }
+}
+
+bool ChannelPower::ImportPlan(const QString &fileName, std::vector<ChannelDef> &plan)
+{
+    QFile file(fileName);
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return false;
+    }
+
+    plan.clear();
+    QTextStream in(&file);
+
+    while(!in.atEnd()) {
+        QStringList fields = in.readLine().split(',');
+        if(fields.size() < 2) {
+            continue;
+        }
+
+        // Skip headers and malformed rows
+        bool centerOk, widthOk;
+        double center = fields[0].trimmed().toDouble(&centerOk);
+        double width = fields[1].trimmed().toDouble(&widthOk);
+        if(!centerOk || !widthOk || width <= 0.0) {
+            continue;
+        }
+
+        plan.push_back(ChannelDef(center * 1.0e6, width * 1.0e6));
+        plan.back().label = (fields.size() > 2) ? fields[2].trimmed() :
+                                                  QString::number(plan.size());
+    }
+
+    return !plan.empty();
+}
+
+bool ChannelPower::ExportResults(const QString &fileName) const
+{
+    QFile file(fileName);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return false;
+    }
+
+    std::vector<ChannelResult> copy;
+    GetResults(copy);
+
+    QTextStream out(&file);
+    out << "Channel, Center MHz, Width MHz, Power, Relative, In View\n";
+    for(const ChannelResult &r : copy) {
+        out << r.label << ", "
+            << (r.start + r.stop) * 0.5e-6 << ", "
+            << (r.stop - r.start) * 1.0e-6 << ", "
+            << r.power << ", "
+            << r.relative << ", "
+            << (r.inView ? 1 : 0) << "\n";
+    }
+
+    return true;
+}
+
+void ChannelPower::Update(const Trace *trace)
+{
+    if(!enabled) return;
+
+    QMutexLocker guard(&lock);
+
+    // Adjacent plans follow the sweep center
+    double offset = (planType == ChannelPlanAdjacent) ?
+                trace->GetSettings()->Center() : 0.0;
+
+    for(size_t i = 0; i < channels.size(); i++) {
+        ChannelResult &r = results[i];
+        r.start = offset + channels[i].center - channels[i].width / 2.0;
+        r.stop = r.start + channels[i].width;
+        r.inView = trace->GetChannelPower(r.start, r.stop, &r.power);
+    }
+
+    bool refValid = (reference >= 0 && results[reference].inView);
+    for(size_t i = 0; i < results.size(); i++) {
+        results[i].relative = refValid ? results[i].power - results[reference].power : 0.0;
+    }
+}
+
+int ChannelPower::ChannelCount() const
+{
+    QMutexLocker guard(&lock);
+    return channels.size();
+}
+
+void ChannelPower::GetResults(std::vector<ChannelResult> &out) const
+{
+    QMutexLocker guard(&lock);
+    out = results;
+}
@@ -0,0 +1,87 @@
+#ifndef CHANNEL_POWER_H
+#define CHANNEL_POWER_H
+
+#include <vector>
+
+#include <QMutex>
+#include <QString>
+
+#include "trace.h"
+
+enum ChannelPlanType {
+    ChannelPlanAdjacent = 0, // Main channel at center with one channel each side
+    ChannelPlanRaster, // Equal width channels at a regular spacing
+    ChannelPlanCustom // Imported list of channels
+};
+
+// One channel of a plan
+struct ChannelDef {
+    ChannelDef(double c = 0.0, double w = 0.0) : center(c), width(w) {}
+
+    double center; // Hz, offset from the sweep center in adjacent plans
+    double width; // Hz
+    QString label;
+};
+
+// Measurement of one channel for the last sweep
+struct ChannelResult {
+    QString label;
+    double start, stop; // Hz
+    double power; // dBm, mV in linear scale
+    double relative; // Power minus the reference channel power, dBc or mV
+    bool inView; // Channel entirely within the sweep
+};
+
+/*
+ * Channel power for an arbitrary channel plan
+ * Every channel is read from the cumulative linear power of the sweep,
+ *   one pass over the trace and then two lookups per channel, so plans
+ *   with hundreds of channels cost about the same as three.
+ * Configured from the GUI thread and updated from the sweep thread,
+ *   results are read through copies from GetResults().
+ */
+class ChannelPower {
+public:
+    ChannelPower();
+    ~ChannelPower();
+
+    // Main channel and one adjacent channel each side of center
+    void Configure(bool ch_enable, double ch_width, double ch_spacing);
+    // count channels, the first centered at first_center
+    void ConfigureRaster(bool ch_enable, double first_center,
+                         double ch_spacing, double ch_width, int count);
+    // Absolute channel centers, reference < 0 for no relative power
+    void ConfigureCustom(bool ch_enable, const std::vector<ChannelDef> &plan,
+                         int ref_channel);
+
+    // CSV rows of center MHz, width MHz and an optional label
+    // Returns false if the file can not be read or has no channels
+    static bool ImportPlan(const QString &fileName, std::vector<ChannelDef> &plan);
+    // Last results as CSV, returns false if the file can not be written
+    bool ExportResults(const QString &fileName) const;
+
+    void Update(const Trace *trace);
+
+    bool IsEnabled() const { return enabled; }
+    ChannelPlanType PlanType() const { return planType; }
+    int ReferenceChannel() const { return reference; }
+    int ChannelCount() const;
+
+    // Copy of the last results
+    void GetResults(std::vector<ChannelResult> &out) const;
+
+private:
+    void SetPlan(bool ch_enable, ChannelPlanType type, int ref_channel);
+
+    mutable QMutex lock;
+    bool enabled;
+    ChannelPlanType planType;
+    int reference;
+    std::vector<ChannelDef> channels;
+    std::vector<ChannelResult> results;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(ChannelPower)
+};
+
+#endif // CHANNEL_POWER_H
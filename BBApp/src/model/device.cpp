@@ -2,6 +2,7 @@
 #define DEVICE_CPP
 
 #include "device.h"
+#include "device_sim.h"
 #include "lib/bb_api.h"
 #include "lib/sa_api.h"
 
@@ -27,6 +28,12 @@ QList<DeviceConnectionInfo> Device::GetDeviceList() const
         deviceList.push_back(info);
     }
 
+    if(DeviceSim::IsEnabled(prefs)) {
+        info.series = simSeries;
+        info.serialNumber = DeviceSim::SIM_SERIAL_NUMBER;
+        deviceList.push_back(info);
+    }
+
     return deviceList;
 }
 
@@ -22,7 +22,8 @@ class Preferences;
 
 enum DeviceSeries {
     saSeries,
-    bbSeries
+    bbSeries,
+    simSeries
 };
 
 // Calibration state regarding the initial store through
@@ -89,6 +90,7 @@ public:
     virtual bool SetTg(Frequency freq, double amp) { return false; }
 
     virtual bool CanPerformSelfTest() const { return false; }
+    virtual bool IsSimulated() const { return false; }
 
     virtual void TgStoreThrough() {}
     virtual void TgStoreThroughPad() {}
@@ -153,6 +155,8 @@ public slots:
 
 signals:
     void connectionIssues();
+    // Diagnostics string for the status bar, may be emitted from any thread
+    void diagnosticsChanged(const QString &diagnostics);
 
 private:
     DISALLOW_COPY_AND_ASSIGN(Device)
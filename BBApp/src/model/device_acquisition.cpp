@@ -0,0 +1,128 @@
+#include "device_acquisition.h"
+#include "lib/perf_timer.h"
+
+DeviceAcquisition::DeviceAcquisition(Device *openedDevice,
+                                     const DeviceConnectionInfo &connectionInfo,
+                                     const SweepSettings &initialSettings) :
+    device(openedDevice),
+    info(connectionInfo),
+    traceManager(new TraceManager()),
+    running(false),
+    reconfigure(true),
+    sweepCount(0),
+    settings(initialSettings),
+    haveConfig(false),
+    trace(true),
+    havePeak(false),
+    peakFreq(0.0),
+    peakAmp(0.0)
+{
+    // Only the swept modes are supported for additional devices
+    if(settings.Mode() != MODE_REAL_TIME) {
+        settings.setMode(MODE_SWEEPING);
+    }
+}
+
+DeviceAcquisition::~DeviceAcquisition()
+{
+    Stop();
+    device->CloseDevice();
+
+    delete device;
+    delete traceManager;
+}
+
+void DeviceAcquisition::Start()
+{
+    if(threadHandle.joinable()) {
+        return;
+    }
+
+    sweepCount = 0;
+    reconfigure = true;
+    running = true;
+    threadHandle = std::thread(&DeviceAcquisition::AcquisitionThread, this);
+}
+
+void DeviceAcquisition::Stop()
+{
+    running = false;
+    if(threadHandle.joinable()) {
+        threadHandle.join();
+    }
+}
+
+void DeviceAcquisition::SetSweepSettings(const SweepSettings &ss)
+{
+    std::lock_guard<std::mutex> lock(settingsLock);
+    settings = ss;
+    reconfigure = true;
+}
+
+SweepSettings DeviceAcquisition::GetSweepSettings() const
+{
+    std::lock_guard<std::mutex> lock(settingsLock);
+    return settings;
+}
+
+bool DeviceAcquisition::GetLastPeak(double *freq, double *amp) const
+{
+    std::lock_guard<std::mutex> lock(peakLock);
+    *freq = peakFreq;
+    *amp = peakAmp;
+    return havePeak;
+}
+
+void DeviceAcquisition::AcquisitionThread()
+{
+    while(running) {
+        if(reconfigure) {
+            SweepSettings requested = GetSweepSettings();
+            reconfigure = false;
+
+            if(device->Reconfigure(&requested, &trace)) {
+                lastConfig = requested;
+                haveConfig = true;
+            } else if(!haveConfig || !device->Reconfigure(&lastConfig, &trace)) {
+                // Neither the new nor a previously applied configuration works
+                device->Abort();
+                running = false;
+                emit connectionLost();
+                return;
+            }
+
+            traceManager->ClearAllTraces();
+        }
+
+        bool sweepSuccess;
+        {
+            PERF_SCOPE(PerfFetch);
+            sweepSuccess = device->GetSweep(&lastConfig, &trace);
+        }
+        if(!sweepSuccess) {
+            device->Abort();
+            running = false;
+            emit connectionLost();
+            return;
+        }
+
+        traceManager->UpdateTraces(&trace);
+
+        if(trace.IsFullSweep()) {
+            double freq, amp;
+            trace.GetSignalPeak(&freq, &amp);
+            {
+                std::lock_guard<std::mutex> lock(peakLock);
+                peakFreq = freq;
+                peakAmp = amp;
+                havePeak = true;
+            }
+            sweepCount++;
+            PerfStats::Instance().CountSweep();
+        }
+
+        emit updated();
+    }
+
+    device->Abort();
+}
@@ -0,0 +1,78 @@
+#ifndef DEVICE_ACQUISITION_H
+#define DEVICE_ACQUISITION_H
+
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+#include "device.h"
+#include "sweep_settings.h"
+#include "trace_manager.h"
+
+/*
+ * A device opened in addition to the session's primary device
+ * Sweeps on its own thread with its own settings into a private
+ *   TraceManager, shown by the DeviceTraceDialog, and publishes a
+ *   summary of each full sweep for the device monitor.
+ */
+class DeviceAcquisition : public QObject {
+    Q_OBJECT
+
+public:
+    // Takes ownership of an opened device
+    DeviceAcquisition(Device *openedDevice,
+                      const DeviceConnectionInfo &connectionInfo,
+                      const SweepSettings &initialSettings);
+    ~DeviceAcquisition();
+
+    void Start();
+    void Stop();
+    bool IsRunning() const { return running; }
+
+    const DeviceConnectionInfo& ConnectionInfo() const { return info; }
+    Device* GetDevice() { return device; }
+    // Lock() the manager while reading its traces
+    TraceManager* GetTraceManager() { return traceManager; }
+
+    // Settings are applied by the acquisition thread before the next sweep
+    void SetSweepSettings(const SweepSettings &ss);
+    SweepSettings GetSweepSettings() const;
+
+    // Completed full sweeps since Start()
+    long long SweepCount() const { return sweepCount; }
+    // Peak of the most recent full sweep, false if none yet
+    bool GetLastPeak(double *freq, double *amp) const;
+
+signals:
+    // New sweep processed, emitted from the acquisition thread
+    void updated();
+    // Acquisition ended due to a device error
+    void connectionLost();
+
+private:
+    void AcquisitionThread();
+
+    Device *device;
+    DeviceConnectionInfo info;
+    TraceManager *traceManager;
+
+    std::thread threadHandle;
+    std::atomic<bool> running;
+    std::atomic<bool> reconfigure;
+    std::atomic<long long> sweepCount;
+
+    mutable std::mutex settingsLock;
+    SweepSettings settings; // Requested, guarded by settingsLock
+    SweepSettings lastConfig; // Applied, acquisition thread only
+    bool haveConfig; // lastConfig has been applied successfully
+    Trace trace;
+
+    mutable std::mutex peakLock;
+    bool havePeak;
+    double peakFreq, peakAmp;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(DeviceAcquisition)
+};
+
+#endif // DEVICE_ACQUISITION_H
@@ -1,8 +1,16 @@
 #include "device_bb60a.h"
 #include "mainwindow.h"
+#include "lib/perf_timer.h"
+#include "lib/simd_kernels.h"
 
 #include <QElapsedTimer>
 
+// Diagnostics polling interval, 2 Hz
+static const int DIAGNOSTICS_POLL_MS = 500;
+// Longest the monitor waits for the device between fetches, a poll
+//   that can not get the device is skipped until the next interval
+static const int DIAGNOSTICS_LOCK_WAIT_MS = 50;
+
 #define STATUS_CHECK(status) \
     lastStatus = status; \
     if(lastStatus < bbNoError) { \
@@ -20,6 +28,20 @@ DeviceBB60A::DeviceBB60A(const Preferences *preferences) :
     timebase_reference = TIMEBASE_INTERNAL;
 
     last_audio_freq = -1.0e6;
+
+    sweepConfigValid = false;
+    sweepInitiated = false;
+    sweepTraceSize = 0;
+    sweepBinSize = 0.0;
+    sweepStartFreq = 0.0;
+
+    diagStop = true;
+    diagTemp = 0.0;
+    diagVoltage = 0.0;
+    diagCurrent = 0.0;
+    diagWaiting = false;
+    shownTemp = 0.0;
+    shownVoltage = 0.0;
 }
 
 DeviceBB60A::~DeviceBB60A()
@@ -51,6 +73,7 @@ bool DeviceBB60A::OpenDevice()
     }
 
     open = true;
+    StartDiagnostics();
     return true;
 }
 
@@ -78,6 +101,7 @@ bool DeviceBB60A::OpenDeviceWithSerial(int serialToOpen)
     }
 
     open = true;
+    StartDiagnostics();
     return true;
 }
 
@@ -87,6 +111,7 @@ int DeviceBB60A::GetNativeDeviceType() const
         return BB_DEVICE_BB60C;
     }
 
+    std::lock_guard<std::recursive_timed_mutex> guard(apiMutex);
     int type;
     bbGetDeviceType(id, &type);
     return type;
@@ -99,7 +124,12 @@ bool DeviceBB60A::CloseDevice()
         return false;
     }
 
+    StopDiagnostics();
+
+    std::lock_guard<std::recursive_timed_mutex> guard(apiMutex);
     bbCloseDevice(id);
+    sweepConfigValid = false;
+    sweepInitiated = false;
 
     id = -1;
     open = false;
@@ -116,6 +146,8 @@ bool DeviceBB60A::Abort()
         return false;
     }
 
+    std::lock_guard<std::recursive_timed_mutex> guard(apiMutex);
+    sweepInitiated = false;
     STATUS_CHECK(bbAbort(id));
     return true;
 }
@@ -127,8 +159,14 @@ bool DeviceBB60A::Preset()
         return false;
     }
 
-    bbAbort(id);
-    bbPreset(id);
+    // No diagnostics poll during the preset and the device reset
+    StopDiagnostics();
+
+    {
+        std::lock_guard<std::recursive_timed_mutex> guard(apiMutex);
+        bbAbort(id);
+        bbPreset(id);
+    }
 
     // Need to call bbCloseDevice for BB60A/C
     CloseDevice();
@@ -141,69 +179,129 @@ bool DeviceBB60A::Preset()
 
 bool DeviceBB60A::Reconfigure(const SweepSettings *s, Trace *t)
 {
-    Abort();
+    PERF_SCOPE(PerfReconfigure);
+    std::lock_guard<std::recursive_timed_mutex> guard(apiMutex);
 
-    int scale = s->RefLevel().IsLogScale() ?
+    BBSweepConfig config;
+
+    config.scale = s->RefLevel().IsLogScale() ?
                 BB_LOG_SCALE : BB_LIN_SCALE;
-    int detector = (s->Detector() == BB_AVERAGE) ?
+    config.detector = (s->Detector() == BB_AVERAGE) ?
                 BB_AVERAGE : BB_MIN_AND_MAX;
-    int rbw_type = (s->NativeRBW()) ?
+    config.rbwType = (s->NativeRBW()) ?
                 BB_NATIVE_RBW : BB_NON_NATIVE_RBW;
-    int rejection = (s->Rejection()) ?
+    config.rejection = (s->Rejection()) ?
                 BB_SPUR_REJECT : BB_NO_SPUR_REJECT;
-    double sweep_time = s->SweepTime().Val();
+    config.sweepTime = s->SweepTime().Val();
+    config.center = s->Center();
+    config.span = s->Span();
+    config.rbw = s->RBW();
+    config.vbw = s->VBW();
+    config.atten = (s->Atten()-1) * 10;
+    config.gain = s->Gain() - 1;
+    config.procUnits = s->ProcessingUnits();
 
-    double reference = s->RefLevel().ConvertToUnits(AmpUnits::DBM);
+    config.reference = s->RefLevel().ConvertToUnits(AmpUnits::DBM);
 
-    int port_one_mask;
     switch(timebase_reference) {
     case TIMEBASE_INTERNAL:
-        port_one_mask = 0x0;
+        config.portOneMask = 0x0;
         break;
     case TIMEBASE_EXT_AC:
-        port_one_mask = BB_PORT1_EXT_REF_IN | BB_PORT1_AC_COUPLED;
+        config.portOneMask = BB_PORT1_EXT_REF_IN | BB_PORT1_AC_COUPLED;
         break;
     case TIMEBASE_EXT_DC:
-        port_one_mask = BB_PORT1_EXT_REF_IN | BB_PORT1_DC_COUPLED;
+        config.portOneMask = BB_PORT1_EXT_REF_IN | BB_PORT1_DC_COUPLED;
         break;
     }
 
-    int mode;
+    config.rtScale = 0.0;
+    config.rtFrameRate = 0;
     switch(s->Mode()) {
     case MODE_SWEEPING: case MODE_HARMONICS:
-        mode = BB_SWEEPING;
+        config.mode = BB_SWEEPING;
         break;
     case MODE_REAL_TIME:
-        bbConfigureRealTime(id, s->Div() * 10.0, prefs->realTimeFrameRate);
-        mode = BB_REAL_TIME;
+        config.mode = BB_REAL_TIME;
+        config.rtScale = s->Div() * 10.0;
+        config.rtFrameRate = prefs->realTimeFrameRate;
         break;
     default:
         Q_ASSERT(0);
         return false;
     }
 
-    STATUS_CHECK(bbConfigureIO(id, port_one_mask, 0x0));
+    // While sweeping with gain and atten both manual the reference level
+    //   is display only, keep the level the device already has
+    // Real-time frames are scaled down from the reference, always sent
+    if(config.mode == BB_SWEEPING && s->Atten() != 0 && s->Gain() != 0 &&
+            sweepConfigValid) {
+        config.reference = sweepConfig.reference;
+    }
 
-    // Scale based on amp unit type
-    STATUS_CHECK(bbConfigureAcquisition(id, detector, scale));
-    STATUS_CHECK(bbConfigureCenterSpan(id, s->Center(), s->Span()));
-    STATUS_CHECK(bbConfigureLevel(id, reference, (s->Atten()-1) * 10));
-    STATUS_CHECK(bbConfigureSweepCoupling(id, s->RBW(), s->VBW(), sweep_time,
-                                          rbw_type, rejection));
-    STATUS_CHECK(bbConfigureWindow(id, BB_NUTALL));
-    STATUS_CHECK(bbConfigureProcUnits(id, s->ProcessingUnits()));
-    STATUS_CHECK(bbConfigureGain(id, s->Gain() - 1));
+    // Device already running with these settings, nothing to send,
+    //   the trace is still sized since it may be a fresh trace
+    if(sweepInitiated && sweepConfigValid && config == sweepConfig) {
+        t->SetSettings(*s);
+        t->SetSize(sweepTraceSize);
+        t->SetFreq(sweepBinSize, sweepStartFreq);
+        t->SetUpdateRange(0, sweepTraceSize);
+        return true;
+    }
+
+    Abort();
+
+    // Configuration persists across an abort, only send what changed
+    // Nothing is skipped after a stream/audio configuration or an error
+    bool all = !sweepConfigValid;
+    const BBSweepConfig &last = sweepConfig;
+    sweepConfigValid = false;
+
+    if(config.mode == BB_REAL_TIME && (all || config.rtScale != last.rtScale ||
+                                       config.rtFrameRate != last.rtFrameRate)) {
+        bbConfigureRealTime(id, config.rtScale, config.rtFrameRate);
+    }
+
+    if(all || config.portOneMask != last.portOneMask) {
+        STATUS_CHECK(bbConfigureIO(id, config.portOneMask, 0x0));
+    }
 
-    STATUS_CHECK(bbInitiate(id, mode, 0));
+    // Scale based on amp unit type
+    if(all || config.detector != last.detector || config.scale != last.scale) {
+        STATUS_CHECK(bbConfigureAcquisition(id, config.detector, config.scale));
+    }
+    if(all || config.center != last.center || config.span != last.span) {
+        STATUS_CHECK(bbConfigureCenterSpan(id, config.center, config.span));
+    }
+    if(all || config.reference != last.reference || config.atten != last.atten) {
+        STATUS_CHECK(bbConfigureLevel(id, config.reference, config.atten));
+    }
+    if(all || config.rbw != last.rbw || config.vbw != last.vbw ||
+            config.sweepTime != last.sweepTime || config.rbwType != last.rbwType ||
+            config.rejection != last.rejection) {
+        STATUS_CHECK(bbConfigureSweepCoupling(id, config.rbw, config.vbw, config.sweepTime,
+                                              config.rbwType, config.rejection));
+    }
+    if(all) {
+        STATUS_CHECK(bbConfigureWindow(id, BB_NUTALL));
+    }
+    if(all || config.procUnits != last.procUnits) {
+        STATUS_CHECK(bbConfigureProcUnits(id, config.procUnits));
+    }
+    if(all || config.gain != last.gain) {
+        STATUS_CHECK(bbConfigureGain(id, config.gain));
+    }
 
-    unsigned int traceSize;
-    double binSize, startFreq;
-    STATUS_CHECK(bbQueryTraceInfo(id, &traceSize, &binSize, &startFreq));
+    STATUS_CHECK(bbInitiate(id, config.mode, 0));
+    STATUS_CHECK(bbQueryTraceInfo(id, &sweepTraceSize, &sweepBinSize, &sweepStartFreq));
+    sweepConfig = config;
+    sweepConfigValid = true;
+    sweepInitiated = true;
 
     t->SetSettings(*s);
-    t->SetSize(traceSize);
-    t->SetFreq(binSize, startFreq);
-    t->SetUpdateRange(0, traceSize);
+    t->SetSize(sweepTraceSize);
+    t->SetFreq(sweepBinSize, sweepStartFreq);
+    t->SetUpdateRange(0, sweepTraceSize);
 
     if(s->Mode() == MODE_REAL_TIME) {
         int w = 0, h = 0;
@@ -212,26 +310,24 @@ bool DeviceBB60A::Reconfigure(const SweepSettings *s, Trace *t)
         rtFrameSize.setHeight(h);
     }
 
-    bbGetDeviceDiagnostics(id, &last_temp, &voltage, &current);
+    // Temperature at configuration, from the diagnostics monitor
+    UpdateDiagnostics();
+    last_temp = current_temp;
 
     return true;
 }
 
 bool DeviceBB60A::GetSweep(const SweepSettings *s, Trace *t)
 {
-    // Get new diagnostic info, determine whether to update the
-    //  diagnostic string
-    UpdateDiagnostics();
+    YieldToDiagnostics();
+    std::lock_guard<std::recursive_timed_mutex> guard(apiMutex);
 
-    // Print new diagnostics only when a value changed
-    if(update_diagnostics_string) {
-        QString diagnostics;
-        diagnostics.sprintf("%.2f C  --  %.2f V", CurrentTemp(), Voltage());
-        MainWindow::GetStatusBar()->SetDiagnostics(diagnostics);
-        update_diagnostics_string = false;
-    }
+    // Cached values only, no device round trip
+    UpdateDiagnostics();
 
     if((fabs(current_temp - last_temp) > 2.0) || reconfigure_on_next) {
+        // Full configuration, initiate recalibrates the device
+        sweepConfigValid = false;
         Reconfigure(s, t);
         reconfigure_on_next = false;
     }
@@ -262,6 +358,7 @@ bool DeviceBB60A::GetSweep(const SweepSettings *s, Trace *t)
         adc_overflow = false;
     }
 
+    t->InvalidateStats();
     return true;
 }
 
@@ -270,17 +367,11 @@ bool DeviceBB60A::GetRealTimeFrame(Trace &t, RealTimeFrame &frame)
     Q_ASSERT(frame.alphaFrame.size() == rtFrameSize.width() * rtFrameSize.height());
     Q_ASSERT(frame.rgbFrame.size() == frame.alphaFrame.size() * 4);
 
-    // Get new diagnostic info, determine whether to update the
-    //  diagnostic string
-    UpdateDiagnostics();
+    YieldToDiagnostics();
+    std::lock_guard<std::recursive_timed_mutex> guard(apiMutex);
 
-    // Print new diagnostics only when a value changed
-    if(update_diagnostics_string) {
-        QString diagnostics;
-        diagnostics.sprintf("%.2f C  --  %.2f V", CurrentTemp(), Voltage());
-        MainWindow::GetStatusBar()->SetDiagnostics(diagnostics);
-        update_diagnostics_string = false;
-    }
+    // Cached values only, no device round trip
+    UpdateDiagnostics();
 
     lastStatus = bbFetchRealTimeFrame(id, t.Max(), &frame.alphaFrame[0]);
     if(lastStatus == bbDeviceConnectionErr || lastStatus == bbUSBTimeoutErr) {
@@ -295,26 +386,20 @@ bool DeviceBB60A::GetRealTimeFrame(Trace &t, RealTimeFrame &frame)
     for(int i = 0; i < t.Length(); i++) {
         t.Min()[i] = t.Max()[i];
     }
+    t.InvalidateStats();
 
     // Convert the alpha/intensity frame to a 4 channel image
     int totalPixels = frame.dim.height() * frame.dim.width();
-    for(int i = 0; i < totalPixels; i++) {
-        int toSet = frame.alphaFrame[i] * 255;
-        if(toSet > 255) toSet = 255;
-        frame.rgbFrame[i*4] = frame.rgbFrame[i*4+1] = frame.rgbFrame[i*4+2] = toSet;
-        if(frame.alphaFrame[i] > 0.0) {
-            frame.rgbFrame[i*4+3] = 255;
-        } else {
-            frame.rgbFrame[i*4+3] = 0;
-        }
-    }
+    simdIntensityToRgba_32f(&frame.alphaFrame[0], &frame.rgbFrame[0], totalPixels);
 
     return true;
 }
 
 bool DeviceBB60A::Reconfigure(const DemodSettings *ds, IQDescriptor *desc)
-{   
+{
+    std::lock_guard<std::recursive_timed_mutex> guard(apiMutex);
     Abort();
+    sweepConfigValid = false;
 
     int gain = ds->Gain() - 1, atten = (ds->Atten() - 1) * 10.0;
     if(gain < 0) gain = BB_AUTO_GAIN;
@@ -366,6 +451,9 @@ bool DeviceBB60A::Reconfigure(const DemodSettings *ds, IQDescriptor *desc)
 
 bool DeviceBB60A::GetIQ(IQCapture *iqc)
 {
+    YieldToDiagnostics();
+    std::lock_guard<std::recursive_timed_mutex> guard(apiMutex);
+
     lastStatus = bbFetchRaw(id, (float*)(&iqc->capture[0]), iqc->triggers);
     // Handle connection issues
     if(lastStatus == bbDeviceConnectionErr || lastStatus == bbUSBTimeoutErr || lastStatus == bbPacketFramingErr) {
@@ -403,7 +491,9 @@ bool DeviceBB60A::ConfigureForTRFL(double center,
                                    int gain,
                                    IQDescriptor &desc)
 {
+    std::lock_guard<std::recursive_timed_mutex> guard(apiMutex);
     Abort();
+    sweepConfigValid = false;
 
     int port_one_mask;
     switch(timebase_reference) {
@@ -449,6 +539,9 @@ bool DeviceBB60A::ConfigureForTRFL(double center,
 
 bool DeviceBB60A::ConfigureAudio(const AudioSettings &as)
 {
+    std::lock_guard<std::recursive_timed_mutex> guard(apiMutex);
+    sweepConfigValid = false;
+    sweepInitiated = false;
     lastStatus = bbConfigureDemod(
                 id,
                 as.AudioMode(),
@@ -471,6 +564,9 @@ bool DeviceBB60A::ConfigureAudio(const AudioSettings &as)
 
 bool DeviceBB60A::GetAudio(float *audio)
 {
+    YieldToDiagnostics();
+    std::lock_guard<std::recursive_timed_mutex> guard(apiMutex);
+
     lastStatus = bbFetchAudio(id, audio);
 
     return true;
@@ -478,16 +574,106 @@ bool DeviceBB60A::GetAudio(float *audio)
 
 void DeviceBB60A::UpdateDiagnostics()
 {
-    float temp_now, voltage_now, current_now;
-    bbGetDeviceDiagnostics(id, &temp_now, &voltage_now, &current_now);
+    current_temp = diagTemp;
+    voltage = diagVoltage;
+    current = diagCurrent;
+}
 
-    if((temp_now != current_temp) || (voltage_now != voltage) || (current_now != current)) {
-        update_diagnostics_string = true;
+void DeviceBB60A::StartDiagnostics()
+{
+    StopDiagnostics();
+
+    // Values are valid before the first configuration
+    if(QueryDiagnostics()) {
+        PublishDiagnostics(true);
     }
+    UpdateDiagnostics();
+
+    diagStop = false;
+    diagThread = std::thread(&DeviceBB60A::DiagnosticsThread, this);
+}
+
+void DeviceBB60A::StopDiagnostics()
+{
+    if(!diagThread.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(diagMutex);
+        diagStop = true;
+    }
+    diagCond.notify_all();
+    diagThread.join();
+}
+
+void DeviceBB60A::DiagnosticsThread()
+{
+    std::unique_lock<std::mutex> lock(diagMutex);
+    // Status bar may not have been connected for the poll during open
+    bool first = true;
+
+    while(!diagCond.wait_for(lock, std::chrono::milliseconds(DIAGNOSTICS_POLL_MS),
+                             [this]() { return diagStop; })) {
+        lock.unlock();
+
+        // Fetches step aside while diagWaiting is set, so the device is
+        //   taken between two fetches rather than after a long wait
+        diagWaiting = true;
+        bool polled = false;
+        if(apiMutex.try_lock_for(std::chrono::milliseconds(DIAGNOSTICS_LOCK_WAIT_MS))) {
+            diagWaiting = false;
+            polled = QueryDiagnostics();
+            apiMutex.unlock();
+        }
+        diagWaiting = false;
+
+        // String and signal stay on this thread
+        if(polled) {
+            PublishDiagnostics(first);
+            first = false;
+        }
 
-    current_temp = temp_now;
-    voltage = voltage_now;
-    current = current_now;
+        lock.lock();
+    }
+}
+
+// Bounded by DIAGNOSTICS_LOCK_WAIT_MS, the monitor clears the flag
+//   once it has the device or gives up
+void DeviceBB60A::YieldToDiagnostics()
+{
+    while(diagWaiting) {
+        std::this_thread::yield();
+    }
+}
+
+bool DeviceBB60A::QueryDiagnostics()
+{
+    std::lock_guard<std::recursive_timed_mutex> guard(apiMutex);
+
+    float temp_now, voltage_now, current_now;
+    if(bbGetDeviceDiagnostics(id, &temp_now, &voltage_now, &current_now) < bbNoError) {
+        return false;
+    }
+
+    diagTemp = temp_now;
+    diagVoltage = voltage_now;
+    diagCurrent = current_now;
+    return true;
+}
+
+void DeviceBB60A::PublishDiagnostics(bool forceString)
+{
+    float temp_now = diagTemp, voltage_now = diagVoltage;
+
+    // Print new diagnostics only when a displayed value changed
+    if(forceString || (temp_now != shownTemp) || (voltage_now != shownVoltage)) {
+        QString diagnostics;
+        diagnostics.sprintf("%.2f C  --  %.2f V", temp_now, voltage_now);
+        emit diagnosticsChanged(diagnostics);
+        shownTemp = temp_now;
+        shownVoltage = voltage_now;
+    }
 }
 
 const char* DeviceBB60A::GetLastStatusString() const
@@ -1,10 +1,42 @@
 #ifndef DEVICE_BB60A_H
 #define DEVICE_BB60A_H
 
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
 #include "device.h"
 
 class Preferences;
 
+// Values last sent with the bbConfigure* functions for sweeping
+struct BBSweepConfig {
+    int portOneMask;
+    int detector, scale;
+    double center, span;
+    double reference, atten;
+    double rbw, vbw, sweepTime;
+    int rbwType, rejection;
+    int procUnits;
+    int gain;
+    int mode;
+    double rtScale;
+    int rtFrameRate;
+
+    bool operator==(const BBSweepConfig &other) const {
+        return portOneMask == other.portOneMask &&
+                detector == other.detector && scale == other.scale &&
+                center == other.center && span == other.span &&
+                reference == other.reference && atten == other.atten &&
+                rbw == other.rbw && vbw == other.vbw &&
+                sweepTime == other.sweepTime && rbwType == other.rbwType &&
+                rejection == other.rejection && procUnits == other.procUnits &&
+                gain == other.gain && mode == other.mode &&
+                rtScale == other.rtScale && rtFrameRate == other.rtFrameRate;
+    }
+};
+
 class DeviceBB60A : public Device {
 public:
     DeviceBB60A(const Preferences *preferences);
@@ -32,6 +64,7 @@ public:
     virtual const char* GetLastStatusString() const;
 
     virtual QString GetDeviceString() const;
+    // Copy the latest values published by the diagnostics monitor
     virtual void UpdateDiagnostics();
     virtual bool IsPowered() const;
     virtual bool NeedsTempCal() const { return fabs(last_temp - current_temp) > 2; }
@@ -45,6 +78,42 @@ public:
     }
 
 private:
+    // Temperature/voltage/current are polled on a background thread
+    //   instead of once per sweep
+    void StartDiagnostics();
+    void StopDiagnostics();
+    void DiagnosticsThread();
+    // Read the device into the published values, false on error
+    bool QueryDiagnostics();
+    // Status bar string from the published values, never called from
+    //   the acquisition thread
+    void PublishDiagnostics(bool forceString);
+    // Called by fetches before taking apiMutex, waits out a pending poll
+    void YieldToDiagnostics();
+
+    std::thread diagThread;
+    std::mutex diagMutex;
+    std::condition_variable diagCond;
+    bool diagStop;
+    std::atomic<float> diagTemp, diagVoltage, diagCurrent;
+    // Values in the last status bar string, monitor thread only
+    float shownTemp, shownVoltage;
+    // Set while the monitor waits for the device
+    std::atomic<bool> diagWaiting;
+
+    // Held around every API call on the handle, the API is not assumed
+    //   to be thread safe. Recursive, Reconfigure() calls Abort() etc.
+    // Timed so the diagnostics monitor can bound its wait
+    mutable std::recursive_timed_mutex apiMutex;
+
+    // Last applied sweep configuration, Reconfigure() only sends changes
+    BBSweepConfig sweepConfig;
+    bool sweepConfigValid; // Device holds sweepConfig
+    bool sweepInitiated; // Device is sweeping with sweepConfig
+    // bbQueryTraceInfo() results for sweepConfig
+    unsigned int sweepTraceSize;
+    double sweepBinSize, sweepStartFreq;
+
     // Controls whether or not we need to reinitialize the device when
     //   setting a new audio configuration
     double last_audio_freq;
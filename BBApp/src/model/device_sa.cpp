@@ -1,5 +1,6 @@
 #include "device_sa.h"
 #include "mainwindow.h"
+#include "lib/simd_kernels.h"
 
 #include <QElapsedTimer>
 
@@ -246,6 +247,7 @@ bool DeviceSA::GetSweep(const SweepSettings *s, Trace *t)
     }
 
     t->SetUpdateRange(startIx, stopIx);
+    t->InvalidateStats();
 
     if(s->Mode() == MODE_NETWORK_ANALYZER && tgCalState == tgCalStatePending) {
         if(stopIx >= t->Length()) {
@@ -276,19 +278,11 @@ bool DeviceSA::GetRealTimeFrame(Trace &t, RealTimeFrame &frame)
     for(int i = 0; i < t.Length(); i++) {
         t.Min()[i] = t.Max()[i];
     }
+    t.InvalidateStats();
 
     // Convert the alpha/intensity frame to a 4 channel image
     int totalPixels = frame.dim.height() * frame.dim.width();
-    for(int i = 0; i < totalPixels; i++) {
-        int toSet = frame.alphaFrame[i] * 255;
-        if(toSet > 255) toSet = 255;
-        frame.rgbFrame[i*4] = frame.rgbFrame[i*4+1] = frame.rgbFrame[i*4+2] = toSet;
-        if(frame.alphaFrame[i] > 0.0) {
-            frame.rgbFrame[i*4+3] = 255;
-        } else {
-            frame.rgbFrame[i*4+3] = 0;
-        }
-    }
+    simdIntensityToRgba_32f(&frame.alphaFrame[0], &frame.rgbFrame[0], totalPixels);
 
     adc_overflow = (status == saCompressionWarning);
 
@@ -0,0 +1,676 @@
+#include "device_sim.h"
+#include "preferences.h"
+#include "lib/simd_kernels.h"
+
+#include <algorithm>
+#include <thread>
+
+// Limits to keep a simulated sweep allocation sane
+static const int MAX_SIM_SWEEP_LEN = 1 << 22;
+static const int NOISE_TABLE_LEN = 4096; // Power of two
+static const int SIM_IQ_RETURN_LEN = 16384;
+static const int SIM_AUDIO_LEN = 4096;
+static const int SIM_RT_FRAME_HEIGHT = 100;
+// Real-time frames are bounded like the hardware frame, wider sweeps
+//   share columns
+static const int SIM_RT_MAX_FRAME_WIDTH = 1024;
+static const int SIM_RT_SPECTRA_PER_FRAME = 16;
+// Displayed average noise level, dBm/Hz
+static const double SIM_DANL = -158.0;
+// Approximate BB60C sweep speed for RBW >= 10kHz, Hz/sec
+static const double SIM_SWEEP_SPEED = 24.0e9;
+static const double SIM_TWO_PI = 6.283185307179586;
+
+// Sum two powers in dB
+static inline float add_db(float a, float b)
+{
+    if(a < b) std::swap(a, b);
+    return a + 10.0 * log10(1.0 + pow(10.0, (b - a) * 0.1));
+}
+
+// Noise floor penalty for the attenuation an auto-ranged
+//   front end would select at a given reference level
+static inline double range_penalty(double refLevel)
+{
+    double penalty = refLevel + 20.0;
+    bb_lib::clamp(penalty, 0.0, 30.0);
+    return penalty;
+}
+
+bool DeviceSim::IsEnabled(const Preferences *preferences)
+{
+    QByteArray env = qgetenv("BBAPP_SIMULATOR");
+    if(!env.isEmpty()) {
+        return env != "0";
+    }
+
+    return preferences->simulatorEnabled;
+}
+
+DeviceSim::DeviceSim(const Preferences *preferences) :
+    Device(preferences)
+{
+    id = -1;
+    open = false;
+    serial_number = 0;
+    timebase_reference = TIMEBASE_INTERNAL;
+    reconfigure_on_next = false;
+    adc_overflow = false;
+    update_diagnostics_string = false;
+    last_temp = 0.0;
+
+    seed = prefs->simulatorSeed;
+    timeScale = prefs->simulatorTimeScale;
+
+    // Environment overrides allow headless runs without touching preferences
+    bool ok;
+    unsigned int envSeed = qgetenv("BBAPP_SIM_SEED").toUInt(&ok);
+    if(ok) seed = envSeed;
+    double envScale = qgetenv("BBAPP_SIM_TIMESCALE").toDouble(&ok);
+    if(ok) timeScale = envScale;
+
+    mode = MODE_IDLE;
+    logScale = true;
+    avgDetector = false;
+    start = binSize = 0.0;
+    rbw = 1.0e3;
+    refLevel = -20.0;
+    divSize = 10.0;
+    noiseFloor = -130.0;
+    sweepDuration = 0.0;
+    sweepLen = 0;
+
+    iqCenter = 1.0e9;
+    iqSampleRate = 40.0e6;
+    iqInputPower = 0.0;
+    iqReturnLen = SIM_IQ_RETURN_LEN;
+    noiseAmplitude = 0.0;
+
+    audioMode = BB_DEMOD_FM;
+    audioTone = -1;
+    audioCenter = 0.0;
+    audioIFBandwidth = 0.0;
+    audioPhase = 0.0;
+
+    lastStatusString = "Device not open";
+}
+
+DeviceSim::~DeviceSim()
+{
+    CloseDevice();
+}
+
+bool DeviceSim::OpenDevice()
+{
+    return OpenDeviceWithSerial(SIM_SERIAL_NUMBER);
+}
+
+bool DeviceSim::OpenDeviceWithSerial(int)
+{
+    if(open) {
+        return true;
+    }
+
+    rng.seed(seed);
+    BuildSignalPlan();
+    BuildNoiseTables();
+
+    id = 0;
+    serial_number = SIM_SERIAL_NUMBER;
+    serial_string.sprintf("SIM-%u", seed);
+    firmware_string = "Simulated";
+    device_type = DeviceTypeBB60C;
+
+    last_temp = current_temp = 35.0;
+    voltage = 5.0;
+    current = 0.8;
+    update_diagnostics_string = true;
+
+    nextDeadline = clock::now();
+    lastStatusString = "No Error";
+    open = true;
+    return true;
+}
+
+int DeviceSim::GetNativeDeviceType() const
+{
+    return BB_DEVICE_BB60C;
+}
+
+bool DeviceSim::CloseDevice()
+{
+    if(!open) {
+        lastStatusString = "Device not open";
+        return false;
+    }
+
+    id = -1;
+    open = false;
+    serial_number = 0;
+    mode = MODE_IDLE;
+
+    return true;
+}
+
+bool DeviceSim::Abort()
+{
+    if(!open) {
+        lastStatusString = "Device not open";
+        return false;
+    }
+
+    mode = MODE_IDLE;
+    return true;
+}
+
+bool DeviceSim::Preset()
+{
+    if(!open) {
+        lastStatusString = "Device not open";
+        return false;
+    }
+
+    Abort();
+    CloseDevice();
+
+    return true;
+}
+
+// One modulated carrier at the default demod frequency, its harmonics,
+//   and a seeded scatter of CW tones across the full span
+void DeviceSim::BuildSignalPlan()
+{
+    tones.clear();
+
+    SimTone carrier = { 1.0e9, -30.0, 0.3, 5.0e3, 1.0e3 };
+    tones.push_back(carrier);
+
+    SimTone harmonic = { 2.0e9, -70.0, 0.0, 0.0, 0.0 };
+    tones.push_back(harmonic);
+    harmonic.freq = 3.0e9;
+    harmonic.dBm = -80.0;
+    tones.push_back(harmonic);
+
+    double minFreq = 10.0e6, maxFreq = device_traits::max_frequency();
+    for(int i = 0; i < 13; i++) {
+        SimTone cw = { 0.0, 0.0, 0.0, 0.0, 0.0 };
+        cw.freq = minFreq + UniformRand() * (maxFreq - minFreq);
+        cw.dBm = -100.0 + UniformRand() * 70.0;
+        tones.push_back(cw);
+    }
+
+    tonePhase.assign(tones.size(), 0.0);
+    modPhase.assign(tones.size(), 0.0);
+}
+
+// Pre-computed detector statistics for exponentially distributed
+//   noise power, so a sweep bin costs one table lookup
+void DeviceSim::BuildNoiseTables()
+{
+    noiseMin.resize(NOISE_TABLE_LEN);
+    noiseMax.resize(NOISE_TABLE_LEN);
+    noiseAvg.resize(NOISE_TABLE_LEN);
+    noiseGauss.resize(NOISE_TABLE_LEN);
+
+    for(int i = 0; i < NOISE_TABLE_LEN; i++) {
+        double lo = 1.0e30, hi = 0.0, sum = 0.0;
+        for(int j = 0; j < 16; j++) {
+            double p = -log(1.0 - UniformRand());
+            if(j < 4) {
+                lo = bb_lib::min2(lo, p);
+                hi = bb_lib::max2(hi, p);
+            }
+            sum += p;
+        }
+        noiseMin[i] = 10.0 * log10(bb_lib::max2(lo, 1.0e-12));
+        noiseMax[i] = 10.0 * log10(hi);
+        noiseAvg[i] = 10.0 * log10(sum / 16.0);
+
+        // Box-Muller
+        double u1 = 1.0 - UniformRand(), u2 = UniformRand();
+        noiseGauss[i] = sqrt(-2.0 * log(u1)) * cos(SIM_TWO_PI * u2);
+    }
+}
+
+bool DeviceSim::Reconfigure(const SweepSettings *s, Trace *t)
+{
+    if(!open) {
+        lastStatusString = "Device not open";
+        return false;
+    }
+
+    Abort();
+
+    logScale = s->RefLevel().IsLogScale();
+    avgDetector = (s->Detector() == BB_AVERAGE);
+    rbw = s->RBW();
+    refLevel = s->RefLevel().ConvertToUnits(DBM);
+    divSize = s->Div();
+
+    double span = s->Span();
+    binSize = rbw / 2.0;
+    sweepLen = (int)(span / binSize) + 1;
+    if(sweepLen > MAX_SIM_SWEEP_LEN) {
+        sweepLen = MAX_SIM_SWEEP_LEN;
+        binSize = span / (sweepLen - 1);
+    }
+    if(sweepLen < 2) {
+        sweepLen = 2;
+        binSize = span;
+    }
+    start = s->Center() - span / 2.0;
+
+    noiseFloor = SIM_DANL + 10.0 * log10(rbw) + range_penalty(refLevel);
+
+    switch(s->Mode()) {
+    case MODE_SWEEPING: case MODE_HARMONICS:
+        // Narrow RBWs sweep proportionally slower
+        sweepDuration = (span / SIM_SWEEP_SPEED) * bb_lib::max2(1.0, 10.0e3 / rbw);
+        sweepDuration = bb_lib::max2(sweepDuration, s->SweepTime().Val());
+        break;
+    case MODE_REAL_TIME:
+        sweepDuration = 1.0 / bb_lib::max2(prefs->realTimeFrameRate, 1);
+        rtFrameSize.setWidth(bb_lib::min2(sweepLen, SIM_RT_MAX_FRAME_WIDTH));
+        rtFrameSize.setHeight(SIM_RT_FRAME_HEIGHT);
+        break;
+    default:
+        Q_ASSERT(0);
+        return false;
+    }
+    mode = s->Mode();
+
+    t->SetSettings(*s);
+    t->SetSize(sweepLen);
+    t->SetFreq(binSize, start);
+    t->SetUpdateRange(0, sweepLen);
+
+    last_temp = current_temp;
+    nextDeadline = clock::now();
+
+    return true;
+}
+
+void DeviceSim::SynthesizeSweep(float *min, float *max, int len)
+{
+    const float floor = noiseFloor;
+    const int mask = NOISE_TABLE_LEN - 1;
+
+    if(avgDetector) {
+        for(int i = 0; i < len; i++) {
+            min[i] = max[i] = floor + noiseAvg[rng() & mask];
+        }
+    } else {
+        for(int i = 0; i < len; i++) {
+            int ix = rng() & mask;
+            min[i] = floor + noiseMin[ix];
+            max[i] = floor + noiseMax[ix];
+        }
+    }
+
+    // Gaussian RBW shape out to 3 RBWs, the detector holds the peak
+    //   within each bin so coarse bins still see the tone
+    bool overflow = false;
+    for(const SimTone &tone : tones) {
+        double lo = tone.freq - 3.0 * rbw - binSize;
+        double hi = tone.freq + 3.0 * rbw + binSize;
+        int first = bb_lib::max2(0, (int)ceil((lo - start) / binSize));
+        int last = bb_lib::min2(len - 1, (int)floor((hi - start) / binSize));
+        if(first > last) {
+            continue;
+        }
+
+        if(tone.dBm > refLevel) {
+            overflow = true;
+        }
+
+        for(int i = first; i <= last; i++) {
+            double df = fabs(start + i * binSize - tone.freq) - binSize * 0.5;
+            double x = bb_lib::max2(df, 0.0) * 2.0 / rbw;
+            float p = tone.dBm - 3.0103 * x * x;
+            min[i] = add_db(min[i], p);
+            max[i] = add_db(max[i], p);
+        }
+    }
+    adc_overflow = overflow;
+
+    if(!logScale) {
+        bb_lib::dbm_to_mv(min, len);
+        bb_lib::dbm_to_mv(max, len);
+    }
+}
+
+bool DeviceSim::GetSweep(const SweepSettings *s, Trace *t)
+{
+    if(!open) {
+        lastStatusString = "Device not open";
+        return false;
+    }
+
+    UpdateDiagnostics();
+
+    if(update_diagnostics_string) {
+        QString diagnostics;
+        diagnostics.sprintf("%.2f C  --  %.2f V", CurrentTemp(), Voltage());
+        emit diagnosticsChanged(diagnostics);
+        update_diagnostics_string = false;
+    }
+
+    if(reconfigure_on_next || t->Length() != sweepLen) {
+        if(!Reconfigure(s, t)) {
+            return false;
+        }
+        reconfigure_on_next = false;
+    }
+
+    SynthesizeSweep(t->Min(), t->Max(), t->Length());
+    t->InvalidateStats();
+    Pace(sweepDuration);
+
+    return true;
+}
+
+bool DeviceSim::GetRealTimeFrame(Trace &t, RealTimeFrame &frame)
+{
+    Q_ASSERT(frame.alphaFrame.size() == rtFrameSize.width() * rtFrameSize.height());
+    Q_ASSERT(frame.rgbFrame.size() == frame.alphaFrame.size() * 4);
+
+    if(!open) {
+        lastStatusString = "Device not open";
+        return false;
+    }
+
+    int len = t.Length();
+    int w = frame.dim.width(), h = frame.dim.height();
+    if(len != sweepLen || w != rtFrameSize.width()) {
+        return false;
+    }
+
+    // Accumulate several spectra into the frame in log scale,
+    //   the trace is the max hold over the frame
+    bool linear = !logScale;
+    logScale = true;
+
+    rtMin.resize(len);
+    rtMax.resize(len);
+    std::fill(frame.alphaFrame.begin(), frame.alphaFrame.end(), 0.0f);
+    std::fill(t.Max(), t.Max() + len, -200.0f);
+
+    const double bottom = refLevel - divSize * 10.0;
+    const double rowScale = h / (divSize * 10.0);
+    // Columns shared by several bins are scaled so a column never
+    //   exceeds full intensity
+    const float hit = (float)w / ((double)len * SIM_RT_SPECTRA_PER_FRAME);
+
+    for(int k = 0; k < SIM_RT_SPECTRA_PER_FRAME; k++) {
+        SynthesizeSweep(&rtMin[0], &rtMax[0], len);
+        for(int i = 0; i < len; i++) {
+            float v = rtMax[i];
+            if(v > t.Max()[i]) t.Max()[i] = v;
+            int row = (int)((v - bottom) * rowScale);
+            if(row >= 0 && row < h) {
+                frame.alphaFrame[row * w + (int)((long long)i * w / len)] += hit;
+            }
+        }
+    }
+
+    logScale = !linear;
+    if(linear) {
+        bb_lib::dbm_to_mv(t.Max(), len);
+    }
+
+    for(int i = 0; i < len; i++) {
+        t.Min()[i] = t.Max()[i];
+    }
+    t.InvalidateStats();
+
+    // Convert the alpha/intensity frame to a 4 channel image
+    int totalPixels = frame.dim.height() * frame.dim.width();
+    simdIntensityToRgba_32f(&frame.alphaFrame[0], &frame.rgbFrame[0], totalPixels);
+
+    Pace(sweepDuration);
+
+    return true;
+}
+
+bool DeviceSim::Reconfigure(const DemodSettings *ds, IQDescriptor *desc)
+{
+    if(!open) {
+        lastStatusString = "Device not open";
+        return false;
+    }
+
+    Abort();
+
+    int decimation = 0x1 << (ds->DecimationFactor());
+
+    iqCenter = ds->CenterFreq();
+    iqSampleRate = device_traits::sample_rate() / decimation;
+    iqInputPower = ds->InputPower().ConvertToUnits(DBM);
+    iqReturnLen = SIM_IQ_RETURN_LEN;
+
+    desc->returnLen = iqReturnLen;
+    desc->bandwidth = bb_lib::min2((double)ds->Bandwidth(), iqSampleRate * 0.8);
+    desc->sampleRate = iqSampleRate;
+    desc->timeDelta = 1.0 / iqSampleRate;
+    desc->decimation = decimation;
+
+    // Per component noise amplitude in sqrt(mW)
+    double noise_dBm = SIM_DANL + 10.0 * log10(iqSampleRate) + range_penalty(iqInputPower);
+    noiseAmplitude = sqrt(pow(10.0, noise_dBm * 0.1) * 0.5);
+
+    mode = MODE_ZERO_SPAN;
+    nextDeadline = clock::now();
+
+    return true;
+}
+
+// I^2 + Q^2 is power in mW, matching the device API
+void DeviceSim::SynthesizeIQ(complex_f *dst, int len)
+{
+    const int mask = NOISE_TABLE_LEN - 1;
+    for(int i = 0; i < len; i++) {
+        dst[i].re = noiseAmplitude * noiseGauss[rng() & mask];
+        dst[i].im = noiseAmplitude * noiseGauss[rng() & mask];
+    }
+
+    bool overflow = false;
+    for(size_t t = 0; t < tones.size(); t++) {
+        const SimTone &tone = tones[t];
+        double offset = tone.freq - iqCenter;
+        if(fabs(offset) > iqSampleRate * 0.5) {
+            continue;
+        }
+
+        if(tone.dBm > iqInputPower) {
+            overflow = true;
+        }
+
+        double amp = sqrt(pow(10.0, tone.dBm * 0.1));
+        double phase = tonePhase[t], mphase = modPhase[t];
+        double modStep = SIM_TWO_PI * tone.modRate / iqSampleRate;
+
+        for(int i = 0; i < len; i++) {
+            double m = sin(mphase);
+            double a = amp * (1.0 + tone.amDepth * m);
+            dst[i].re += a * cos(phase);
+            dst[i].im += a * sin(phase);
+            phase += SIM_TWO_PI * (offset + tone.fmDeviation * m) / iqSampleRate;
+            mphase += modStep;
+        }
+
+        tonePhase[t] = fmod(phase, SIM_TWO_PI);
+        modPhase[t] = fmod(mphase, SIM_TWO_PI);
+    }
+    adc_overflow = overflow;
+}
+
+bool DeviceSim::GetIQ(IQCapture *iqc)
+{
+    if(!open) {
+        lastStatusString = "Device not open";
+        return false;
+    }
+
+    int len = bb_lib::min2((int)iqc->capture.size(), iqReturnLen);
+    if(len > 0) {
+        SynthesizeIQ(&iqc->capture[0], len);
+    }
+    simdZero_32s(iqc->triggers, 70);
+
+    Pace(iqReturnLen / iqSampleRate);
+
+    return true;
+}
+
+// Nothing is ever queued, flushing only drops the pacing backlog
+bool DeviceSim::GetIQFlush(IQCapture *iqc, bool flush)
+{
+    if(flush) {
+        nextDeadline = clock::now();
+    }
+
+    return GetIQ(iqc);
+}
+
+bool DeviceSim::ConfigureForTRFL(double center,
+                                 MeasRcvrRange range,
+                                 int,
+                                 int,
+                                 IQDescriptor &desc)
+{
+    if(!open) {
+        lastStatusString = "Device not open";
+        return false;
+    }
+
+    Abort();
+
+    switch(range) {
+    case MeasRcvrRangeHigh:
+        iqInputPower = +10.0;
+        break;
+    case MeasRcvrRangeMid:
+        iqInputPower = -25.0;
+        break;
+    case MeasRcvrRangeLow:
+        iqInputPower = -50.0;
+        break;
+    }
+
+    iqCenter = center;
+    iqSampleRate = device_traits::sample_rate() / 128;
+    iqReturnLen = SIM_IQ_RETURN_LEN;
+
+    desc.returnLen = iqReturnLen;
+    desc.bandwidth = 100.0e3;
+    desc.sampleRate = iqSampleRate;
+    desc.timeDelta = 1.0 / iqSampleRate;
+    desc.decimation = 128;
+
+    double noise_dBm = SIM_DANL + 10.0 * log10(iqSampleRate) + range_penalty(iqInputPower);
+    noiseAmplitude = sqrt(pow(10.0, noise_dBm * 0.1) * 0.5);
+
+    mode = MODE_ZERO_SPAN;
+    nextDeadline = clock::now();
+
+    return true;
+}
+
+bool DeviceSim::ConfigureAudio(const AudioSettings &as)
+{
+    audioMode = as.AudioMode();
+    audioCenter = as.CenterFreq();
+    audioIFBandwidth = as.IFBandwidth();
+
+    // Demodulate the strongest tone within the IF bandwidth
+    audioTone = -1;
+    for(size_t t = 0; t < tones.size(); t++) {
+        if(fabs(tones[t].freq - audioCenter) > audioIFBandwidth * 0.5) {
+            continue;
+        }
+        if(audioTone < 0 || tones[t].dBm > tones[audioTone].dBm) {
+            audioTone = t;
+        }
+    }
+
+    nextDeadline = clock::now();
+
+    return true;
+}
+
+bool DeviceSim::GetAudio(float *audio)
+{
+    if(!open) {
+        lastStatusString = "Device not open";
+        return false;
+    }
+
+    const int mask = NOISE_TABLE_LEN - 1;
+    const double rate = device_traits::audio_rate();
+    double gain = 0.0, freq = 1.0e3;
+
+    if(audioTone >= 0) {
+        const SimTone &tone = tones[audioTone];
+        switch(audioMode) {
+        case BB_DEMOD_AM:
+            gain = tone.amDepth;
+            freq = tone.modRate;
+            break;
+        case BB_DEMOD_FM:
+            gain = tone.fmDeviation / bb_lib::max2(audioIFBandwidth * 0.5, 1.0);
+            freq = tone.modRate;
+            break;
+        default:
+            // SSB/CW, beat note against the tuned frequency
+            gain = 0.5;
+            freq = fabs(tone.freq - audioCenter);
+            break;
+        }
+    }
+
+    double step = SIM_TWO_PI * freq / rate;
+    for(int i = 0; i < SIM_AUDIO_LEN; i++) {
+        audio[i] = gain * sin(audioPhase) + 0.01 * noiseGauss[rng() & mask];
+        audioPhase += step;
+    }
+    audioPhase = fmod(audioPhase, SIM_TWO_PI);
+
+    Pace(SIM_AUDIO_LEN / rate);
+
+    return true;
+}
+
+void DeviceSim::Pace(double seconds)
+{
+    if(timeScale <= 0.0) {
+        return;
+    }
+
+    clock::time_point now = clock::now();
+    nextDeadline += std::chrono::duration_cast<clock::duration>(
+                std::chrono::duration<double>(seconds * timeScale));
+
+    // Don't try to catch up after long stalls (reconfigures, pauses)
+    if(nextDeadline < now) {
+        nextDeadline = now;
+        return;
+    }
+
+    std::this_thread::sleep_until(nextDeadline);
+}
+
+void DeviceSim::UpdateDiagnostics()
+{
+    // Fixed values, the string only needs to be printed once after open
+}
+
+const char* DeviceSim::GetLastStatusString() const
+{
+    return lastStatusString;
+}
+
+QString DeviceSim::GetDeviceString() const
+{
+    if(!open) return "No Device Open";
+    return "Simulator";
+}
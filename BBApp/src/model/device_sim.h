@@ -0,0 +1,117 @@
+#ifndef DEVICE_SIM_H
+#define DEVICE_SIM_H
+
+#include <chrono>
+#include <random>
+
+#include "device.h"
+
+class Preferences;
+
+// Simulated signal present at the input of the simulated device
+// CW when both modulation depths are zero
+struct SimTone {
+    double freq;
+    double dBm;
+    double amDepth; // [0.0, 1.0]
+    double fmDeviation; // Hz
+    double modRate; // Hz, shared by AM and FM
+};
+
+// Software-only device, produces deterministic synthetic sweeps,
+//   real-time frames, IQ and audio at approximately the rates of a BB60C.
+// Allows every stage after the device fetch to run without hardware.
+class DeviceSim : public Device {
+public:
+    DeviceSim(const Preferences *preferences);
+    virtual ~DeviceSim();
+
+    // Serial number reported for the simulator in the device list
+    static const int SIM_SERIAL_NUMBER = 1;
+    // True if the simulator was enabled via preferences or environment
+    static bool IsEnabled(const Preferences *preferences);
+
+    virtual bool OpenDevice();
+    virtual bool OpenDeviceWithSerial(int serialToOpen);
+    virtual int GetNativeDeviceType() const;
+    virtual bool CloseDevice();
+    virtual bool Abort();
+    virtual bool Preset();
+    // Sweep
+    virtual bool Reconfigure(const SweepSettings *s, Trace *t);
+    virtual bool GetSweep(const SweepSettings *s, Trace *t);
+    virtual bool GetRealTimeFrame(Trace &t, RealTimeFrame &frame);
+    // Stream
+    virtual bool Reconfigure(const DemodSettings *s, IQDescriptor *iqc);
+    virtual bool GetIQ(IQCapture *iqc);
+    virtual bool GetIQFlush(IQCapture *iqc, bool sync);
+    virtual bool ConfigureForTRFL(double center, MeasRcvrRange range,
+                                  int atten, int gain, IQDescriptor &desc);
+    virtual bool ConfigureAudio(const AudioSettings &as);
+    virtual bool GetAudio(float *audio);
+
+    virtual const char* GetLastStatusString() const;
+
+    virtual QString GetDeviceString() const;
+    virtual void UpdateDiagnostics();
+    virtual bool IsPowered() const { return true; }
+    virtual bool NeedsTempCal() const { return false; }
+    virtual bool IsSimulated() const { return true; }
+
+    virtual int MsPerIQCapture() const { return 26; }
+
+    virtual int SetTimebase(int new_val) {
+        timebase_reference = new_val;
+        return timebase_reference;
+    }
+
+private:
+    typedef std::chrono::steady_clock clock;
+
+    void BuildSignalPlan();
+    void BuildNoiseTables();
+    // Generate one sweep of min/max in dBm into the provided buffers
+    void SynthesizeSweep(float *min, float *max, int len);
+    // Continue the IQ waveform for len samples
+    void SynthesizeIQ(complex_f *dst, int len);
+    // Block until 'seconds' have passed since the previous call
+    void Pace(double seconds);
+    float UniformRand() { return (rng() >> 8) * (1.0f / 16777216.0f); }
+
+    unsigned int seed;
+    double timeScale; // 1.0 = realistic rates, 0.0 = unthrottled
+    std::mt19937 rng;
+    std::vector<SimTone> tones;
+    clock::time_point nextDeadline;
+
+    // Sweep state
+    OperationalMode mode;
+    bool logScale;
+    bool avgDetector;
+    double start, binSize, rbw, refLevel, divSize;
+    double noiseFloor; // dBm in one RBW
+    double sweepDuration; // seconds
+    int sweepLen;
+    std::vector<float> noiseMin, noiseMax, noiseAvg; // dB offsets
+    std::vector<float> noiseGauss; // Unit variance samples
+    std::vector<float> rtMin, rtMax; // real-time scratch spectra
+
+    // Stream state
+    double iqCenter, iqSampleRate, iqInputPower;
+    int iqReturnLen;
+    std::vector<double> tonePhase, modPhase;
+    double noiseAmplitude;
+
+    // Audio state
+    int audioMode;
+    int audioTone; // Index of demodulated tone, -1 for none
+    double audioCenter, audioIFBandwidth;
+    double audioPhase;
+
+    const char *lastStatusString;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(DeviceSim)
+};
+
+#endif // DEVICE_SIM_H
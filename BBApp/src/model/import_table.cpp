@@ -1,4 +1,5 @@
 #include "import_table.h"
+#include "lib/simd_kernels.h"
 
 #include <QFile>
 #include <fstream>
@@ -7,6 +8,8 @@ ImportTable::ImportTable()
 {
     active = false;
     stored = false;
+    generation = 0;
+    storeLogScale = true;
 }
 
 ImportTable::~ImportTable()
@@ -53,6 +56,7 @@ bool ImportTable::Import(const QString &fileName)
     } else {
         active = false;
     }
+    generation++;
 
     return true;
 }
@@ -60,6 +64,16 @@ bool ImportTable::Import(const QString &fileName)
 void ImportTable::Clear()
 {
     active = false;
+    generation++;
+}
+
+bool ImportTable::StoreMatches(const Trace *t) const
+{
+    return stored &&
+            store.Length() == t->Length() &&
+            store.StartFreq() == t->StartFreq() &&
+            store.BinSize() == t->BinSize() &&
+            storeLogScale == t->GetSettings()->RefLevel().IsLogScale();
 }
 
 void ImportTable::BuildStore(const Trace *t)
@@ -74,6 +88,10 @@ void ImportTable::BuildStore(const Trace *t)
     double currFreq = start;
 
     store.SetSize(t->Length());
+    store.SetFreq(step, start);
+    store.InvalidateStats();
+    storeLogScale = t->GetSettings()->RefLevel().IsLogScale();
+    generation++;
 
     if(points.empty()) {
         return; // No ctrl points
@@ -155,10 +173,10 @@ void ImportTable::BuildStore(const Trace *t)
     return;
 }
 
-void PathLossTable::Apply(Trace *in)
+bool PathLossTable::Prepare(const Trace *in)
 {
-    if(!active) return;
-    if(!stored || (in->Length() != store.Length())) {
+    if(!active) return false;
+    if(!StoreMatches(in)) {
         BuildStore(in);
         if(!in->GetSettings()->RefLevel().IsLogScale()) {
             bb_lib::db_to_lin(store.Max(), store.Length());
@@ -166,44 +184,184 @@ void PathLossTable::Apply(Trace *in)
     }
 
     // In the event this check fails, do nothing for now
-    if(in->Length() != store.Length()) {
+    return in->Length() == store.Length();
+}
+
+void PathLossTable::Apply(Trace *in)
+{
+    if(!Prepare(in)) {
         return;
     }
 
-    if(in->GetSettings()->RefLevel().IsLogScale()) {
-        for(int i = 0; i < in->Length(); i++) {
-            in->Max()[i] += store.Max()[i];
-            in->Min()[i] += store.Max()[i];
-        }
-    } else {
-        for(int i = 0; i < in->Length(); i++) {
-            in->Max()[i] *= store.Max()[i];
-            in->Min()[i] *= store.Max()[i];
-        }
-    }
+    simdCorrectLimit_32f(in->Min(), in->Max(), store.Max(),
+                         !in->GetSettings()->RefLevel().IsLogScale(),
+                         nullptr, nullptr, nullptr, in->Length());
+    in->InvalidateStats();
 }
 
-void LimitLineTable::Apply(Trace *in)
+bool LimitLineTable::Prepare(const Trace *in)
 {
-    if(!active) return;
-    if(!stored || (in->Length() != store.Length())) {
+    if(!active) return false;
+    if(!StoreMatches(in)) {
         BuildStore(in);
         if(!in->GetSettings()->RefLevel().IsLogScale()) {
+            bb_lib::dbm_to_mv(store.Min(), store.Length());
             bb_lib::dbm_to_mv(store.Max(), store.Length());
         }
     }
 
-    if(in->Length() != store.Length()) {
+    return in->Length() == store.Length();
+}
+
+void LimitLineTable::Apply(Trace *in)
+{
+    if(!Prepare(in)) {
         return;
     }
 
-    passed = false;
+    bool limitsPassed = simdCorrectLimit_32f(in->Min(), in->Max(), nullptr, false,
+                                             store.Min(), store.Max(),
+                                             BeginTest(in), in->Length());
+    EndTest(in, limitsPassed);
+}
+
+float* LimitLineTable::BeginTest(const Trace *in)
+{
+    testMargin.resize(bb_lib::max2(in->Length(), 1));
+    return &testMargin[0];
+}
+
+// The margins are only scanned when the sweep failed
+void LimitLineTable::EndTest(const Trace *in, bool limitsPassed)
+{
+    std::vector<LimitViolation> found;
+    int failed = 0;
+
+    if(!limitsPassed) {
+        const float *m = &testMargin[0];
+        int len = in->Length();
+
+        for(int i = 0; i < len; i++) {
+            if(!(m[i] > 0.0f)) {
+                continue;
+            }
 
-    for(int i = 0; i < in->Length(); i++) {
-        if(in->Min()[i] < store.Min()[i] || in->Max()[i] > store.Max()[i]) {
-            return;
+            LimitViolation v;
+            v.start = i;
+            int worst = i;
+            while(i < len && m[i] > 0.0f) {
+                if(m[i] > m[worst]) worst = i;
+                i++;
+            }
+            v.stop = i;
+            failed += v.stop - v.start;
+
+            v.startFreq = in->StartFreq() + v.start * in->BinSize();
+            v.stopFreq = in->StartFreq() + (v.stop - 1) * in->BinSize();
+            v.worstFreq = in->StartFreq() + worst * in->BinSize();
+            v.worstMargin = m[worst];
+            // Same choice as the margin kernel
+            v.aboveMax = (in->Max()[worst] - store.Max()[worst]) >
+                    (store.Min()[worst] - in->Min()[worst]);
+            found.push_back(v);
         }
     }
 
-    passed = true;
+    QMutexLocker guard(&resultLock);
+    passed = limitsPassed;
+    failedBins = failed;
+    violations.swap(found);
+    margin.swap(testMargin);
+}
+
+void LimitLineTable::GetViolations(std::vector<LimitViolation> &out) const
+{
+    QMutexLocker guard(&resultLock);
+    out = violations;
+}
+
+void LimitLineTable::GetMargin(std::vector<float> &out) const
+{
+    QMutexLocker guard(&resultLock);
+    out = margin;
+}
+
+CorrectionStage::CorrectionStage() :
+    identity(true),
+    valid(false),
+    start(0.0),
+    binSize(0.0),
+    length(0),
+    logScale(true),
+    offset(0.0),
+    pathLossGeneration(-1)
+{
+
+}
+
+CorrectionStage::~CorrectionStage()
+{
+
+}
+
+void CorrectionStage::Apply(Trace *in, double refOffset, PathLossTable &pathLoss,
+                            LimitLineTable &limitLine)
+{
+    if(in->Length() <= 0) {
+        return;
+    }
+
+    const PathLossTable *pl = pathLoss.Prepare(in) ? &pathLoss : nullptr;
+    bool limits = limitLine.Prepare(in);
+    bool log = in->GetSettings()->RefLevel().IsLogScale();
+
+    if(!valid || start != in->StartFreq() || binSize != in->BinSize() ||
+            length != in->Length() || logScale != log || offset != refOffset ||
+            pathLossGeneration != (pl ? pl->Generation() : -1)) {
+        Build(in, refOffset, pl);
+    }
+
+    bool passed = simdCorrectLimit_32f(in->Min(), in->Max(),
+                                       identity ? nullptr : &correction[0], !log,
+                                       limits ? limitLine.store.Min() : nullptr,
+                                       limits ? limitLine.store.Max() : nullptr,
+                                       limits ? limitLine.BeginTest(in) : nullptr,
+                                       in->Length());
+
+    if(!identity) {
+        in->InvalidateStats();
+    }
+    if(limits) {
+        limitLine.EndTest(in, passed);
+    }
+}
+
+void CorrectionStage::Build(const Trace *in, double refOffset, const PathLossTable *pathLoss)
+{
+    start = in->StartFreq();
+    binSize = in->BinSize();
+    length = in->Length();
+    logScale = in->GetSettings()->RefLevel().IsLogScale();
+    offset = refOffset;
+    pathLossGeneration = pathLoss ? pathLoss->Generation() : -1;
+    valid = true;
+
+    identity = (refOffset == 0.0 && !pathLoss);
+    if(identity) {
+        return;
+    }
+
+    // The path-loss store is already linear for linear scale
+    const float *loss = pathLoss ? pathLoss->store.Max() : nullptr;
+    correction.resize(length);
+    if(logScale) {
+        for(int i = 0; i < length; i++) {
+            correction[i] = refOffset + (loss ? loss[i] : 0.0);
+        }
+    } else {
+        double scalar = pow(10, refOffset / 20.0);
+        for(int i = 0; i < length; i++) {
+            correction[i] = scalar * (loss ? loss[i] : 1.0);
+        }
+    }
 }
@@ -1,6 +1,9 @@
 #ifndef IMPORT_TABLE_H
 #define IMPORT_TABLE_H
 
+#include <vector>
+
+#include <QMutex>
 #include <QVector>
 #include "trace.h"
 
@@ -44,9 +47,14 @@ public:
     void Clear();
     // Build a new store using the dimensions of t
     void BuildStore(const Trace *t);
+    // True if the store was built for the start, bin size, length
+    //   and scale of t
+    bool StoreMatches(const Trace *t) const;
     virtual void Apply(Trace *in) = 0;
 
     bool Active() const { return active; }
+    // Changes each time the store is rebuilt or a file is loaded/cleared
+    int Generation() const { return generation; }
 
     // Stores the path loss trace and limit lines
     // Path-Loss correction stored in Max portion
@@ -58,6 +66,8 @@ protected:
     bool active;
     // True when a store has been built from a trace
     bool stored;
+    int generation;
+    bool storeLogScale;
 
 private:
     QVector<TableEntry> points;
@@ -68,24 +78,91 @@ public:
     PathLossTable() {}
     ~PathLossTable() {}
 
+    // Rebuild the store for in if needed, linear for linear scale traces
+    // Returns false if there is no correction to apply
+    bool Prepare(const Trace *in);
     // Add/Multiply the path loss trace to
     void Apply(Trace *in);
 
 private:
 };
 
+// Consecutive bins outside the limits in one sweep
+struct LimitViolation {
+    int start, stop; // Bins [start, stop)
+    double startFreq, stopFreq; // Hz, first and last failing bin
+    double worstFreq; // Hz
+    float worstMargin; // Beyond the limit at the worst bin, dB or mV in linear scale
+    bool aboveMax; // Worst bin over the upper limit, otherwise under the lower limit
+};
+
 class LimitLineTable : public ImportTable {
 public:
-    LimitLineTable() {}
+    LimitLineTable() : passed(true), failedBins(0) {}
     ~LimitLineTable() {}
 
     bool LimitsPassed() const { return passed; }
 
+    // Rebuild the store for in if needed, mV for linear scale traces
+    // Returns false if there are no limits to test
+    bool Prepare(const Trace *in);
     // Test the input trace against the limits
     void Apply(Trace *in);
 
+    // Margin buffer for testing in, for simdCorrectLimit_32f()
+    float* BeginTest(const Trace *in);
+    // Publish the result and the margins written since BeginTest()
+    void EndTest(const Trace *in, bool limitsPassed);
+
+    // Results of the last test, copies since the sweep thread publishes
+    //   them while views read
+    // Violations in frequency order, empty when passed
+    void GetViolations(std::vector<LimitViolation> &out) const;
+    // Per-bin margin, positive for failing bins
+    void GetMargin(std::vector<float> &out) const;
+    int FailedBins() const { return failedBins; }
+
 private:
     bool passed;
+    int failedBins;
+
+    mutable QMutex resultLock;
+    std::vector<LimitViolation> violations;
+    std::vector<float> margin;
+    std::vector<float> testMargin; // Written by the running test
+};
+
+/*
+ * Reference offset and path-loss folded into one per-bin correction,
+ *   applied together with the limit line test in a single pass
+ * The correction is cached, rebuilt when the start, bin size, length,
+ *   scale or offset of the sweep change or the path-loss table changes
+ */
+class CorrectionStage {
+public:
+    CorrectionStage();
+    ~CorrectionStage();
+
+    // Same result as ApplyOffset(), then pathLoss.Apply() and limitLine.Apply()
+    void Apply(Trace *in, double refOffset, PathLossTable &pathLoss,
+               LimitLineTable &limitLine);
+
+private:
+    void Build(const Trace *in, double refOffset, const PathLossTable *pathLoss);
+
+    // Offset in dB, multiplied for linear scale
+    std::vector<float> correction;
+    bool identity; // No offset and no path-loss
+
+    bool valid;
+    double start, binSize;
+    int length;
+    bool logScale;
+    double offset;
+    int pathLossGeneration; // -1 when not active
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(CorrectionStage)
 };
 
 #endif // IMPORT_TABLE_H
@@ -1,159 +1,279 @@
 #include "persistence.h"
 #include "trace.h"
+#include "../lib/perf_timer.h"
+#include "../lib/simd_kernels.h"
 
 #include <QPoint>
 
+#include <algorithm>
+#include <cstring>
+
 const int MAX_PERSIST_W = 512;
 const int PERSIST_H = 512;
 
-Persistence::Persistence()
+// Added to the pixels a sweep draws, main min->max line and the
+//   connecting line to the next column
+const double LINE_ADD = 0.04;
+const double CONNECT_ADD = 0.01;
+// Applied to the whole map once per sweep
+const double DECAY = 0.975;
+// Renormalize when stored values reach 2^16 times their decayed value,
+//   roughly every 440 sweeps, keeps float precision well away from the limit
+const double RENORM_SCALE = 65536.0;
+// Colormap entries and transpose tile size, PERSIST_H is a multiple
+const int COLORMAP_SIZE = 256;
+const int IMAGE_TILE = 16;
+
+Persistence::Persistence() :
+    img_width(0),
+    clear_requested(false),
+    running(true),
+    busy(false)
 {
-    map = nullptr;
-    image = nullptr;
-    img_width = 0;
+    front = &maps[0];
+    back = &maps[1];
+    worker = std::thread(&Persistence::Worker, this);
 }
 
 Persistence::~Persistence()
 {
-    if(map) {
-        delete [] map;
-        map = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        running = false;
     }
-    if(image) {
-        delete [] image;
-        image = nullptr;
+    wake.notify_one();
+    if(worker.joinable()) {
+        worker.join();
     }
 }
 
-float* Persistence::GetImage()
+void Persistence::GetMap(std::vector<float> &dst)
 {
-    float *trans = new float[img_width * PERSIST_H];
+    std::lock_guard<std::mutex> lock(front_mutex);
 
-    map_mutex.lock();
+    dst.resize(front->data.size());
+    float inv = (float)(1.0 / front->scale);
+    for(int i = 0; i < (int)dst.size(); i++) {
+        dst[i] = front->data[i] * inv;
+    }
+}
 
-    for(int i = 0; i < img_width; i++) {
-        for(int j = 0; j < PERSIST_H; j++) {
-                trans[j*PERSIST_H + i] = map[i*PERSIST_H + j];
+// 8-bit RGBA for map values 0 -> 1, same colormap as the persistence
+//   fragment shader, values below the threshold are transparent
+// Built once at startup
+struct ColormapLut {
+    ColormapLut() {
+        for(int i = 0; i < COLORMAP_SIZE; i++) {
+            double l = (double)i / (COLORMAP_SIZE - 1);
+            unsigned char px[4];
+            bb_lib::persistence_color(l, px);
+            px[3] = (l > 0.01) ? 255 : 0;
+            memcpy(&rgba[i], px, 4);
         }
     }
 
-    map_mutex.unlock();
-
-    for(int i = 0; i < img_width * PERSIST_H; i++) {
-//        image[i*4] = 1.0; //trans[i];
-//        image[i*4+1] = 0.0; //trans[i];
-//        if(i & 1) image[i*4+1] = 1.0;
-//        image[i*4+2] = 0.0; //trans[i];
+    unsigned int rgba[COLORMAP_SIZE];
+};
 
-        float t = trans[i];
+static const ColormapLut colormap;
 
-        image[i*4] = trans[i];
-        image[i*4+1] = trans[i];
-        image[i*4+2] = trans[i];
-
-        if(trans[i] > 0.01) {
-            image[i*4+3] = 1.0;
-        } else {
-            image[i*4+3] = 0.0;
+// Image is always img_width wide, columns the worker has not reached
+//   yet after a width change are left empty
+// The column major map is transposed in tiles so both the map reads and
+//   the image writes stay within a few cache lines per tile
+const unsigned char* Persistence::GetImage()
+{
+    const unsigned int *lut = colormap.rgba;
+    int width = bb_lib::max2(img_width, 1);
+    image.resize(width * PERSIST_H);
+
+    std::lock_guard<std::mutex> lock(front_mutex);
+
+    int columns = bb_lib::min2(width, front->width);
+    float k = (float)((COLORMAP_SIZE - 1) / front->scale);
+    float top = (float)(COLORMAP_SIZE - 1);
+
+    for(int i0 = 0; i0 < columns; i0 += IMAGE_TILE) {
+        int i1 = bb_lib::min2(i0 + IMAGE_TILE, columns);
+        for(int j0 = 0; j0 < PERSIST_H; j0 += IMAGE_TILE) {
+            for(int i = i0; i < i1; i++) {
+                const float *col = &front->data[i * PERSIST_H];
+                unsigned int *dst = &image[j0 * width + i];
+                for(int j = j0; j < j0 + IMAGE_TILE; j++) {
+                    float v = bb_lib::min2(col[j] * k + 0.5f, top);
+                    *dst = lut[(int)v];
+                    dst += width;
+                }
+            }
         }
     }
 
+    for(int j = 0; j < PERSIST_H && columns < width; j++) {
+        std::fill(&image[j * width + columns], &image[j * width] + width, 0);
+    }
 
-    delete [] trans;
-
-    return image;
+    return (const unsigned char*)&image[0];
 }
 
 void Persistence::Reconfigure(const Trace *trace)
 {
-    int new_len = bb_lib::min2(trace->Length(), MAX_PERSIST_W);
-
-    map_mutex.lock();
-
-    if(img_width != new_len) {
-        img_width =  new_len;
-
-        if(map) {
-            delete [] map;
-            map = nullptr;
-        }
-        map = new float[img_width * PERSIST_H];
-
-        if(image) {
-            delete [] image;
-            image = nullptr;
-        }
-        image = new float[img_width * PERSIST_H * 4];
-    }
-
-    map_mutex.unlock();
-
+    img_width = bb_lib::min2(trace->Length(), MAX_PERSIST_W);
     Clear();
 }
 
+// Applied by the worker before the next sweep is drawn
 void Persistence::Clear()
 {
-    for(int i = 0; i < img_width * 512; i++) {
-        map[i] = 0.0;
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        clear_requested = true;
     }
+    wake.notify_one();
 }
 
 /*
  * Turn trace into 512 by 512 min/max list
  *  either by interpolation or bin combination
- * Decay model ->
+ * Only the row ranges are computed here, the worker draws them
  */
 void Persistence::Accumulate(const Trace *trace)
-{    
+{
+    PERF_SCOPE(PerfPersistence);
+
     if(bb_lib::min2(trace->Length(), MAX_PERSIST_W) != img_width) {
         Reconfigure(trace);
     }
+    if(img_width < 1) {
+        return;
+    }
 
-    GLVector trace_vector;
     normalize_trace(trace, trace_vector, QPoint(img_width, 0));
 
-    //for(int i = 0; i < trace->Length(); i++) {
-    for(int i = 0; i < img_width; i++) {
-        max_ix[i] = trace_vector[i*4+1] * 512;
-        min_ix[i] = trace_vector[i*4+3] * 512;
-        //min_ix[i] = (short)((trace->Min()[i] + 130.0) * 5.12);
-        //max_ix[i] = (short)((trace->Max()[i] + 130.0) * 5.12);
+    // Sweep dropped if the worker is holding every slot
+    PersistJob *job = jobs.AcquireWrite();
+    if(!job) {
+        return;
+    }
+
+    job->width = img_width;
+    job->columns = bb_lib::min2(img_width, (int)trace_vector.size() / 4);
 
-        min_ix[i] = bb_lib::max2(min_ix[i], (short)0);
-        min_ix[i] = bb_lib::min2(min_ix[i], (short)511);
+    for(int i = 0; i < job->columns; i++) {
+        // Min and max are not in a fixed order, depends on the
+        //   normalization branch
+        short a = trace_vector[i*4+1] * 512;
+        short b = trace_vector[i*4+3] * 512;
 
-        max_ix[i] = bb_lib::max2(max_ix[i], (short)0);
-        max_ix[i] = bb_lib::min2(max_ix[i], (short)511);
+        a = bb_lib::min2(bb_lib::max2(a, (short)0), (short)511);
+        b = bb_lib::min2(bb_lib::max2(b, (short)0), (short)511);
 
+        job->min_ix[i] = bb_lib::min2(a, b);
+        job->max_ix[i] = bb_lib::max2(a, b);
     }
 
-    // Modify the persistence map
-    map_mutex.lock();
+    jobs.CommitWrite();
 
-    for(int i = 0; i < img_width - 1; i++) {
-        float *map_ptr = map + (i * 512);
-        // Main min->max line
-        for(int j = min_ix[i]; j <= max_ix[i]; j++) {
-            map_ptr[j] += 0.04;
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+    }
+    wake.notify_one();
+}
+
+void Persistence::Flush()
+{
+    std::unique_lock<std::mutex> lock(wake_mutex);
+    idle.wait(lock, [this] {
+        return !running || (!busy && !clear_requested && jobs.Count() == 0);
+    });
+}
+
+// Each sweep is drawn into the back map, the maps are swapped, then the
+//   same sweep is drawn into the new back map to bring it up to date
+void Persistence::Worker()
+{
+    while(true) {
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex);
+            wake.wait(lock, [this] {
+                return !running || clear_requested || jobs.Count() > 0;
+            });
+            if(!running) {
+                break;
+            }
+            busy = true;
         }
-        // Draw lines between
-        for(int j = max_ix[i]; j < min_ix[i+1]; j++) {
-            map_ptr[j] += 0.01;
+
+        if(clear_requested.exchange(false)) {
+            ResetMap(*back, back->width);
+            std::lock_guard<std::mutex> lock(front_mutex);
+            ResetMap(*front, front->width);
         }
-        for(int j = max_ix[i]; j > max_ix[i+1]; j--) {
-            map_ptr[j] += 0.01;
+
+        const PersistJob *job = jobs.AcquireRead();
+        if(job) {
+            Draw(*back, *job);
+            {
+                std::lock_guard<std::mutex> lock(front_mutex);
+                std::swap(front, back);
+            }
+            Draw(*back, *job);
+            jobs.ReleaseRead();
         }
+
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex);
+            busy = false;
+        }
+        idle.notify_all();
     }
 
-    Decay();
+    idle.notify_all();
+}
+
+// Cost follows the number of pixels drawn, the decay is a scale update
+void Persistence::Draw(PersistMap &m, const PersistJob &job)
+{
+    if(m.width != job.width) {
+        ResetMap(m, job.width);
+    }
 
-    map_mutex.unlock();
+    float line = (float)(LINE_ADD * m.scale);
+    float connect = (float)(CONNECT_ADD * m.scale);
+
+    for(int i = 0; i < job.columns - 1; i++) {
+        float *col = &m.data[i * PERSIST_H];
+        int lo = job.min_ix[i], hi = job.max_ix[i];
+        int next_lo = job.min_ix[i+1], next_hi = job.max_ix[i+1];
+
+        // Main min->max line
+        simdAddC_32f(line, col + lo, hi - lo + 1);
+        // Draw lines between
+        if(next_lo > hi) {
+            simdAddC_32f(connect, col + hi, next_lo - hi);
+        }
+        if(next_hi < hi) {
+            simdAddC_32f(connect, col + next_hi + 1, hi - next_hi);
+        }
+    }
+
+    m.scale /= DECAY;
+    if(m.scale > RENORM_SCALE) {
+        Renormalize(m);
+    }
 }
 
-// Only call from Accumulate, do not lock
-void Persistence::Decay()
+void Persistence::Renormalize(PersistMap &m)
 {
-    for(int i = 0; i < img_width * 512; i++) {
-        map[i] *= 0.975;
+    float inv = (float)(1.0 / m.scale);
+    for(int i = 0; i < (int)m.data.size(); i++) {
+        m.data[i] *= inv;
     }
+    m.scale = 1.0;
+}
+
+void Persistence::ResetMap(PersistMap &m, int width)
+{
+    m.width = width;
+    m.data.assign(width * PERSIST_H, 0.0);
+    m.scale = 1.0;
 }
@@ -2,20 +2,36 @@
 #define PERSISTENCE_H
 
 #include "../lib/macros.h"
+#include "../lib/threadsafe_queue.h"
 
 #include <vector>
 #include <array>
+#include <atomic>
+#include <condition_variable>
 #include <mutex>
+#include <thread>
 
 class Trace;
 
+/*
+ * Line persistence map, up to 512 columns by 512 rows
+ * Traces are reduced to per column row ranges on the calling thread and
+ *   drawn into the map on a worker thread.
+ * Decay is lazy, each map stores values divided by a running scale that
+ *   grows every sweep, so a sweep only touches the pixels it draws. The
+ *   map is renormalized once the scale gets large.
+ * The map is double buffered, readers see the last complete sweep.
+ */
 class Persistence {
 public:
     Persistence();
     ~Persistence();
 
-    float* GetMap() const { return map; }
-    float* GetImage();
+    // Copy of the decayed map, column major, Width() * Height() values
+    void GetMap(std::vector<float> &dst);
+    // Row major 8-bit RGBA image, Width() * Height() pixels, colored
+    //   through the persistence colormap, valid until the next call
+    const unsigned char* GetImage();
 
     int Width() const { return img_width; }
     int Height() const { return 512; }
@@ -30,23 +46,55 @@ public:
     // Contribute one trace to the map
     void Accumulate(const Trace *trace);
 
+    // Wait until all accumulated traces are in the map
+    void Flush();
+
 protected:
 
 private:
-    void Decay();
+    // One sweep reduced to row ranges, drawn by the worker
+    struct PersistJob {
+        int width;
+        int columns;
+        std::array<short, 512> min_ix, max_ix;
+    };
+
+    struct PersistMap {
+        PersistMap() : width(0), scale(1.0) {}
+
+        // Column major, width * 512, stored value = decayed value * scale
+        std::vector<float> data;
+        int width;
+        double scale;
+    };
+
+    void Worker();
+    void Draw(PersistMap &m, const PersistJob &job);
+    void Renormalize(PersistMap &m);
+    static void ResetMap(PersistMap &m, int width);
 
+    // Producer side width, the maps follow on the worker thread
     int img_width;
-    // Temporarily stores traces converted to indices
-    //std::vector<short> min_ix, max_ix;
-    std::array<short, 512> min_ix, max_ix;
-    // Single channel persistence map, layout out horozontally
-    float *map;
-    // Transposed image color map, only populated when requested to
-    //   be drawn
-    float *image;
-
-    // Lock out when modifying the map
-    std::mutex map_mutex;
+    // Trace normalized to img_width columns, reused between sweeps
+    GLVector trace_vector;
+
+    ThreadSafeQueue<PersistJob, 4> jobs;
+    std::atomic<bool> clear_requested;
+
+    // Front is read by GetImage/GetMap, back is only touched by the worker
+    PersistMap maps[2];
+    PersistMap *front, *back;
+    // Lock out when reading or swapping the front map
+    std::mutex front_mutex;
+
+    // Transposed RGBA image, only populated when requested to be drawn
+    std::vector<unsigned int> image;
+
+    std::thread worker;
+    bool running;
+    bool busy;
+    std::mutex wake_mutex;
+    std::condition_variable wake, idle;
 
 private:
     DISALLOW_COPY_AND_ASSIGN(Persistence)
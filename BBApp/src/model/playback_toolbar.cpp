@@ -66,6 +66,7 @@ bool PlaybackFile::GetSweep(Trace *trace)
     trace->SetTime(time);
     file_handle.read((char*)trace->Min(), sizeof(float) * header.trace_len);
     file_handle.read((char*)trace->Max(), sizeof(float) * header.trace_len);
+    trace->InvalidateStats();
 
     trace_pos++;
 
@@ -31,6 +31,16 @@ public:
 
         sweepDelay = 0;
         realTimeFrameRate = 30;
+
+        simulatorEnabled = false;
+        simulatorSeed = 1;
+        simulatorTimeScale = 1.0;
+
+        perfStatsEnabled = false;
+        perfCsvPath = QString();
+
+        stitchedSweeps = false;
+        stitchSimSegments = 4;
     }
 
     void Load() {
@@ -49,6 +59,16 @@ public:
 
         sweepDelay = s.value("SweepPrefs/Delay", 0).toInt();
         realTimeFrameRate = s.value("SweepPrefs/RealTimeFrameRate", 30).toInt();
+
+        simulatorEnabled = s.value("SimulatorPrefs/Enabled", false).toBool();
+        simulatorSeed = s.value("SimulatorPrefs/Seed", 1).toUInt();
+        simulatorTimeScale = s.value("SimulatorPrefs/TimeScale", 1.0).toDouble();
+
+        perfStatsEnabled = s.value("PerfPrefs/Enabled", false).toBool();
+        perfCsvPath = s.value("PerfPrefs/CsvPath", QString()).toString();
+
+        stitchedSweeps = s.value("StitchPrefs/Enabled", false).toBool();
+        stitchSimSegments = s.value("StitchPrefs/SimSegments", 4).toInt();
     }
 
     void Save() const {
@@ -66,6 +86,16 @@ public:
 
         s.setValue("SweepPrefs/Delay", sweepDelay);
         s.setValue("SweepPrefs/RealTimeFrameRate", realTimeFrameRate);
+
+        s.setValue("SimulatorPrefs/Enabled", simulatorEnabled);
+        s.setValue("SimulatorPrefs/Seed", simulatorSeed);
+        s.setValue("SimulatorPrefs/TimeScale", simulatorTimeScale);
+
+        s.setValue("PerfPrefs/Enabled", perfStatsEnabled);
+        s.setValue("PerfPrefs/CsvPath", perfCsvPath);
+
+        s.setValue("StitchPrefs/Enabled", stitchedSweeps);
+        s.setValue("StitchPrefs/SimSegments", stitchSimSegments);
     }
 
     QString GetDefaultSaveDirectory() const;
@@ -115,6 +145,21 @@ public:
     // Arbitrary sweep delay
     int sweepDelay; // In ms [0, 2048]
     int realTimeFrameRate; // In fps [30 - 250]
+
+    // Simulated device, also controlled with the BBAPP_SIMULATOR,
+    //   BBAPP_SIM_SEED and BBAPP_SIM_TIMESCALE environment variables
+    bool simulatorEnabled;
+    unsigned int simulatorSeed;
+    double simulatorTimeScale; // 1.0 = realistic rates, 0.0 = unthrottled
+
+    // Per-stage timing shown in the status bar, also controlled with the
+    //   BBAPP_PERF and BBAPP_PERF_CSV environment variables
+    bool perfStatsEnabled;
+    QString perfCsvPath; // Rolling CSV dump of the stats, empty for none
+
+    // Split wide sweeps across the primary and additional devices
+    bool stitchedSweeps;
+    int stitchSimSegments; // Segments when the primary is simulated [1, 16]
 };
 
 #endif // PREFERENCES_H
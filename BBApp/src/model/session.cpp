@@ -14,6 +14,7 @@ Session::Session()
     trace_manager = new TraceManager();
     demod_settings = new DemodSettings();
     audio_settings = new AudioSettings();
+    devices_borrowed = false;
 
     isInPlaybackMode = false;
 
@@ -25,6 +26,8 @@ Session::Session()
 
 Session::~Session()
 {
+    RemoveAllDevices();
+
     delete sweep_settings;
     delete trace_manager;
     delete demod_settings;
@@ -82,6 +85,116 @@ void Session::SavePreset(int p)
     demod_settings->Save(settings);
 }
 
+Device* Session::CreateDevice(DeviceSeries series)
+{
+    if(series == saSeries) {
+        return new DeviceSA(&prefs);
+    } else if(series == simSeries) {
+        return new DeviceSim(&prefs);
+    }
+
+    return new DeviceBB60A(&prefs);
+}
+
+DeviceAcquisition* Session::AddDevice(Device *openedDevice,
+                                      const DeviceConnectionInfo &info)
+{
+    DeviceAcquisition *acquisition =
+            new DeviceAcquisition(openedDevice, info, *sweep_settings);
+
+    std::lock_guard<std::mutex> lock(devices_lock);
+    devices.push_back(acquisition);
+    acquisition->Start();
+
+    return acquisition;
+}
+
+bool Session::RemoveDevice(DeviceAcquisition *acquisition)
+{
+    std::lock_guard<std::mutex> lock(devices_lock);
+    if(devices_borrowed) {
+        return false;
+    }
+
+    if(devices.removeOne(acquisition)) {
+        // Stops the acquisition thread and closes the device
+        delete acquisition;
+    }
+    return true;
+}
+
+// Only call when nothing is borrowing the devices
+void Session::RemoveAllDevices()
+{
+    std::lock_guard<std::mutex> lock(devices_lock);
+    devices_borrowed = false;
+    while(!devices.empty()) {
+        delete devices.takeLast();
+    }
+}
+
+std::vector<Device*> Session::BorrowDevices()
+{
+    std::lock_guard<std::mutex> lock(devices_lock);
+    std::vector<Device*> lent;
+
+    for(DeviceAcquisition *acquisition : devices) {
+        acquisition->Stop();
+        lent.push_back(acquisition->GetDevice());
+    }
+    devices_borrowed = true;
+
+    return lent;
+}
+
+void Session::ReturnDevices()
+{
+    std::lock_guard<std::mutex> lock(devices_lock);
+    if(!devices_borrowed) {
+        return;
+    }
+
+    for(DeviceAcquisition *acquisition : devices) {
+        acquisition->Start();
+    }
+    devices_borrowed = false;
+}
+
+DeviceSeries Session::PrimarySeries() const
+{
+    if(device->IsSimulated()) {
+        return simSeries;
+    }
+
+    DeviceType type = device->GetDeviceType();
+    return (type == DeviceTypeBB60A || type == DeviceTypeBB60C) ? bbSeries : saSeries;
+}
+
+// Serial numbers are only unique within a series
+bool Session::IsDeviceInUse(const DeviceConnectionInfo &info) const
+{
+    if(device->IsOpen() && PrimarySeries() == info.series &&
+            device->SerialNumber() == info.serialNumber) {
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(devices_lock);
+    for(const DeviceAcquisition *acquisition : devices) {
+        if(acquisition->ConnectionInfo().series == info.series &&
+                acquisition->ConnectionInfo().serialNumber == info.serialNumber) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+QList<DeviceAcquisition*> Session::Devices() const
+{
+    std::lock_guard<std::mutex> lock(devices_lock);
+    return devices;
+}
+
 void Session::SetTitle(const QString &new_title)
 {
     title = new_title;
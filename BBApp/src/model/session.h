@@ -3,6 +3,7 @@
 
 #include "device_bb60a.h"
 #include "device_sa.h"
+#include "device_sim.h"
 
 #include "sweep_settings.h"
 #include "demod_settings.h"
@@ -10,6 +11,11 @@
 #include "audio_settings.h"
 #include "color_prefs.h"
 #include "preferences.h"
+#include "device_acquisition.h"
+
+#include <mutex>
+#include <atomic>
+#include <vector>
 
 const int MAX_TITLE_LEN = 127;
 
@@ -24,6 +30,29 @@ public:
     void LoadPreset(int p);
     void SavePreset(int p);
 
+    // Create an unopened device of the given series
+    Device* CreateDevice(DeviceSeries series);
+
+    // Additional devices, each sweeping on its own thread
+    // Must be the same series as the primary device
+    DeviceAcquisition* AddDevice(Device *openedDevice,
+                                 const DeviceConnectionInfo &info);
+    // Returns false while the devices are lent out
+    bool RemoveDevice(DeviceAcquisition *acquisition);
+    void RemoveAllDevices();
+    // Pause the additional acquisitions and lend their devices out,
+    //   e.g. to a stitched sweep, until ReturnDevices()
+    std::vector<Device*> BorrowDevices();
+    void ReturnDevices();
+    bool DevicesBorrowed() const { return devices_borrowed; }
+    // Series of the primary device, additional devices must match it
+    DeviceSeries PrimarySeries() const;
+    // True if the device is the primary or an additional device
+    bool IsDeviceInUse(const DeviceConnectionInfo &info) const;
+    // Copy of the additional devices, an acquisition stays valid until
+    //   it is removed, which only happens on the GUI thread
+    QList<DeviceAcquisition*> Devices() const;
+
     static QString GetTitle() { return title; }
     static void SetTitle(const QString &new_title);
     static QString title;
@@ -42,6 +71,11 @@ public:
     Preferences prefs;
 
     bool isInPlaybackMode;
+
+private:
+    QList<DeviceAcquisition*> devices;
+    mutable std::mutex devices_lock;
+    std::atomic<bool> devices_borrowed;
 };
 
 #endif // SESSION_H
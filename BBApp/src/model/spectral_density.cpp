@@ -0,0 +1,341 @@
+#include "spectral_density.h"
+#include "trace.h"
+#include "../lib/bb_lib.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <QFile>
+#include <QImage>
+
+static const unsigned short DENSITY_SIGNATURE = 0x5344; // "DS"
+static const unsigned short DENSITY_VERSION = 1;
+
+static const int MIN_DENSITY_ROWS = 16;
+static const int MAX_DENSITY_ROWS = 4096;
+static const int MAX_DENSITY_THREADS = 8;
+// Narrower stripes are not worth a thread
+static const int MIN_STRIPE_COLUMNS = 256;
+// Counter budget, 64 MiB, wide sweeps are binned into fewer columns
+static const long long MAX_DENSITY_CELLS = 16 * 1024 * 1024;
+// Wider grids are reduced for the image export
+static const int MAX_DENSITY_IMAGE_WIDTH = 4096;
+
+// Linear traces are in mV, NaN for non-positive values
+static double mv_to_dbm(double mv)
+{
+    return 20.0 * log10(mv) - 46.9897;
+}
+
+SpectralDensity::SpectralDensity() :
+    enabled(false),
+    cfgColumns(0),
+    rows(512),
+    bottom(-130.0),
+    top(0.0),
+    halfLife(0),
+    threadCount(1),
+    columns(0),
+    length(0),
+    startFreq(0.0),
+    binSize(0.0),
+    linear(false),
+    sweeps(0),
+    current(nullptr),
+    ageCurrent(false),
+    stripes(1),
+    generation(0),
+    remaining(0),
+    running(false)
+{
+
+}
+
+SpectralDensity::~SpectralDensity()
+{
+    StopWorkers();
+}
+
+void SpectralDensity::Configure(bool enable, int newColumns, int newRows,
+                                double newBottom, double newTop,
+                                int half_life, int threads)
+{
+    QMutexLocker guard(&lock);
+
+    if(threads <= 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    threads = bb_lib::max2(1, bb_lib::min2(threads, MAX_DENSITY_THREADS));
+
+    enabled = enable;
+    cfgColumns = newColumns;
+    rows = bb_lib::max2(MIN_DENSITY_ROWS, bb_lib::min2(newRows, MAX_DENSITY_ROWS));
+    bottom = newBottom;
+    top = (newTop > newBottom) ? newTop : newBottom + 1.0;
+    halfLife = bb_lib::max2(half_life, 0);
+
+    // Grid is rebuilt on the next sweep
+    length = 0;
+    columns = 0;
+    sweeps = 0;
+    counts.clear();
+
+    StopWorkers();
+    threadCount = enabled ? threads : 1;
+    StartWorkers(threadCount - 1);
+}
+
+void SpectralDensity::Clear()
+{
+    QMutexLocker guard(&lock);
+
+    std::fill(counts.begin(), counts.end(), 0);
+    sweeps = 0;
+}
+
+int SpectralDensity::Columns() const
+{
+    QMutexLocker guard(&lock);
+    return columns;
+}
+
+int SpectralDensity::Rows() const
+{
+    QMutexLocker guard(&lock);
+    return rows;
+}
+
+unsigned long long SpectralDensity::Sweeps() const
+{
+    QMutexLocker guard(&lock);
+    return sweeps;
+}
+
+void SpectralDensity::GetCounts(std::vector<unsigned int> &dst) const
+{
+    QMutexLocker guard(&lock);
+    dst = counts;
+}
+
+void SpectralDensity::Accumulate(const Trace *trace)
+{
+    QMutexLocker guard(&lock);
+
+    if(!enabled || trace->Length() < 1) {
+        return;
+    }
+
+    // New sweep settings start a new histogram
+    bool linearTrace = !trace->GetSettings()->RefLevel().IsLogScale();
+    if(trace->Length() != length || trace->StartFreq() != startFreq ||
+            trace->BinSize() != binSize || linearTrace != linear) {
+        length = trace->Length();
+        startFreq = trace->StartFreq();
+        binSize = trace->BinSize();
+        linear = linearTrace;
+        columns = (cfgColumns > 0) ? bb_lib::min2(cfgColumns, length) : length;
+        columns = (int)bb_lib::min2((long long)columns, MAX_DENSITY_CELLS / rows);
+        counts.assign((size_t)columns * rows, 0);
+        sweeps = 0;
+    }
+
+    sweeps++;
+    current = trace;
+    ageCurrent = (halfLife > 0) && (sweeps % halfLife == 0);
+    stripes = bb_lib::max2(1, bb_lib::min2(threadCount, columns / MIN_STRIPE_COLUMNS));
+
+    if(stripes > 1) {
+        {
+            std::lock_guard<std::mutex> lg(stripeMutex);
+            remaining = (int)workers.size();
+            generation++;
+        }
+        startStripes.notify_all();
+    }
+
+    AccumulateStripe(0);
+
+    if(stripes > 1) {
+        std::unique_lock<std::mutex> lg(stripeMutex);
+        stripesDone.wait(lg, [this] { return remaining == 0; });
+    }
+
+    current = nullptr;
+}
+
+// Stripe s owns columns [s * columns / stripes, (s + 1) * columns / stripes)
+//   and the bins that map into them
+void SpectralDensity::AccumulateStripe(int stripe)
+{
+    if(stripe >= stripes) {
+        return;
+    }
+
+    int c0 = (int)((long long)columns * stripe / stripes);
+    int c1 = (int)((long long)columns * (stripe + 1) / stripes);
+    unsigned int *grid = &counts[0];
+
+    if(ageCurrent) {
+        unsigned int *cell = grid + (size_t)c0 * rows;
+        unsigned int *end = grid + (size_t)c1 * rows;
+        for(; cell < end; cell++) {
+            *cell >>= 1;
+        }
+    }
+
+    // First bin whose column is at or past c, column(i) = i * columns / length
+    int b0 = (int)(((long long)c0 * length + columns - 1) / columns);
+    int b1 = (int)(((long long)c1 * length + columns - 1) / columns);
+
+    const float *mn = current->Min();
+    const float *mx = current->Max();
+    double scale = rows / (top - bottom);
+    int lastRow = rows - 1;
+
+    for(int i = b0; i < b1; i++) {
+        unsigned int *col = grid + (size_t)((long long)i * columns / length) * rows;
+
+        double a0 = mn[i], a1 = mx[i];
+        if(linear) {
+            a0 = mv_to_dbm(a0);
+            a1 = mv_to_dbm(a1);
+        }
+
+        // Written to also catch NaN
+        double r0 = (a0 - bottom) * scale;
+        double r1 = (a1 - bottom) * scale;
+        int lo = (r0 >= 0.0) ? (int)bb_lib::min2(r0, (double)lastRow) : 0;
+        int hi = (r1 >= 0.0) ? (int)bb_lib::min2(r1, (double)lastRow) : 0;
+        if(lo > hi) {
+            std::swap(lo, hi);
+        }
+
+        for(int r = lo; r <= hi; r++) {
+            col[r]++;
+        }
+    }
+}
+
+void SpectralDensity::StartWorkers(int count)
+{
+    running = true;
+    for(int i = 0; i < count; i++) {
+        workers.push_back(std::thread(&SpectralDensity::Worker, this, i + 1, generation));
+    }
+}
+
+void SpectralDensity::StopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lg(stripeMutex);
+        running = false;
+    }
+    startStripes.notify_all();
+
+    for(size_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+    workers.clear();
+}
+
+// seen is the generation at start, a new worker never runs a past sweep
+void SpectralDensity::Worker(int stripe, unsigned long long seen)
+{
+    while(true) {
+        {
+            std::unique_lock<std::mutex> lg(stripeMutex);
+            startStripes.wait(lg, [&] { return !running || generation != seen; });
+            if(!running) {
+                return;
+            }
+            seen = generation;
+        }
+
+        AccumulateStripe(stripe);
+
+        bool last = false;
+        {
+            std::lock_guard<std::mutex> lg(stripeMutex);
+            last = (--remaining == 0);
+        }
+        if(last) {
+            stripesDone.notify_one();
+        }
+    }
+}
+
+bool SpectralDensity::ExportBinary(const QString &fileName) const
+{
+    QMutexLocker guard(&lock);
+
+    if(counts.empty()) {
+        return false;
+    }
+
+    QFile file(fileName);
+    if(!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    density_header header;
+    memset(&header, 0, sizeof(density_header));
+    header.signature = DENSITY_SIGNATURE;
+    header.version = DENSITY_VERSION;
+    header.columns = columns;
+    header.rows = rows;
+    header.half_life = halfLife;
+    header.sweeps = sweeps;
+    header.start_freq = startFreq;
+    header.stop_freq = startFreq + binSize * length;
+    header.bottom = bottom;
+    header.top = top;
+
+    qint64 bytes = sizeof(unsigned int) * counts.size();
+    if(file.write((const char*)&header, sizeof(density_header)) != sizeof(density_header) ||
+            file.write((const char*)&counts[0], bytes) != bytes) {
+        return false;
+    }
+
+    return true;
+}
+
+bool SpectralDensity::ExportImage(const QString &fileName) const
+{
+    QMutexLocker guard(&lock);
+
+    if(counts.empty()) {
+        return false;
+    }
+
+    unsigned int peak = *std::max_element(counts.begin(), counts.end());
+    double norm = 1.0 / log(1.0 + bb_lib::max2(peak, 1u));
+
+    // Image column x shows the largest count of the grid columns it covers
+    int width = bb_lib::min2(columns, MAX_DENSITY_IMAGE_WIDTH);
+    QImage image(width, rows, QImage::Format_RGB32);
+    if(image.isNull()) {
+        return false;
+    }
+
+    for(int r = 0; r < rows; r++) {
+        QRgb *line = (QRgb*)image.scanLine(rows - 1 - r);
+        for(int x = 0; x < width; x++) {
+            int c0 = (int)((long long)columns * x / width);
+            int c1 = (int)((long long)columns * (x + 1) / width);
+            unsigned int n = 0;
+            for(int c = c0; c < c1; c++) {
+                n = bb_lib::max2(n, counts[(size_t)c * rows + r]);
+            }
+            if(n == 0) {
+                line[x] = qRgb(0, 0, 0);
+                continue;
+            }
+            unsigned char rgb[3];
+            bb_lib::persistence_color(log(1.0 + n) * norm, rgb);
+            line[x] = qRgb(rgb[0], rgb[1], rgb[2]);
+        }
+    }
+
+    return image.save(fileName);
+}
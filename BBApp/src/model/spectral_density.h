@@ -0,0 +1,115 @@
+#ifndef SPECTRAL_DENSITY_H
+#define SPECTRAL_DENSITY_H
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <QMutex>
+#include <QString>
+
+#include "../lib/macros.h"
+
+class Trace;
+
+// Version 1 binary export header, followed by Columns() * Rows()
+//   unsigned 32-bit counters, column major, row 0 at the bottom
+struct density_header {
+    unsigned short signature;
+    unsigned short version;
+
+    int columns;
+    int rows;
+    int half_life; // Sweeps, 0 for no aging
+    unsigned long long sweeps;
+
+    double start_freq; // Hz, first column
+    double stop_freq; // Hz, end of the last column
+    double bottom; // dBm, bottom of row 0
+    double top; // dBm, top of the last row
+};
+
+/*
+ * Spectral density (DPX style) histogram of swept data
+ * Every full sweep is binned at trace resolution into a frequency by
+ *   amplitude grid of integer hit counters, each bin adds one hit to
+ *   every row between its min and max.
+ * Optional aging halves every counter each half_life sweeps.
+ * Sweeps are binned in frequency stripes on a pool of worker threads,
+ *   Accumulate returns once every stripe is done.
+ * Configured and exported from the GUI thread, accumulated from the
+ *   sweep thread.
+ */
+class SpectralDensity {
+public:
+    SpectralDensity();
+    ~SpectralDensity();
+
+    // columns <= 0 for one column per sweep bin, columns are never more
+    //   than the sweep length, and are reduced further to keep the grid
+    //   within a fixed memory budget
+    // bottom and top in dBm, linear (mV) traces are converted to dBm
+    //   before binning
+    // Amplitudes outside [bottom, top) are counted in the edge rows
+    // threads <= 0 uses the hardware thread count
+    void Configure(bool enable, int columns, int rows, double bottom, double top,
+                   int half_life, int threads);
+    void Clear();
+
+    void Accumulate(const Trace *trace);
+
+    bool IsEnabled() const { return enabled; }
+    int Columns() const;
+    int Rows() const;
+    unsigned long long Sweeps() const;
+
+    // Copy of the counters, column major
+    void GetCounts(std::vector<unsigned int> &dst) const;
+
+    // Return false if the file can not be written or nothing is accumulated
+    bool ExportBinary(const QString &fileName) const;
+    // Log scaled density through the persistence colormap, format from
+    //   the file extension, at most 4096 pixels wide
+    bool ExportImage(const QString &fileName) const;
+
+private:
+    void StartWorkers(int count);
+    void StopWorkers();
+    void Worker(int stripe, unsigned long long seen);
+    void AccumulateStripe(int stripe);
+
+    mutable QMutex lock;
+
+    bool enabled;
+    int cfgColumns;
+    int rows;
+    double bottom, top;
+    int halfLife;
+    int threadCount;
+
+    // Grid follows the sweep, rebuilt when the sweep changes
+    int columns;
+    int length;
+    double startFreq, binSize;
+    bool linear; // Trace values in mV
+    unsigned long long sweeps;
+    std::vector<unsigned int> counts;
+
+    // Sweep being binned, valid while the stripes run
+    const Trace *current;
+    bool ageCurrent;
+    int stripes;
+
+    std::vector<std::thread> workers;
+    std::mutex stripeMutex;
+    std::condition_variable startStripes, stripesDone;
+    unsigned long long generation;
+    int remaining;
+    bool running;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(SpectralDensity)
+};
+
+#endif // SPECTRAL_DENSITY_H
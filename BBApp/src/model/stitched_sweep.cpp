@@ -0,0 +1,258 @@
+#include "stitched_sweep.h"
+#include "device_sim.h"
+#include "preferences.h"
+
+#include <cmath>
+
+// Narrowest sub-span worth giving its own device
+static const double MIN_SEGMENT_SPAN = 20.0e6;
+static const int MAX_SIM_SEGMENTS = 16;
+
+StitchedSweep::StitchedSweep(const Preferences *preferences) :
+    prefs(preferences),
+    sweepRequest(0),
+    pending(0),
+    quit(false),
+    start(0.0),
+    binSize(0.0),
+    size(0)
+{
+
+}
+
+StitchedSweep::~StitchedSweep()
+{
+    Release();
+}
+
+bool StitchedSweep::Configure(const std::vector<Device*> &devices,
+                              const SweepSettings *s, Trace *t)
+{
+    StopWorkers();
+    ClearSegments();
+
+    if(devices.empty() || s->Mode() != MODE_SWEEPING) {
+        return false;
+    }
+
+    std::vector<Device*> segmentDevices = devices;
+
+    // Simulated devices are free, add as many as requested
+    if(devices[0]->IsSimulated()) {
+        int simSegments = prefs->stitchSimSegments;
+        bb_lib::clamp(simSegments, 1, MAX_SIM_SEGMENTS);
+        while((int)segmentDevices.size() < simSegments) {
+            if(segmentDevices.size() - devices.size() >= simDevices.size()) {
+                Device *sim = new DeviceSim(prefs);
+                sim->OpenDevice();
+                simDevices.push_back(sim);
+            }
+            segmentDevices.push_back(simDevices[segmentDevices.size() - devices.size()]);
+        }
+    }
+
+    int segmentCount = segmentDevices.size();
+    while(segmentCount > 1 && s->Span() / segmentCount < MIN_SEGMENT_SPAN) {
+        segmentCount--;
+    }
+    if(segmentCount < 2) {
+        return false;
+    }
+
+    double segmentSpan = s->Span() / segmentCount;
+    binSize = 0.0;
+
+    for(int i = 0; i < segmentCount; i++) {
+        Segment *segment = new Segment();
+        segments.push_back(segment);
+
+        segment->device = segmentDevices[i];
+        segment->start = s->Start() + i * segmentSpan;
+        segment->stop = segment->start + segmentSpan;
+
+        // Narrow the span before moving the center so the span is never
+        //   clamped to the device range, then match the full sweep RBW
+        segment->settings = *s;
+        segment->settings.setSpan(segmentSpan);
+        segment->settings.setCenter(segment->start + segmentSpan / 2.0);
+        segment->settings.setRBW(s->RBW());
+        segment->settings.setVBW(s->VBW());
+
+        if(!segment->device->Reconfigure(&segment->settings, &segment->trace)) {
+            ClearSegments();
+            return false;
+        }
+
+        binSize = bb_lib::max2(binSize, segment->trace.BinSize());
+    }
+
+    if(binSize <= 0.0) {
+        ClearSegments();
+        return false;
+    }
+
+    start = s->Start();
+    size = (int)(s->Span() / binSize);
+
+    t->SetSettings(*s);
+    t->SetSize(size);
+    t->SetFreq(binSize, start);
+    t->SetUpdateRange(0, size);
+
+    StartWorkers();
+    return true;
+}
+
+bool StitchedSweep::GetSweep(Trace *t)
+{
+    if(segments.empty() || t->Length() != size) {
+        return false;
+    }
+
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        pending = segments.size();
+        sweepRequest++;
+        startCond.notify_all();
+        doneCond.wait(guard, [this] { return pending == 0; });
+    }
+
+    for(Segment *segment : segments) {
+        if(!segment->success) {
+            return false;
+        }
+    }
+
+    Stitch(t);
+    t->SetUpdateRange(0, size);
+    t->SetTime(segments[0]->trace.Time());
+
+    return true;
+}
+
+void StitchedSweep::Release()
+{
+    StopWorkers();
+    ClearSegments();
+
+    for(Device *sim : simDevices) {
+        delete sim;
+    }
+    simDevices.clear();
+}
+
+void StitchedSweep::ClearSegments()
+{
+    for(Segment *segment : segments) {
+        segment->device->Abort();
+        delete segment;
+    }
+    segments.clear();
+}
+
+void StitchedSweep::StartWorkers()
+{
+    quit = false;
+    pending = 0;
+    for(Segment *segment : segments) {
+        workers.push_back(std::thread(&StitchedSweep::Worker, this, segment));
+    }
+}
+
+void StitchedSweep::StopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        quit = true;
+        startCond.notify_all();
+    }
+
+    for(std::thread &worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+}
+
+void StitchedSweep::Worker(Segment *segment)
+{
+    unsigned int handled;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        handled = sweepRequest;
+    }
+
+    while(true) {
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            startCond.wait(guard, [&] { return quit || sweepRequest != handled; });
+            if(quit) {
+                return;
+            }
+            handled = sweepRequest;
+        }
+
+        // Devices returning partial sweeps are read until the sweep completes
+        do {
+            segment->success = segment->device->GetSweep(&segment->settings,
+                                                         &segment->trace);
+        } while(segment->success && !segment->trace.IsFullSweep());
+
+        std::lock_guard<std::mutex> guard(lock);
+        if(--pending == 0) {
+            doneCond.notify_all();
+        }
+    }
+}
+
+// Each segment is resampled onto the stitched bin grid, linear
+//   interpolation when upsampling, min/max of the covered bins otherwise,
+//   each output bin is taken from the segment requested to cover it
+void StitchedSweep::Stitch(Trace *t) const
+{
+    float *outMin = t->Min(), *outMax = t->Max();
+    int n = segments.size();
+
+    for(int s = 0; s < n; s++) {
+        const Trace &in = segments[s]->trace;
+        const float *inMin = in.Min(), *inMax = in.Max();
+        int inLast = in.Length() - 1;
+
+        int first = (int)ceil((segments[s]->start - start) / binSize);
+        int last = (s == n - 1) ? size : (int)ceil((segments[s]->stop - start) / binSize);
+        bb_lib::clamp(first, 0, size);
+        bb_lib::clamp(last, first, size);
+
+        double step = binSize / in.BinSize();
+        double x = (start + first * binSize - in.StartFreq()) / in.BinSize();
+
+        // Fewer output bins than input bins, each output bin takes the
+        //   min/max of the input bins around it so narrow peaks survive
+        if(step > 1.0 && inLast > 0) {
+            for(int i = first; i < last; i++, x += step) {
+                int lo = (int)ceil(x - step * 0.5);
+                int hi = (int)ceil(x + step * 0.5);
+                bb_lib::clamp(lo, 0, inLast);
+                bb_lib::clamp(hi, lo + 1, inLast + 1);
+                in.GetMinMax(lo, hi, &outMin[i], &outMax[i]);
+            }
+            continue;
+        }
+
+        for(int i = first; i < last; i++, x += step) {
+            if(x <= 0.0 || inLast <= 0) {
+                outMin[i] = inMin[0];
+                outMax[i] = inMax[0];
+            } else if(x >= inLast) {
+                outMin[i] = inMin[inLast];
+                outMax[i] = inMax[inLast];
+            } else {
+                int ix = (int)x;
+                float frac = (float)(x - ix);
+                outMin[i] = inMin[ix] + (inMin[ix + 1] - inMin[ix]) * frac;
+                outMax[i] = inMax[ix] + (inMax[ix + 1] - inMax[ix]) * frac;
+            }
+        }
+    }
+
+    t->InvalidateStats();
+}
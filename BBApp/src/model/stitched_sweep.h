@@ -0,0 +1,77 @@
+#ifndef STITCHED_SWEEP_H
+#define STITCHED_SWEEP_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "device.h"
+#include "trace.h"
+
+class Preferences;
+
+/*
+ * Splits a wide sweep into contiguous sub-spans, one per device
+ * Each segment is swept on its own thread, the segments are then
+ *   resampled onto a single trace with uniform bin spacing.
+ * All segments share the RBW/VBW of the requested settings so the
+ *   stitched trace is continuous at the segment boundaries.
+ * When the primary device is simulated, extra simulated devices are
+ *   created to reach the simulator segment count preference.
+ */
+class StitchedSweep {
+public:
+    StitchedSweep(const Preferences *preferences);
+    ~StitchedSweep();
+
+    // Devices must be open and are not owned, the first is the primary
+    // Returns false if the sweep can not be split, the caller should
+    //   then configure the primary device alone
+    bool Configure(const std::vector<Device*> &devices,
+                   const SweepSettings *s, Trace *t);
+    // Sweep all segments concurrently and stitch them into t
+    // t must have the geometry set by the last Configure()
+    bool GetSweep(Trace *t);
+    // Stop the segment threads and close any simulated devices
+    void Release();
+
+    int SegmentCount() const { return segments.size(); }
+
+private:
+    struct Segment {
+        Segment() : device(nullptr), trace(true), success(false) {}
+
+        Device *device;
+        SweepSettings settings;
+        Trace trace;
+        double start, stop; // Requested sub-span
+        bool success;
+    };
+
+    void ClearSegments();
+    void StartWorkers();
+    void StopWorkers();
+    void Worker(Segment *segment);
+    void Stitch(Trace *t) const;
+
+    const Preferences *prefs;
+
+    std::vector<Segment*> segments;
+    std::vector<Device*> simDevices; // Owned
+
+    std::vector<std::thread> workers;
+    std::mutex lock;
+    std::condition_variable startCond, doneCond;
+    unsigned int sweepRequest;
+    int pending;
+    bool quit;
+
+    double start, binSize;
+    int size;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(StitchedSweep)
+};
+
+#endif // STITCHED_SWEEP_H
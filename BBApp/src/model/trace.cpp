@@ -1,5 +1,7 @@
 #include "trace.h"
 #include "lib/bb_lib.h"
+#include "lib/simd_kernels.h"
+#include "lib/buffer_pool.h"
 
 #include <QSettings>
 #include <QFile>
@@ -7,6 +9,7 @@
 #include <QDialog>
 
 #include <iostream>
+#include <algorithm>
 
 Trace::Trace(bool active, int size)
 {
@@ -16,6 +19,7 @@ Trace::Trace(bool active, int size)
     _averageCount = 10;
 
     _size = 0;
+    _capacity = 0;
     _minBuf = nullptr;
     _maxBuf = nullptr;
 
@@ -24,6 +28,12 @@ Trace::Trace(bool active, int size)
 
     msFromEpoch = 0;
 
+    _statsValid = false;
+    _powerValid = false;
+    _peaksValid = false;
+    _pyramidValid = false;
+    _dirtyStart = _dirtyStop = 0;
+
     Alloc(size);
 }
 
@@ -49,19 +59,18 @@ void Trace::Copy(const Trace &other)
         _minBuf[i] = other._minBuf[i];
         _maxBuf[i] = other._maxBuf[i];
     }
+
+    InvalidateStats();
 }
 
-// Destroy buffers and set to null
+// Return buffers to the pool and set to null
 void Trace::Destroy()
 {
-    if(_minBuf) {
-        delete [] _minBuf;
-        _minBuf = nullptr;
-    }
-    if(_maxBuf) {
-        delete [] _maxBuf;
-        _maxBuf = nullptr;
-    }
+    BufferPool::Instance().Release(_minBuf, _capacity);
+    BufferPool::Instance().Release(_maxBuf, _capacity);
+    _minBuf = nullptr;
+    _maxBuf = nullptr;
+    _capacity = 0;
 }
 
 void Trace::Alloc(int newSize)
@@ -69,13 +78,16 @@ void Trace::Alloc(int newSize)
     if(_size == newSize)
         return;
 
-    // Sizes different, delete and re-alloc
-    Destroy();
+    InvalidateStats();
 
-    _size = newSize;
-    _minBuf = new float[_size];
-    _maxBuf = new float[_size];
+    // Sizes different, only reallocate to grow past the capacity
+    if(newSize > _capacity || !_minBuf) {
+        Destroy();
+        _minBuf = BufferPool::Instance().Acquire(newSize, &_capacity);
+        _maxBuf = BufferPool::Instance().Acquire(newSize, &_capacity);
+    }
 
+    _size = newSize;
     for(int i = 0; i < _size; i++) {
         _minBuf[i] = 0.0;
         _maxBuf[i] = 0.0;
@@ -83,9 +95,10 @@ void Trace::Alloc(int newSize)
 }
 
 // Clear does not delete the data, just set the size
-//   to zero, which triggers a copy
+//   to zero, which triggers a copy into the same buffers
 void Trace::Clear() {
     _size = 0;
+    InvalidateStats();
 }
 
 void Trace::SetType(TraceType type)
@@ -128,59 +141,27 @@ void Trace::GetSignalPeak(double *freq, double *amp) const
         return;
     }
 
-    double max = -1000.0;
-    int maxIndex = 0;
+    const TraceStats &s = Stats();
 
-    // Find max amp and index
-    for(int i = 0; i < _size; i++) {
-        if(_maxBuf[i] > max) {
-            max = _maxBuf[i];
-            maxIndex = i;
-        }
-    }
-
-    if(amp) *amp = max;
-    if(freq) *freq = _start + maxIndex * _binSize;
+    if(amp) *amp = s.peak;
+    if(freq) *freq = _start + s.peakIndex * _binSize;
 }
 
 int Trace::GetPeakIndex() const
 {
-    double max = -1000.0;
-    int maxIndex = 0;
-
-    for(int i = 0; i < _size; i++) {
-        if(_maxBuf[i] > max) {
-            max = _maxBuf[i];
-            maxIndex = i;
-        }
-    }
-
-    return maxIndex;
+    return Stats().peakIndex;
 }
 
 // Mean
 double Trace::GetMean() const
 {
-    double sum = 0.0;
-
-    for(int i = 0; i < _size; i++)
-        sum += _maxBuf[i];
-
-    return sum / _size;
+    return Stats().mean;
 }
 
 // Deviation squared
 double Trace::GetVariance() const
 {
-    double mean = GetMean();
-    double variance = 0.0;
-
-    for(int i = 0; i < _size; i++) {
-        double deviation = mean - _maxBuf[i];
-        variance += (deviation*deviation);
-    }
-
-    return variance / _size;
+    return Stats().variance;
 }
 
 double Trace::GetVarianceFromMean(const double mean) const
@@ -201,25 +182,141 @@ double Trace::GetStandardDeviation() const
     return sqrt(GetVariance());
 }
 
+// Peak, min, mean and variance of the max buffer from one pass
+const TraceStats& Trace::Stats() const
+{
+    if(_statsValid) {
+        return _stats;
+    }
+
+    SimdStats s;
+    simdStats_32f(_maxBuf, _size, -1000.0f, &s);
+
+    _stats.peak = s.max;
+    _stats.peakIndex = s.maxIndex;
+    _stats.min = s.min;
+    _stats.mean = s.mean;
+    _stats.variance = s.variance;
+
+    Amplitude ref = settings.RefLevel();
+    if(!ref.IsLogScale()) {
+        _stats.aboveReference = (_stats.peak > ref.Val());
+    } else {
+        _stats.aboveReference = (_stats.peak > ref.ConvertToUnits(AmpUnits::DBM));
+    }
+
+    _statsValid = true;
+    return _stats;
+}
+
+double Trace::GetTotalLinearPower() const
+{
+    return GetCumulativePower()[_size];
+}
+
+// Not part of Stats(), the conversion to linear units costs more than
+//   the rest of the pass and only channel power/OCBW use it
+const double* Trace::GetCumulativePower() const
+{
+    if(!_powerValid) {
+        _powerSum.resize(_size + 1);
+        simdCumulativePower_32f(_maxBuf, &_powerSum[0], _size,
+                                settings.RefLevel().IsLogScale());
+        _powerValid = true;
+    }
+
+    return &_powerSum[0];
+}
+
+void Trace::InvalidateRange(int start, int stop)
+{
+    _statsValid = false;
+    _powerValid = false;
+    _peaksValid = false;
+
+    if(_dirtyStart == _dirtyStop) {
+        _dirtyStart = start;
+        _dirtyStop = stop;
+    } else {
+        _dirtyStart = bb_lib::min2(_dirtyStart, start);
+        _dirtyStop = bb_lib::max2(_dirtyStop, stop);
+    }
+}
+
+void Trace::GetMinMax(int start, int stop, float *min, float *max) const
+{
+    if(!_pyramidValid || _pyramid.Length() != _size) {
+        _pyramid.Update(_minBuf, _maxBuf, _size, 0, _size);
+        _pyramidValid = true;
+    } else if(_dirtyStart != _dirtyStop) {
+        _pyramid.Update(_minBuf, _maxBuf, _size, _dirtyStart, _dirtyStop);
+    }
+    _dirtyStart = _dirtyStop = 0;
+
+    _pyramid.Query(_minBuf, _maxBuf, start, stop, min, max);
+}
+
 // Return a list of indices representing the acceptable peaks
 // Clear the list before beginning
 void Trace::GetPeakList(std::vector<int> &peak_index_list) const
 {
-    peak_index_list.clear();
-    double mean = GetMean();
-    double stddev = sqrt(GetVarianceFromMean(mean));
+    peak_index_list = Peaks();
+}
+
+const std::vector<int>& Trace::Peaks() const
+{
+    if(!_peaksValid) {
+        BuildPeakTable();
+    }
+
+    return _peaks;
+}
+
+int Trace::NextPeakLeft(int index) const
+{
+    const std::vector<int> &peaks = Peaks();
+    std::vector<int>::const_iterator it =
+            std::lower_bound(peaks.begin(), peaks.end(), index);
+    return (it == peaks.begin()) ? -1 : *(it - 1);
+}
+
+int Trace::NextPeakRight(int index) const
+{
+    const std::vector<int> &peaks = Peaks();
+    std::vector<int>::const_iterator it =
+            std::upper_bound(peaks.begin(), peaks.end(), index);
+    return (it == peaks.end()) ? -1 : *it;
+}
+
+void Trace::GetHighestPeaks(int count, std::vector<int> &peak_index_list) const
+{
+    if(!_peaksValid) {
+        BuildPeakTable();
+    }
+
+    count = bb_lib::min2(bb_lib::max2(count, 0), (int)_peaksByAmp.size());
+    peak_index_list.assign(_peaksByAmp.begin(), _peaksByAmp.begin() + count);
+}
+
+// One pass over the max buffer, the amplitude order is sorted from the
+//   peaks only
+void Trace::BuildPeakTable() const
+{
+    _peaks.clear();
+    const TraceStats &s = Stats();
+    double mean = s.mean;
+    double threshold = mean + sqrt(s.variance) * 1.2;
 
     // Find the "beginning" of a peak
     for(int loc = 0; loc < _size - 2; loc++) {
         // Next point must be above the entry
-        if((_maxBuf[loc] > (mean + stddev * 1.2))
-            && (_maxBuf[loc+1] > _maxBuf[loc])) {
+        if((_maxBuf[loc] > threshold) && (_maxBuf[loc+1] > _maxBuf[loc])) {
 
             double peakVal = _maxBuf[loc];
-            unsigned int ix_peak = loc;
+            int ix_peak = loc;
 
             // Find range
-            while((_maxBuf[loc] > (mean)) && loc < _size) {
+            while(_maxBuf[loc] > mean && loc + 1 < _size) {
                 loc++;
 
                 if(_maxBuf[loc] > peakVal) {
@@ -228,15 +325,26 @@ void Trace::GetPeakList(std::vector<int> &peak_index_list) const
                 }
             }
 
-            peak_index_list.push_back(ix_peak);
+            _peaks.push_back(ix_peak);
         }
     }
+
+    // Equal peaks keep index order
+    const float *buf = _maxBuf;
+    _peaksByAmp = _peaks;
+    std::stable_sort(_peaksByAmp.begin(), _peaksByAmp.end(), [buf](int a, int b) {
+        return buf[a] > buf[b];
+    });
+
+    _peaksValid = true;
 }
 
-void Trace::Update(const Trace &other)
+// Match size, frequency and settings to the incoming sweep
+// Returns false if the trace data does not need updating
+bool Trace::BeginUpdate(const Trace &other)
 {
     if(!_update) {
-        return;
+        return false;
     }
 
     // Check if equal? if not, set equal
@@ -254,53 +362,108 @@ void Trace::Update(const Trace &other)
 
     if(_type == OFF) {
         _active = false;
-        return;
+        return false;
     } else {
         _active = true;
     }
 
+    InvalidateRange(_updateStart, _updateStop);
+    return true;
+}
+
+void Trace::Update(const Trace &other)
+{
+    if(!BeginUpdate(other)) {
+        return;
+    }
+
+    int start = _updateStart;
+    int len = _updateStop - _updateStart;
+
     switch(_type) {
     case NORMAL:
-        for(int i = _updateStart; i < _updateStop; i++) {
-            _minBuf[i] = other._minBuf[i];
-            _maxBuf[i] = other._maxBuf[i];
-        }
+        simdCopy_32f(other._minBuf + start, _minBuf + start, len);
+        simdCopy_32f(other._maxBuf + start, _maxBuf + start, len);
         break;
     case MAX_HOLD:
-        for(int i = _updateStart; i < _updateStop; i++) {
-            _maxBuf[i] = _minBuf[i] = bb_lib::max2(_maxBuf[i], other._maxBuf[i]);
-        }
+        simdMaxHold_32f(other._maxBuf + start, _maxBuf + start, _minBuf + start, len);
         break;
     case MIN_HOLD:
-        for(int i = _updateStart; i < _updateStop; i++) {
-            _maxBuf[i] = _minBuf[i] = bb_lib::min2(_minBuf[i], other._minBuf[i]);
-        }
+        simdMinHold_32f(other._minBuf + start, _minBuf + start, _maxBuf + start, len);
         break;
     case MIN_AND_MAX:
-        for(int i = _updateStart; i < _updateStop; i++) {
-            _minBuf[i] = bb_lib::min2(_minBuf[i], other._minBuf[i]);
-            _maxBuf[i] = bb_lib::max2(_maxBuf[i], other._maxBuf[i]);
-        }
+        simdMin_32f(other._minBuf + start, _minBuf + start, len);
+        simdMax_32f(other._maxBuf + start, _maxBuf + start, len);
         break;
     case AVERAGE:
-        //std::cout << _maxBuf[_updateStart] << "\n";
         float add = 1.0 / _averageCount;
         float remove = 1.0 - add;
         if(_maxBuf[_updateStart] < -199.0) {
-            for(int i = _updateStart; i < _updateStop; i++) {
-                _minBuf[i] = other._minBuf[i];
-                _maxBuf[i] = other._maxBuf[i];
-            }
+            simdCopy_32f(other._minBuf + start, _minBuf + start, len);
+            simdCopy_32f(other._maxBuf + start, _maxBuf + start, len);
         } else {
-            for(int i = _updateStart; i < _updateStop; i++) {
-                _minBuf[i] = _minBuf[i]*remove + other._minBuf[i]*add;
-                _maxBuf[i] = _maxBuf[i]*remove + other._maxBuf[i]*add;
-            }
+            simdAverage_32f(other._minBuf + start, _minBuf + start, remove, add, len);
+            simdAverage_32f(other._maxBuf + start, _maxBuf + start, remove, add, len);
         }
         break;
     }
 }
 
+// Operation and buffers for the update range, call after BeginUpdate()
+void Trace::GetUpdateTarget(SimdTraceTarget &target)
+{
+    target.min = _minBuf + _updateStart;
+    target.max = _maxBuf + _updateStart;
+    target.keep = target.add = 0.0f;
+
+    switch(_type) {
+    case MAX_HOLD: target.op = SimdTraceMaxHold; break;
+    case MIN_HOLD: target.op = SimdTraceMinHold; break;
+    case MIN_AND_MAX: target.op = SimdTraceMinMax; break;
+    case AVERAGE:
+        // First sweep after a clear is copied
+        if(_maxBuf[_updateStart] < -199.0) {
+            target.op = SimdTraceCopy;
+        } else {
+            target.op = SimdTraceAverage;
+            target.add = 1.0 / _averageCount;
+            target.keep = 1.0 - target.add;
+        }
+        break;
+    default: target.op = SimdTraceCopy; break;
+    }
+}
+
+// Same result as calling Update() on each trace, the active traces are
+//   updated together in a single pass over the incoming sweep
+void Trace::UpdateAll(Trace *traces, int count, const Trace &other)
+{
+    SimdTraceTarget targets[SIMD_MAX_TRACE_TARGETS];
+    int n = 0;
+
+    for(int i = 0; i < count; i++) {
+        if(!traces[i].BeginUpdate(other)) {
+            continue;
+        }
+        traces[i].GetUpdateTarget(targets[n++]);
+
+        if(n == SIMD_MAX_TRACE_TARGETS) {
+            simdFusedTraceUpdate_32f(other._minBuf + other._updateStart,
+                                     other._maxBuf + other._updateStart,
+                                     targets, n,
+                                     other._updateStop - other._updateStart);
+            n = 0;
+        }
+    }
+
+    if(n > 0) {
+        simdFusedTraceUpdate_32f(other._minBuf + other._updateStart,
+                                 other._maxBuf + other._updateStart,
+                                 targets, n,
+                                 other._updateStop - other._updateStart);
+    }
+}
+
 // Returns true if successful(path exists)
 // spacing == frequency spacing of output file
 // Set first point to multiple of spacing
@@ -332,26 +495,16 @@ bool Trace::GetChannelPower(double ch_start, double ch_stop, double *power) cons
         return false;
     }
 
-    pfn_convert to_lin, to_log;
-    if(GetSettings()->RefLevel().IsLogScale()) {
-        to_lin = DBMtoMW;
-        to_log = MWtoDBM;
-    } else {
-        to_lin = MVtoMV2;
-        to_log = MV2toMV;
-    }
+    pfn_convert to_log = GetSettings()->RefLevel().IsLogScale() ? MWtoDBM : MV2toMV;
 
+    // Bins from the first past ch_start up to the last below ch_stop
     int index = (int)((ch_start - StartFreq()) / BinSize()) + 1;
     bb_lib::clamp<int>(index, 0, Length());
+    int stop = (int)ceil((ch_stop - StartFreq()) / BinSize());
+    bb_lib::clamp<int>(stop, index, Length());
 
-    double step_freq = StartFreq() + BinSize() * index;
-    double sum = 0.0;
-
-    while(step_freq < ch_stop && index < Length()) {
-        sum += to_lin(Max()[index]);
-        step_freq += BinSize();
-        index++;
-    }
+    const double *cumulative = GetCumulativePower();
+    double sum = cumulative[stop] - cumulative[index];
 
     sum /= GetSettings()->GetWindowBandwidth();
     *power = to_log(sum);
@@ -360,6 +513,8 @@ bool Trace::GetChannelPower(double ch_start, double ch_stop, double *power) cons
 }
 
 void Trace::ApplyOffset(double dB) {
+    InvalidateStats();
+
     if(settings.RefLevel().IsLogScale()) {
         for(int i = 0; i < _size; i++) {
             _minBuf[i] += dB;
@@ -388,36 +543,33 @@ void Trace::GetOccupiedBandwidth(OccupiedBandwidthInfo &info) const
              info.percentPower <= MAX_OCBW_PERCENT_POWER);
 
     // Sum up total channel power
-    double power = 0.0;
-    pfn_convert to_lin, to_log;
-    if(GetSettings()->RefLevel().IsLogScale()) {
-        to_lin = DBMtoMW;
-        to_log = MWtoDBM;
-    } else {
-        to_lin = MVtoMV2;
-        to_log = MV2toMV;
-    }
+    pfn_convert to_log = GetSettings()->RefLevel().IsLogScale() ? MWtoDBM : MV2toMV;
+    const double *cumulative = GetCumulativePower();
+    double power = cumulative[Length()];
 
     info.traceLen = Length();
 
-    for(int i = 0; i < Length(); i++) {
-        power += to_lin(Max()[i]);
-    }
-
     double halfMissing = ((100.0 - info.percentPower) / 2.0) / 100.0;
     halfMissing *= power;
 
-    // Move in on each end until 1/2 the missing power is subtracted
+    // Move in on each end until 1/2 the missing power is subtracted,
+    //   both edges are binary searches of the cumulative power
     info.lix = 0;
     info.rix = Length() - 1;
 
     double leftSum = 0.0, rightSum = 0.0;
-    while(leftSum < halfMissing && info.lix < info.rix) {
-        leftSum += to_lin(Max()[info.lix++]);
-    }
-
-    while(rightSum < halfMissing && info.rix > info.lix) {
-        rightSum += to_lin(Max()[info.rix--]);
+    if(info.lix < info.rix) {
+        // First bin where the power left of it reaches halfMissing
+        info.lix = std::lower_bound(cumulative, cumulative + info.rix, halfMissing) - cumulative;
+        leftSum = cumulative[info.lix];
+
+        // Fewest bins from the right end holding halfMissing
+        int keep = std::partition_point(cumulative, cumulative + Length() + 1,
+                                        [=](double sum) { return power - sum >= halfMissing; })
+                - cumulative - 1;
+        int removed = bb_lib::min2(Length() - keep, info.rix - info.lix);
+        info.rix -= removed;
+        rightSum = power - cumulative[Length() - removed];
     }
 
     Frequency leftFreq = StartFreq() + BinSize() * info.lix;
@@ -440,73 +592,3 @@ void Trace::GetOccupiedBandwidth(OccupiedBandwidthInfo &info) const
         info.totalPower = Amplitude(power).ConvertToUnits(powerUnits);
     }
 }
-
-ChannelPower::ChannelPower() :
-    enabled(false)
-{
-
-}
-
-ChannelPower::~ChannelPower()
-{
-
-}
-
-void ChannelPower::Configure(bool ch_enable, double ch_width, double ch_spacing)
-{
-    enabled = ch_enable;
-    width = ch_width;
-    spacing = ch_spacing;
-    in_view[0] = in_view[1] = in_view[2] = false;
-    ch_power[0] = ch_power[1] = ch_power[2] = 0.0;
-}
-
-void ChannelPower::Update(const Trace *trace)
-{
-    if(!enabled) return;
-
-    double center = trace->GetSettings()->Center();
-
-    ch_start[0] = center - spacing - (width / 2.0);
-    ch_stop[0] = ch_start[0] + width;
-    ch_start[1] = center - (width / 2.0);
-    ch_stop[1] = center + (width / 2.0);
-    ch_start[2] = center + spacing - (width / 2.0);
-    ch_stop[2] = ch_start[2] + width;
-
-    for(int i = 0; i < 3; i++) {
-        in_view[i] = trace->GetChannelPower(ch_start[i], ch_stop[i], &ch_power[i]);
-    }
-}
-
-bool ChannelPower::IsChannelInView(int channel) const
-{
-    if(channel < 0 || channel > 2)
-        return false;
-
-    return in_view[channel];
-}
-
-double ChannelPower::GetChannelStart(int channel) const
-{
-    if(channel < 0 || channel > 2)
-        return 0.0;
-
-    return ch_start[channel];
-}
-
-double ChannelPower::GetChannelStop(int channel) const
-{
-    if(channel < 0 || channel > 2)
-        return 0.0;
-
-    return ch_stop[channel];
-}
-
-double ChannelPower::GetChannelPower(int channel) const
-{
-    if(channel < 0 || channel > 2)
-        return 0.0;
-
-    return ch_power[channel];
-}
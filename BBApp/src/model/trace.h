@@ -4,10 +4,13 @@
 #include "sweep_settings.h"
 #include "marker.h"
 #include "lib/macros.h"
+#include "lib/minmax_pyramid.h"
 
 #include <QColor>
 #include <QSize>
 
+struct SimdTraceTarget;
+
 enum TraceType {
     OFF         = 0,
     NORMAL      = 1,
@@ -48,6 +51,17 @@ struct OccupiedBandwidthInfo {
     Amplitude totalPower;
 };
 
+// Summary of the max buffer, computed in one pass the first time it is
+//   requested after the trace data changes
+struct TraceStats {
+    double peak; // Not below -1000.0, as GetSignalPeak()
+    int peakIndex; // First index of the peak
+    double min;
+    double mean;
+    double variance;
+    bool aboveReference; // Peak above the reference level of the settings
+};
+
 class RealTimeFrame {
 public:
     RealTimeFrame() : dim(0, 0) {}
@@ -95,8 +109,10 @@ public:
     int GetAvgCount() const { return _averageCount; }
 
     int Length(void) const { return _size; }
+    // Allocated length, buffers are only reallocated to grow past it
+    int Capacity(void) const { return _capacity; }
 
-    void SetSettings(const SweepSettings &other) { settings = other; }
+    void SetSettings(const SweepSettings &other) { settings = other; InvalidateStats(); }
     const SweepSettings* GetSettings() const { return &settings; }
     double StartFreq() const { return _start; }
     double StopFreq() const { return _start + _binSize * _size; }
@@ -108,6 +124,31 @@ public:
     double GetVarianceFromMean(const double mean) const;
     double GetStandardDeviation() const;
     void GetPeakList(std::vector<int> &peak_index_list) const;
+    // Peak table of the max buffer in ascending index order, cached as Stats()
+    // A peak starts rising above mean + 1.2 stddev and ends where the
+    //   trace falls back to the mean, the highest bin in between is the peak
+    const std::vector<int>& Peaks() const;
+    // Closest peak strictly left/right of index, -1 if none, O(log n)
+    int NextPeakLeft(int index) const;
+    int NextPeakRight(int index) const;
+    // The count highest peaks, highest first
+    void GetHighestPeaks(int count, std::vector<int> &peak_index_list) const;
+    // Cached until the trace changes, valid while the trace is unchanged
+    const TraceStats& Stats() const;
+    // Sum of the max buffer in linear power units, cached as Stats()
+    double GetTotalLinearPower() const;
+    // Running sum of the linear power, Length() + 1 values where
+    //   [i] is the power of bins [0, i), cached as Stats()
+    const double* GetCumulativePower() const;
+    // Min of Min() and max of Max() over bins [start, stop), stop > start
+    // O(log n) from a reduction pyramid, rebuilt only over the bins
+    //   written since the last call
+    void GetMinMax(int start, int stop, float *min, float *max) const;
+    // Call after writing to the Min()/Max() buffers directly
+    void InvalidateStats() {
+        _statsValid = false; _powerValid = false; _peaksValid = false;
+        _pyramidValid = false;
+    }
     float* Min() const { return _minBuf; }
     float* Max() const { return _maxBuf; }
     qint64 Time() const { return msFromEpoch; }
@@ -115,6 +156,8 @@ public:
     int UpdateStop() const { return _updateStop; }
 
     void Update(const Trace &other);
+    // Update several traces from one sweep, reading the sweep once
+    static void UpdateAll(Trace *traces, int count, const Trace &other);
     // Export to path, with a given bin size spacing
     // Spacing accomplished via lerping
     bool Export(const QString &path) const;
@@ -131,7 +174,12 @@ public:
     void GetOccupiedBandwidth(OccupiedBandwidthInfo &info) const;
 
 private:
-    void Alloc(int newSize);  // Allocate both buffers length n
+    void Alloc(int newSize);  // Resize both buffers to length n
+    bool BeginUpdate(const Trace &other);
+    void GetUpdateTarget(SimdTraceTarget &target);
+    void BuildPeakTable() const;
+    // As InvalidateStats(), the pyramid is only rebuilt over [start, stop)
+    void InvalidateRange(int start, int stop);
 
     SweepSettings settings;
 
@@ -142,6 +190,7 @@ private:
     int _averageCount;
 
     int _size;
+    int _capacity; // Of both buffers, from the BufferPool
 
     double _binSize; // Either Hz value, or ms in zero-span
     double _start; // Real start freq
@@ -153,31 +202,19 @@ private:
 
     qint64 msFromEpoch;
 
-private:
-    DISALLOW_COPY_AND_ASSIGN(Trace)
-};
-
-class ChannelPower {
-public:
-    ChannelPower();
-    ~ChannelPower();
-
-    void Configure(bool ch_enable, double ch_width, double ch_spacing);
-    void Update(const Trace *trace);
-
-    bool IsEnabled() const { return enabled; }
-
-    bool IsChannelInView(int channel) const;
-    double GetChannelStart(int channel) const;
-    double GetChannelStop(int channel) const;
-    double GetChannelPower(int channel) const;
+    mutable TraceStats _stats;
+    mutable std::vector<double> _powerSum;
+    mutable std::vector<int> _peaks; // Index order
+    mutable std::vector<int> _peaksByAmp; // Highest first
+    mutable bool _statsValid;
+    mutable bool _powerValid;
+    mutable bool _peaksValid;
+    mutable MinMaxPyramid _pyramid;
+    mutable bool _pyramidValid;
+    mutable int _dirtyStart, _dirtyStop; // Empty when equal
 
 private:
-    bool enabled;
-    double width;
-    double spacing;
-    bool in_view[3];
-    double ch_start[3], ch_stop[3], ch_power[3];
+    DISALLOW_COPY_AND_ASSIGN(Trace)
 };
 
 #endif // TRACE_H
@@ -1,6 +1,7 @@
 #include "trace_manager.h"
 #include "sweep_settings.h"
 #include "../widgets/entry_widgets.h"
+#include "../lib/perf_timer.h"
 
 #include <cassert>
 
@@ -103,38 +104,41 @@ void TraceManager::UpdateTraces(Trace *trace)
 {
     Lock();
 
-    // Apply ref-offset first
-    if(ref_offset != 0.0) {
-        trace->ApplyOffset(ref_offset);
-    }
+    {
+        PERF_SCOPE(PerfCorrections);
+
+        // Ref-offset and path-loss in one pass, limit lines are tested
+        //   in the same pass after the amplitude offsets
+        corrections.Apply(trace, ref_offset, pathLoss, limitLine);
 
-    pathLoss.Apply(trace);
-
-    // Determine if the maximum value is above the reference level
-    double peak_freq, peak_amp;
-    Amplitude ref = trace->GetSettings()->RefLevel();
-    trace->GetSignalPeak(&peak_freq, &peak_amp);
-    if(!ref.IsLogScale()) {
-        lastTraceAboveReference = (peak_amp > ref.Val());
-    } else {
-        // Log Scale
-        lastTraceAboveReference = (peak_amp > ref.ConvertToUnits(AmpUnits::DBM));
+        // Determine if the maximum value is above the reference level
+        lastTraceAboveReference = trace->Stats().aboveReference;
     }
 
-    // Limit lines should be tested after any amplitude offsets
-    limitLine.Apply(trace);
+    {
+        PERF_SCOPE(PerfTraceUpdate);
 
-    // Iterate through and update all traces
-    for(int i = 0; i < TRACE_COUNT; i++) {
-        traces[i].Update(*trace);
+        // Update all traces in one pass over the sweep
+        Trace::UpdateAll(traces, TRACE_COUNT, *trace);
     }
 
     Unlock();
 
     if(trace->IsFullSweep()) {
+        PERF_SCOPE(PerfNormalize);
+
         // Place trace in our persist/waterfall buffer
-        normalize_trace(trace, *trace_buffer.Front(), QPoint(1280, 720));
-        trace_buffer.IncrementFront();
+        // Null when the view is still holding the only free slot
+        GLVector *v_ptr = trace_buffer.AcquireWrite();
+        if(v_ptr) {
+            normalize_trace(trace, *v_ptr, QPoint(1280, 720));
+            trace_buffer.CommitWrite();
+        }
+    }
+
+    if(trace->IsFullSweep() && density.IsEnabled()) {
+        PERF_SCOPE(PerfDensity);
+        density.Accumulate(trace);
     }
 
     channel_power.Update(trace);
@@ -146,6 +150,8 @@ void TraceManager::UpdateTraces(Trace *trace)
 
 int TraceManager::SolveMarkers(const SweepSettings *s)
 {
+    PERF_SCOPE(PerfMarkers);
+
     for(int i = 0; i < MARKER_COUNT; i++) {
         GetMarker(i)->UpdateMarker(GetTrace(GetMarker(i)->OnTrace()), s);
     }
@@ -371,8 +377,12 @@ void TraceManager::markerPeakSearch()
 {
     int t = GetActiveMarker()->OnTrace();
 
+    // Peak comes from the trace stats cache, which UpdateTraces()
+    //   rebuilds under the lock
     double freq = 0.0;
+    Lock();
     GetTrace(t)->GetSignalPeak(&freq, nullptr);
+    Unlock();
     if(GetActiveMarker()->Place(freq)) {
         emit updated();
     }
@@ -414,31 +424,18 @@ void TraceManager::markerPeakLeft()
         return;
     }
 
-    std::vector<int> peak_list;
-    trace_ptr->GetPeakList(peak_list);
+    // Peak table is cached, query it under the lock
+    Lock();
+    int peak_ix = trace_ptr->NextPeakLeft(marker_ptr->Index());
+    double freq = trace_ptr->StartFreq() + trace_ptr->BinSize() * peak_ix;
+    Unlock();
 
-    if(peak_list.size() == 0) {
+    // Do nothing if at the first peak
+    if(peak_ix < 0) {
         return;
     }
 
-    int peak_ix = 0;
-    int old_ix = marker_ptr->Index();
-
-    while(peak_ix < peak_list.size()) {
-        if(peak_list[peak_ix] >= old_ix) {
-            break;
-        }
-        peak_ix++;
-    }
-
-    if(peak_ix == 0) {
-        // do nothing
-    } else {
-        marker_ptr->Place(trace_ptr->StartFreq() +
-                          trace_ptr->BinSize() * peak_list[peak_ix-1]);
-        //marker_ptr->Place((double)peak_list[peak_ix-1] / trace_ptr->Length());
-        //marker_ptr->Place(peak_list[peak_ix-1]);
-    }
+    marker_ptr->Place(freq);
 
     emit updated();
 }
@@ -453,34 +450,18 @@ void TraceManager::markerPeakRight()
         return;
     }
 
-    std::vector<int> peak_list;
-    trace_ptr->GetPeakList(peak_list);
+    // Peak table is cached, query it under the lock
+    Lock();
+    int peak_ix = trace_ptr->NextPeakRight(marker_ptr->Index());
+    double freq = trace_ptr->StartFreq() + trace_ptr->BinSize() * peak_ix;
+    Unlock();
 
-    if(peak_list.size() == 0) {
+    // Do nothing if at the last peak
+    if(peak_ix < 0) {
         return;
     }
 
-    int peak_ix = 0;
-    int old_ix = marker_ptr->Index();
-
-    while(peak_ix < peak_list.size()) {
-        if(peak_list[peak_ix] > old_ix) {
-            break;
-        }
-        peak_ix++;
-    }
-
-    //int final_ix = (peak_ix == 0) ? 0 : peak_ix + 1 ;
-    //if(peak_list[final_ix] == old_ix) final_ix++;
-
-    if(peak_ix >= peak_list.size()) {
-        // Do nothing if at last peak
-    } else {
-        marker_ptr->Place(trace_ptr->StartFreq() +
-                          trace_ptr->BinSize() * peak_list[peak_ix]);
-        //marker_ptr->Place((double)peak_list[peak_ix] / trace_ptr->Length());
-        //marker_ptr->Place(peak_list[peak_ix]);
-    }
+    marker_ptr->Place(freq);
 
     emit updated();
 }
@@ -516,6 +497,18 @@ void TraceManager::SetChannelPower(bool enable, Frequency width, Frequency spaci
     channel_power.Configure(enable, width, spacing);
 }
 
+void TraceManager::SetChannelRaster(bool enable, Frequency firstCenter, Frequency spacing,
+                                    Frequency width, int count)
+{
+    channel_power.ConfigureRaster(enable, firstCenter, spacing, width, count);
+}
+
+void TraceManager::SetChannelPlan(bool enable, const std::vector<ChannelDef> &plan,
+                                  int reference)
+{
+    channel_power.ConfigureCustom(enable, plan, reference);
+}
+
 void TraceManager::SetOccupiedBandwidth(bool enabled, double percentPower)
 {
     ocbw.percentPower = percentPower;
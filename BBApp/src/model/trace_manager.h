@@ -9,8 +9,10 @@
 #include "../lib/macros.h"
 #include "../lib/threadsafe_queue.h"
 #include "trace.h"
+#include "channel_power.h"
 #include "marker.h"
 #include "persistence.h"
+#include "spectral_density.h"
 #include "import_table.h"
 
 class Settings;
@@ -86,11 +88,17 @@ public:
     double RefOffset() const { return ref_offset; }
 
     void SetChannelPower(bool enable, Frequency width, Frequency spacing);
+    void SetChannelRaster(bool enable, Frequency firstCenter, Frequency spacing,
+                          Frequency width, int count);
+    void SetChannelPlan(bool enable, const std::vector<ChannelDef> &plan, int reference);
     const ChannelPower* GetChannelPowerInfo() const { return &channel_power; }
 
     void SetOccupiedBandwidth(bool enabled, double percentPower);
     const OccupiedBandwidthInfo& GetOccupiedBandwidthInfo() const { return ocbw; }
 
+    // Full resolution density histogram of every full sweep
+    SpectralDensity* GetSpectralDensity() { return &density; }
+
     // Real-Time and Waterfall trace buffer
     ThreadSafeQueue<GLVector, 32> trace_buffer;
 
@@ -112,11 +120,13 @@ private:
 
     PathLossTable pathLoss;
     LimitLineTable limitLine;
+    CorrectionStage corrections;
 
     double ref_offset; // dB
 
     ChannelPower channel_power;
     OccupiedBandwidthInfo ocbw;
+    SpectralDensity density;
 
     bool lastTraceAboveReference;
 
@@ -0,0 +1,104 @@
+#include "trace_pool.h"
+
+TracePool::TracePool(int slotCount) :
+    inUse(0),
+    closed(true)
+{
+    for(int i = 0; i < slotCount; i++) {
+        slots.push_back(new SweepSlot);
+    }
+    Open();
+}
+
+TracePool::~TracePool()
+{
+    Close();
+
+    for(SweepSlot *slot : slots) {
+        delete slot;
+    }
+}
+
+SweepSlot* TracePool::AcquireFree()
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    while(freeSlots.empty() && !closed) {
+        freeCond.wait(lock);
+    }
+
+    if(closed) {
+        return nullptr;
+    }
+
+    SweepSlot *slot = freeSlots.front();
+    freeSlots.pop_front();
+    return slot;
+}
+
+void TracePool::PushFull(SweepSlot *slot)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    fullSlots.push_back(slot);
+    fullCond.notify_one();
+}
+
+void TracePool::ReturnFree(SweepSlot *slot)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    freeSlots.push_front(slot);
+    freeCond.notify_one();
+}
+
+SweepSlot* TracePool::AcquireFull()
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    while(fullSlots.empty() && !closed) {
+        fullCond.wait(lock);
+    }
+
+    if(fullSlots.empty()) {
+        return nullptr;
+    }
+
+    SweepSlot *slot = fullSlots.front();
+    fullSlots.pop_front();
+    inUse++;
+    return slot;
+}
+
+void TracePool::Release(SweepSlot *slot)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    inUse--;
+    freeSlots.push_back(slot);
+    freeCond.notify_one();
+    if(fullSlots.empty() && inUse == 0) {
+        drainCond.notify_all();
+    }
+}
+
+void TracePool::Drain()
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    while(!fullSlots.empty() || inUse > 0) {
+        drainCond.wait(lock);
+    }
+}
+
+void TracePool::Open()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    Q_ASSERT(fullSlots.empty() && inUse == 0);
+
+    freeSlots.assign(slots.begin(), slots.end());
+    fullSlots.clear();
+    closed = false;
+}
+
+void TracePool::Close()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    closed = true;
+    freeCond.notify_all();
+    fullCond.notify_all();
+}
@@ -0,0 +1,69 @@
+#ifndef TRACE_POOL_H
+#define TRACE_POOL_H
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+#include "trace.h"
+
+// One preallocated sweep buffer handed between the acquisition
+//   and processing threads
+struct SweepSlot {
+    SweepSlot() : trace(true), generation(0) {}
+
+    Trace trace;
+    RealTimeFrame rtFrame;
+    // Configuration count the sweep was acquired under
+    int generation;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(SweepSlot)
+};
+
+/*
+ * Fixed set of sweep buffers cycled between a free list and a
+ *   FIFO of filled sweeps. The producer blocks when every slot is
+ *   in use, no buffers are allocated while streaming.
+ */
+class TracePool {
+public:
+    TracePool(int slotCount = 2);
+    ~TracePool();
+
+    // Producer side
+    // Returns nullptr once the pool is closed
+    SweepSlot* AcquireFree();
+    void PushFull(SweepSlot *slot);
+    // Return a slot that was acquired but not filled
+    void ReturnFree(SweepSlot *slot);
+
+    // Consumer side
+    // Blocks until a filled slot is available, returns nullptr once
+    //   the pool is closed and every filled slot has been consumed
+    SweepSlot* AcquireFull();
+    void Release(SweepSlot *slot);
+
+    // Block until every filled slot has been consumed and released
+    // Call from the producer before reconfiguring the device
+    void Drain();
+
+    // Reopen for a new streaming session, all slots free
+    void Open();
+    // Wake all waiters, consumers finish the remaining filled slots
+    void Close();
+
+private:
+    std::vector<SweepSlot*> slots;
+    std::deque<SweepSlot*> freeSlots, fullSlots;
+    int inUse; // Acquired by the consumer
+    bool closed;
+
+    std::mutex mtx;
+    std::condition_variable freeCond, fullCond, drainCond;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(TracePool)
+};
+
+#endif // TRACE_POOL_H
@@ -3,6 +3,7 @@
 #include "demod_iq_time_plot.h"
 #include "demod_spectrum_plot.h"
 #include "demod_sweep_plot.h"
+#include "lib/perf_timer.h"
 
 #include <QXmlStreamWriter>
 #include <iostream>
@@ -391,19 +392,29 @@ void DemodCentral::StreamThread()
             }
             qint64 start = bb_lib::get_ms_since_epoch();
 
-            if(!GetCapture(sessionPtr->demod_settings, iqc, sweep, sessionPtr->device)) {
+            bool captured;
+            {
+                PERF_SCOPE(PerfFetch);
+                captured = GetCapture(sessionPtr->demod_settings, iqc, sweep, sessionPtr->device);
+            }
+            if(!captured) {
                 streaming = false;
                 return;
             }
+            PerfStats::Instance().CountSweep();
 
             if(recordNext && sweep.triggered) {
+                PERF_SCOPE(PerfRecord);
                 RecordIQCapture(sweep, iqc, sessionPtr->device);
             }
 
             if(demodArea->viewLock.try_lock()) {
-                sweep.Demod();
-                if(sweep.settings.MAEnabled()) {
-                    sweep.CalculateReceiverStats();
+                {
+                    PERF_SCOPE(PerfDemod);
+                    sweep.Demod();
+                    if(sweep.settings.MAEnabled()) {
+                        sweep.CalculateReceiverStats();
+                    }
                 }
                 sessionPtr->iq_capture = sweep;
                 UpdateView();
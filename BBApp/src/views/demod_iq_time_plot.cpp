@@ -1,4 +1,5 @@
 #include "demod_iq_time_plot.h"
+#include "lib/perf_timer.h"
 
 DemodIQTimePlot::DemodIQTimePlot(Session *session, QWidget *parent) :
     GLSubView(session, parent),
@@ -35,6 +36,8 @@ void DemodIQTimePlot::resizeEvent(QResizeEvent *)
 
 void DemodIQTimePlot::paintEvent(QPaintEvent *)
 {
+    PERF_SCOPE(PerfPaint);
+
     makeCurrent();
 
     glQClearColor(GetSession()->colors.background);
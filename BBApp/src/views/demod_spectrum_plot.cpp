@@ -1,4 +1,5 @@
 #include "demod_spectrum_plot.h"
+#include "lib/perf_timer.h"
 #include <iostream>
 
 DemodSpectrumPlot::DemodSpectrumPlot(Session *sPtr, QWidget *parent) :
@@ -37,6 +38,8 @@ void DemodSpectrumPlot::resizeEvent(QResizeEvent *)
 
 void DemodSpectrumPlot::paintEvent(QPaintEvent *)
 {
+    PERF_SCOPE(PerfPaint);
+
     makeCurrent();
 
     glQClearColor(GetSession()->colors.background);
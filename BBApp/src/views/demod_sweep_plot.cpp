@@ -1,4 +1,5 @@
 #include "demod_sweep_plot.h"
+#include "lib/perf_timer.h"
 
 #include <QLayout>
 #include <QMouseEvent>
@@ -54,6 +55,8 @@ void DemodSweepPlot::mousePressEvent(QMouseEvent *e)
 
 void DemodSweepPlot::paintEvent(QPaintEvent *)
 {
+    PERF_SCOPE(PerfPaint);
+
     makeCurrent();
 
     if(GetSession()->demod_settings->MAEnabled()) {
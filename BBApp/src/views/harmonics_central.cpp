@@ -1,5 +1,6 @@
 #include "harmonics_central.h"
 #include "model/session.h"
+#include "lib/perf_timer.h"
 
 HarmonicsCentral::HarmonicsCentral(Session *sPtr,
                                    QToolBar *toolBar,
@@ -104,8 +105,15 @@ void HarmonicsCentral::SweepThread()
 
 //            plot->traceLock[i].lock();
             session_ptr->device->Reconfigure(&hss, &ht);
-            session_ptr->device->GetSweep(&hss, &ht);
-            plot->harmonics[i].Update(ht);
+            {
+                PERF_SCOPE(PerfFetch);
+                session_ptr->device->GetSweep(&hss, &ht);
+            }
+            {
+                PERF_SCOPE(PerfTraceUpdate);
+                plot->harmonics[i].Update(ht);
+            }
+            PerfStats::Instance().CountSweep();
 //            plot->traceLock[i].unlock();
 
             emit updateView();
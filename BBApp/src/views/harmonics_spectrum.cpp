@@ -1,4 +1,5 @@
 #include "harmonics_spectrum.h"
+#include "lib/perf_timer.h"
 
 static const float harmonicBorderPoints[] =
 {
@@ -58,6 +59,8 @@ void HarmonicsSpectrumPlot::resizeEvent(QResizeEvent *)
 
 void HarmonicsSpectrumPlot::paintEvent(QPaintEvent *)
 {
+    PERF_SCOPE(PerfPaint);
+
     makeCurrent();
 
     glQClearColor(GetSession()->colors.background);
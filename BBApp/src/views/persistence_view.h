@@ -87,14 +87,15 @@ public:
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 
+        // Image is already colored, no persistence shader
+        const unsigned char *image = persistence_model->GetImage();
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA,
                      persistence_model->Width(),
                      persistence_model->Height(), 0,
-                     GL_RGBA, GL_FLOAT,
-                     (unsigned char*)persistence_model->GetImage());
+                     GL_RGBA, GL_UNSIGNED_BYTE,
+                     image);
 
         // Draw a single quad over our grat
-        glUseProgram(persist_program->Handle());
         //glBindTexture(GL_TEXTURE_2D, persistTex);
         //glGenerateMipmap(GL_TEXTURE_2D);
 
@@ -123,8 +124,6 @@ public:
         glMatrixMode(GL_PROJECTION);
         glPopMatrix();
         //glLoadIdentity();
-
-        glUseProgram(0);
     }
 };
 
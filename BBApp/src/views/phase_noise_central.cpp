@@ -1,5 +1,6 @@
 #include "phase_noise_central.h"
 #include "model/session.h"
+#include "lib/perf_timer.h"
 
 PhaseNoiseCentral::PhaseNoiseCentral(Session *sPtr,
                                      QToolBar *mainToolBar,
@@ -213,7 +214,10 @@ void PhaseNoiseCentral::SweepThread()
 
             if(decade < 5) {
                 session_ptr->device->Reconfigure(&ps, &p);
-                session_ptr->device->GetSweep(&ps, &p);
+                {
+                    PERF_SCOPE(PerfFetch);
+                    session_ptr->device->GetSweep(&ps, &p);
+                }
                 sweepStartFreq = p.StartFreq();
 
                 // Copy sweep to temp arrays
@@ -224,7 +228,10 @@ void PhaseNoiseCentral::SweepThread()
             } else {
                 // Sweep 100k - 1M with slow sweep
                 session_ptr->device->Reconfigure(&ps, &p);
-                session_ptr->device->GetSweep(&ps, &p);
+                {
+                    PERF_SCOPE(PerfFetch);
+                    session_ptr->device->GetSweep(&ps, &p);
+                }
                 sweepStartFreq = p.StartFreq();
                 // Copy sweep to temp arrays
                 for(int i = 0; i < p.Length(); i++) {
@@ -236,7 +243,10 @@ void PhaseNoiseCentral::SweepThread()
                     ps.setCenter(peakFreq + 300.0e3 + 200.0e3 * step);
                     ps.setSpan(200.0e3);
                     session_ptr->device->Reconfigure(&ps, &p);
-                    session_ptr->device->GetSweep(&ps, &p);
+                    {
+                        PERF_SCOPE(PerfFetch);
+                        session_ptr->device->GetSweep(&ps, &p);
+                    }
 
                     double stopOfPrev = sweepStartFreq + pTempMin.size() * p.BinSize();
                     int startIx = double(stopOfPrev - p.StartFreq()) / p.BinSize();
@@ -316,7 +326,9 @@ void PhaseNoiseCentral::SweepThread()
             }
         }
 
+        fullSweep.InvalidateStats();
         session_ptr->trace_manager->UpdateTraces(&fullSweep);
+        PerfStats::Instance().CountSweep();
         emit updateView();
     }
 
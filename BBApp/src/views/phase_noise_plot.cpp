@@ -1,4 +1,5 @@
 #include "phase_noise_plot.h"
+#include "lib/perf_timer.h"
 
 #include <QMouseEvent>
 
@@ -57,6 +58,8 @@ void PhaseNoisePlot::mousePressEvent(QMouseEvent *e)
 
 void PhaseNoisePlot::paintEvent(QPaintEvent *)
 {
+    PERF_SCOPE(PerfPaint);
+
     makeCurrent();
 
     glQClearColor(GetSession()->colors.background);
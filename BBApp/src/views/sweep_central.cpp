@@ -11,6 +11,7 @@
 #include "../model/session.h"
 #include "../model/trace.h"
 #include "../model/playback_toolbar.h"
+#include "../lib/perf_timer.h"
 #include "../widgets/entry_widgets.h"
 #include "../widgets/audio_dialog.h"
 
@@ -21,6 +22,15 @@ SweepCentral::SweepCentral(Session *sPtr,
     : CentralWidget(parent, f),
       session_ptr(sPtr),
       trace(true),
+      generation(0),
+      slotLength(0),
+      slotBinSize(0.0),
+      slotStartFreq(0.0),
+      slotUpdateStart(0),
+      slotUpdateStop(0),
+      stitch(&sPtr->prefs),
+      stitching(false),
+      borrowing(false),
       programClosing(false)
 {
     trace_view = new TraceView(session_ptr, this);
@@ -156,7 +166,9 @@ void SweepCentral::StartStreaming()
 {
     sweeping = true;
 
+    pool.Open();
     thread_handle = std::thread(&SweepCentral::SweepThread, this);
+    process_thread_handle = std::thread(&SweepCentral::ProcessThread, this);
 }
 
 void SweepCentral::StopStreaming()
@@ -165,6 +177,10 @@ void SweepCentral::StopStreaming()
         sweeping = false;
         thread_handle.join();
     }
+    // Sweep thread closes the pool on exit
+    if(process_thread_handle.joinable()) {
+        process_thread_handle.join();
+    }
 }
 
 void SweepCentral::ResetView()
@@ -201,9 +217,14 @@ void SweepCentral::wheelEvent(QWheelEvent *we)
 
 // Try new settings
 // If new settings fail, revert to old settings
+// Only called from the sweep thread with the pool drained
 void SweepCentral::Reconfigure()
 {
-    if(!session_ptr->device->Reconfigure(session_ptr->sweep_settings, &trace)) {
+    stitching = ReconfigureStitched();
+
+    if(stitching) {
+        last_config = *session_ptr->sweep_settings;
+    } else if(!session_ptr->device->Reconfigure(session_ptr->sweep_settings, &trace)) {
         *session_ptr->sweep_settings = last_config;
     } else {
         last_config = *session_ptr->sweep_settings;
@@ -213,54 +234,121 @@ void SweepCentral::Reconfigure()
         rtFrame.SetDimensions(session_ptr->device->RealTimeFrameSize());
     }
 
+    slotSettings = *trace.GetSettings();
+    slotLength = trace.Length();
+    slotBinSize = trace.BinSize();
+    slotStartFreq = trace.StartFreq();
+    slotUpdateStart = trace.UpdateStart();
+    slotUpdateStop = trace.UpdateStop();
+
     if(sweep_count == 0) {
         sweep_count = 1;
     }
+    generation++;
     reconfigure = false;
 }
 
+// Split the sweep across the primary and additional devices when enabled
+// Returns false if the sweep should be taken by the primary device alone
+bool SweepCentral::ReconfigureStitched()
+{
+    if(!session_ptr->prefs.stitchedSweeps ||
+            session_ptr->sweep_settings->Mode() != MODE_SWEEPING) {
+        ReleaseStitched();
+        return false;
+    }
+
+    std::vector<Device*> devices;
+    devices.push_back(session_ptr->device);
+    if(!borrowing) {
+        borrowed = session_ptr->BorrowDevices();
+        borrowing = true;
+    }
+    devices.insert(devices.end(), borrowed.begin(), borrowed.end());
+
+    if(!stitch.Configure(devices, session_ptr->sweep_settings, &trace)) {
+        ReleaseStitched();
+        return false;
+    }
+
+    return true;
+}
+
+void SweepCentral::ReleaseStitched()
+{
+    stitch.Release();
+    if(borrowing) {
+        borrowed.clear();
+        session_ptr->ReturnDevices();
+        borrowing = false;
+    }
+}
+
 // Main sweep loop
+// Acquires sweeps into pool slots, the process thread consumes them
+//   so the next device fetch overlaps the trace processing
 void SweepCentral::SweepThread()
 {
     Reconfigure();
 
     while(sweeping) {
         if(reconfigure) {
+            // Finish processing sweeps from the previous configuration
+            pool.Drain();
             Reconfigure();
             session_ptr->trace_manager->ClearAllTraces();
         }
 
         if(sweep_count) {
-//            if(!session_ptr->device->GetSweep(session_ptr->sweep_settings, &trace)) {
-//                sweeping = false;
-//                return;
-//            }
+            SweepSlot *slot = pool.AcquireFree();
+            if(!slot) {
+                break;
+            }
+
+            // Match slot to the current configuration
+            if(slot->generation != generation) {
+                slot->trace.SetSettings(slotSettings);
+                slot->trace.SetSize(slotLength);
+                slot->trace.SetFreq(slotBinSize, slotStartFreq);
+                if(slotLength > 0) {
+                    slot->trace.SetUpdateRange(slotUpdateStart, slotUpdateStop);
+                }
+                if(last_config.Mode() == MODE_REAL_TIME) {
+                    slot->rtFrame.SetDimensions(rtFrame.dim);
+                }
+                slot->generation = generation;
+            }
 
             bool sweepSuccess;
-            if(last_config.Mode() == MODE_REAL_TIME) {
-                sweepSuccess = session_ptr->device->GetRealTimeFrame(trace, rtFrame);
-            } else {
-                sweepSuccess = session_ptr->device->GetSweep(&last_config, &trace);
+            {
+                PERF_SCOPE(PerfFetch);
+                if(stitching) {
+                    sweepSuccess = stitch.GetSweep(&slot->trace);
+                } else if(last_config.Mode() == MODE_REAL_TIME) {
+                    sweepSuccess = session_ptr->device->GetRealTimeFrame(slot->trace, slot->rtFrame);
+                } else {
+                    sweepSuccess = session_ptr->device->GetSweep(&last_config, &slot->trace);
+                }
             }
 
             if(!sweepSuccess) {
+                pool.ReturnFree(slot);
                 sweeping = false;
+                // Sweeps already queued are processed, as on a normal exit
+                pool.Drain();
+                pool.Close();
+                ReleaseStitched();
                 return;
             }
 
-            if(trace.IsFullSweep()) {
-                playback->PutTrace(&trace);
+            bool fullSweep = slot->trace.IsFullSweep();
+            pool.PushFull(slot);
+            if(fullSweep) {
+                PerfStats::Instance().CountSweep();
             }
 
-            session_ptr->trace_manager->UpdateTraces(&trace);
-            if(last_config.IsRealTime()) {
-                session_ptr->trace_manager->realTimeFrame = rtFrame;
-            }
-
-            emit updateView();
-
             // Non-negative sweep count means we only collect 'n' more sweeps
-            if(sweep_count > 0 && trace.IsFullSweep()) {
+            if(sweep_count > 0 && fullSweep) {
                 sweep_count--;
             }
 
@@ -274,9 +362,58 @@ void SweepCentral::SweepThread()
         }
     }
 
+    pool.Drain();
+    pool.Close();
+    ReleaseStitched();
     session_ptr->device->Abort();
 }
 
+// Runs until the sweep thread closes the pool
+void SweepCentral::ProcessThread()
+{
+    SweepSlot *slot;
+
+    while((slot = pool.AcquireFull()) != nullptr) {
+        ProcessSweep(slot);
+        pool.Release(slot);
+    }
+}
+
+void SweepCentral::ProcessSweep(SweepSlot *slot)
+{
+    Trace *sweep = &slot->trace;
+
+    // Partial sweeps only update a portion of the slot, assemble
+    //   them into the configured trace so every pass sees the full sweep
+    if(sweep->UpdateStart() != 0 || !sweep->IsFullSweep()) {
+        int start = sweep->UpdateStart(), stop = sweep->UpdateStop();
+        // Device resized the slot during the fetch, follow it, only the
+        //   process thread touches trace outside of Reconfigure()
+        if(trace.Length() != sweep->Length()) {
+            trace.SetSettings(*sweep->GetSettings());
+            trace.SetSize(sweep->Length());
+            trace.SetFreq(sweep->BinSize(), sweep->StartFreq());
+        }
+        simdCopy_32f(sweep->Min() + start, trace.Min() + start, stop - start);
+        simdCopy_32f(sweep->Max() + start, trace.Max() + start, stop - start);
+        trace.InvalidateStats();
+        trace.SetUpdateRange(start, stop);
+        sweep = &trace;
+    }
+
+    if(sweep->IsFullSweep()) {
+        PERF_SCOPE(PerfRecord);
+        playback->PutTrace(sweep);
+    }
+
+    session_ptr->trace_manager->UpdateTraces(sweep);
+    if(last_config.IsRealTime()) {
+        session_ptr->trace_manager->realTimeFrame = slot->rtFrame;
+    }
+
+    emit updateView();
+}
+
 /*
  * Save current settings and title to temporaries
  * When finally complete, restore them
@@ -6,6 +6,8 @@
 
 #include "views/central_stack.h"
 #include "../model/session.h"
+#include "../model/trace_pool.h"
+#include "../model/stitched_sweep.h"
 #include "../widgets/entry_widgets.h"
 
 class QToolBar;
@@ -40,13 +42,35 @@ protected:
 
 private:
     void Reconfigure();
+    bool ReconfigureStitched();
+    void ReleaseStitched();
     void SweepThread();
+    // Consumes sweeps acquired by the sweep thread
+    void ProcessThread();
+    void ProcessSweep(SweepSlot *slot);
     void PlaybackThread();
 
     bool reconfigure;
+    // Device configured trace, also holds the assembled partial sweeps
     Trace trace;
     RealTimeFrame rtFrame;
     SweepSettings last_config; // Last known working settings
+    // Sweep buffers in flight between the sweep and process threads
+    TracePool pool;
+    int generation; // Incremented on each reconfigure
+    // Configured trace geometry, copied in Reconfigure() while the pool is
+    //   drained, the sweep thread sizes slots from these and never reads
+    //   trace, which the process thread writes
+    SweepSettings slotSettings;
+    int slotLength;
+    double slotBinSize, slotStartFreq;
+    int slotUpdateStart, slotUpdateStop;
+    // Wide sweeps split across the primary and additional devices
+    StitchedSweep stitch;
+    bool stitching; // Current configuration is stitched
+    // Additional devices lent by the session while stitching
+    std::vector<Device*> borrowed;
+    bool borrowing;
 
     TraceView *trace_view;
 
@@ -65,6 +89,7 @@ private:
     Session *session_ptr;
 
     std::thread thread_handle;
+    std::thread process_thread_handle;
     bool programClosing;
     std::atomic<bool> sweeping;
     std::atomic<int> sweep_count;
@@ -1,5 +1,6 @@
 #include "tg_central.h"
 #include "model/session.h"
+#include "lib/perf_timer.h"
 
 #include <iostream>
 
@@ -113,7 +114,13 @@ void TGCentral::SweepThread()
         }
 
         if(sweepCount) {
-            session_ptr->device->GetSweep(session_ptr->sweep_settings, &trace);
+            {
+                PERF_SCOPE(PerfFetch);
+                session_ptr->device->GetSweep(session_ptr->sweep_settings, &trace);
+            }
+            if(trace.IsFullSweep()) {
+                PerfStats::Instance().CountSweep();
+            }
             session_ptr->trace_manager->UpdateTraces(&trace);
             emit updateView();
 
@@ -1,4 +1,5 @@
 #include "tg_trace_view.h"
+#include "lib/perf_timer.h"
 #include "mainwindow.h"
 
 #include <QMouseEvent>
@@ -79,6 +80,8 @@ void TGPlot::mouseMoveEvent(QMouseEvent *e)
 
 void TGPlot::paintEvent(QPaintEvent *)
 {
+    PERF_SCOPE(PerfPaint);
+
     makeCurrent();
 
     glQClearColor(GetSession()->colors.background);
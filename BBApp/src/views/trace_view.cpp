@@ -2,6 +2,7 @@
 #include "model/session.h"
 #include "model/trace.h"
 #include "lib/bb_lib.h"
+#include "lib/perf_timer.h"
 #include "mainwindow.h"
 
 #include <QToolTip>
@@ -12,6 +13,10 @@
 
 #define PERSIST_WIDTH 1280
 #define PERSIST_HEIGHT 720
+// Fraction of the persistence buffer removed, and the intensity added,
+//   per sweep
+#define PERSIST_DECAY 0.02
+#define PERSIST_ADD 0.04
 
 
 #pragma warning(disable:4305)
@@ -69,6 +74,8 @@ TraceView::TraceView(Session *session, QWidget *parent)
     : GLSubView(session, parent),
       persist_on(false),
       clear_persistence(false),
+      traceBufferOverflow(false),
+      lastTraceBufferDrops(0),
       waterfall_state(WaterfallOFF),
       textFont(12),
       divFont(12),
@@ -199,7 +206,7 @@ bool TraceView::InitPersistFBO()
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE); // automatic mipmap
+    // Sampled with GL_LINEAR only, no mipmaps
     glTexImage2D(GL_TEXTURE_2D,	0, GL_RGBA,	PERSIST_WIDTH, PERSIST_HEIGHT,
                  0, GL_RGBA,	GL_UNSIGNED_BYTE, 0);
     glBindTexture(GL_TEXTURE_2D, 0);
@@ -249,6 +256,7 @@ void TraceView::paintEvent(QPaintEvent *)
 {
     // Draw if possible, otherwise nothing?
     if(drawMutex.try_lock()) {
+        PERF_SCOPE(PerfPaint);
         paintCondition.notify();
         Paint();
         context()->moveToThread(swap_thread);
@@ -570,7 +578,20 @@ void TraceView::RenderGratText(QPainter &p)
         } else {
             //glColor3f(1.0, 0.0, 0.0);
             p.setPen(QPen(QColor(255, 0, 0)));
-            DrawString(p, "Failed", limitTextLoc, CENTER_ALIGNED);
+            // Ranges were read when the limit lines were drawn
+            QString failStr = "Failed";
+            if(!limitViolations.empty()) {
+                const LimitViolation *worst = &limitViolations[0];
+                for(const LimitViolation &v : limitViolations) {
+                    if(v.worstMargin > worst->worstMargin) worst = &v;
+                }
+                failStr += QString(", %1 ranges, worst %2 %3 at %4")
+                        .arg((int)limitViolations.size())
+                        .arg(worst->worstMargin, 0, 'f', 2)
+                        .arg(s->RefLevel().IsLogScale() ? "dB" : "mV")
+                        .arg(Frequency(worst->worstFreq).GetFreqString());
+            }
+            DrawString(p, failStr, limitTextLoc, CENTER_ALIGNED);
         }
     }
 
@@ -607,6 +628,10 @@ void TraceView::RenderGratText(QPainter &p)
             DrawString(p, "PLT", uncal_x, uncal_y, LEFT_ALIGNED);
             uncal_y -= textHeight;
         }
+        if(traceBufferOverflow) {
+            DrawString(p, "Sweeps Dropped", uncal_x, uncal_y, LEFT_ALIGNED);
+            uncal_y -= textHeight;
+        }
         if(uncal) {
             DrawString(p, "Uncal", grat_ul.x() - 5, grat_ul.y() + 2, RIGHT_ALIGNED);
         }
@@ -624,16 +649,40 @@ void TraceView::RenderTraces()
 
     // Un-buffer persist/waterfall data
     if(persist_on || (waterfall_state != WaterfallOFF)) {
-        GLVector *v_ptr = nullptr;
-        while(v_ptr = manager->trace_buffer.Back()) {
+        // Sweeps arriving after this are picked up next frame
+        int pending = manager->trace_buffer.Count();
+        if(persist_on && pending > 0) {
+            BeginPersistence(pending);
+        }
+
+        for(int i = 0; i < pending; i++) {
+            const GLVector *v_ptr = manager->trace_buffer.AcquireRead();
+            if(!v_ptr) {
+                break;
+            }
             if(persist_on) {
-                AddToPersistence(*v_ptr);
+                PERF_SCOPE(PerfPersistence);
+                AddToPersistence(*v_ptr, pending - 1 - i);
             }
             if(waterfall_state != WaterfallOFF) {
                 AddToWaterfall(*v_ptr);
             }
-            manager->trace_buffer.IncrementBack();
+            manager->trace_buffer.ReleaseRead();
+        }
+
+        if(persist_on && pending > 0) {
+            EndPersistence();
         }
+
+        // Sweeps lost to overflow since the last frame
+        quint64 dropped = manager->trace_buffer.Counters().dropped;
+        traceBufferOverflow = (dropped != lastTraceBufferDrops);
+        lastTraceBufferDrops = dropped;
+    } else {
+        // Nothing to accumulate, keep the buffer from overflowing
+        manager->trace_buffer.Discard();
+        lastTraceBufferDrops = manager->trace_buffer.Counters().dropped;
+        traceBufferOverflow = false;
     }
 
     if(GetSession()->sweep_settings->IsRealTime()) {
@@ -691,6 +740,7 @@ void TraceView::RenderTraces()
                         ss->RefLevel(),
                         ss->Div());
         DrawLimitLines(&manager->GetLimitLine()->store, traces[0]);
+        DrawLimitViolations(&manager->GetLimitLine()->store);
     }
 
     // Disable nice lines
@@ -929,23 +979,31 @@ void TraceView::RenderChannelPower()
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    for(int i = 0; i < 3; i++) {
-        if(!cp->IsChannelInView(i)) continue;
+    std::vector<ChannelResult> channels;
+    cp->GetResults(channels);
+    bool adjacent = (cp->PlanType() == ChannelPlanAdjacent);
+    int reference = cp->ReferenceChannel();
+    // Get largest possible width with extra space
+    int textWidth = textFont.GetTextWidth(" -12.345 dBm");
+
+    for(int i = 0; i < (int)channels.size(); i++) {
+        const ChannelResult &ch = channels[i];
+        if(!ch.inView) continue;
 
-        double x1 = (cp->GetChannelStart(i) - start) / span,
-                x2 = (cp->GetChannelStop(i) - start) / span;
+        double x1 = (ch.start - start) / span,
+                x2 = (ch.stop - start) / span;
         double xCen = (x1 + x2) / 2.0;
 
-        if(i != 1) { // Push channel text out 100 px?
+        if(adjacent && i != 1) { // Push channel text out 100 px?
             int realCenter = grat_sz.x() / 2;
-            // Get largest possible width with extra space
-            int textWidth = textFont.GetTextWidth(" -12.345 dBm");
             if(abs(xCen*grat_sz.x() - realCenter) < textWidth) {
                 xCen = double(realCenter + (i-1)*textWidth) / grat_sz.x();
             }
         }
 
-        glColor4f(0.5, 0.5, 0.5, 0.4);
+        // Alternate shades so neighboring raster channels stay distinct
+        float shade = (adjacent || (i & 1) == 0) ? 0.5 : 0.35;
+        glColor4f(shade, shade, shade, 0.4);
         glBegin(GL_QUADS);
         glVertex2f(x1 * grat_sz.x(), 0.0);
         glVertex2f(x2 * grat_sz.x(), 0.0);
@@ -953,10 +1011,16 @@ void TraceView::RenderChannelPower()
         glVertex2f(x1 * grat_sz.x(), grat_sz.y());//1.0);
         glEnd();
 
+        // Dense plans only label channels wide enough for the text,
+        //   the full list is in the channel power table
+        if(!adjacent && (x2 - x1) * grat_sz.x() < textWidth) {
+            continue;
+        }
+
         // Draw channel power text
         glQColor(GetSession()->colors.text);
         QString cp_string;
-        Amplitude power(cp->GetChannelPower(i), (printUnits == MV) ? MV : DBM);
+        Amplitude power(ch.power, (printUnits == MV) ? MV : DBM);
 //        DrawString(power.ConvertToUnits(printUnits).GetString(),
 //                   textFont, xCen * grat_sz.x(), textFont.GetTextHeight()*3 + 2, CENTER_ALIGNED);
         AddTextToRender(power.ConvertToUnits(printUnits).GetString(),
@@ -964,9 +1028,9 @@ void TraceView::RenderChannelPower()
                                textFont.GetTextHeight()*3 + 2 + grat_ll.y()),
                         CENTER_ALIGNED, textFont.Font(), GetSession()->colors.text);
 
-        // Draw adjacent channel power text
-        if(i == 0 || i == 2) {
-            cp_string.sprintf("%.2f %s", cp->GetChannelPower(i) - cp->GetChannelPower(1),
+        // Draw power relative to the reference channel
+        if(reference >= 0 && i != reference) {
+            cp_string.sprintf("%.2f %s", ch.relative,
                               (printUnits == MV) ? "mV" : "dBc");
 //            DrawString(cp_string, textFont, xCen * grat_sz.x(),
 //                       textFont.GetTextHeight()*2 + 2, CENTER_ALIGNED);
@@ -1035,10 +1099,11 @@ void TraceView::RenderOccupiedBandwidth()
 void TraceView::DrawPersistence()
 {
     // Draw a single quad over our grat
+    // The 8-bit FBO texture is colored by the shader, the minify filter
+    //   is GL_LINEAR so no mipmaps are rebuilt per frame
     glUseProgram(persist_program->ProgramHandle());
     glEnable(GL_TEXTURE_2D);
     glBindTexture(GL_TEXTURE_2D, persist_tex);
-    glGenerateMipmap(GL_TEXTURE_2D);
 
     glMatrixMode(GL_MODELVIEW);
     glPushMatrix();
@@ -1143,6 +1208,30 @@ void TraceView::DrawLimitLines(const Trace *limitTrace, const GLVector &v)
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
+// Red bar along the bottom of the graticule under each failing range,
+//   x as in normalize_trace()
+void TraceView::DrawLimitViolations(const Trace *limitTrace)
+{
+    GetSession()->trace_manager->GetLimitLine()->GetViolations(limitViolations);
+    if(limitViolations.empty() || limitTrace->Length() < 2) return;
+
+    double xScale = 1.0 / (limitTrace->Length() - 1);
+    // Single bin ranges still get a visible width
+    double minWidth = 2.0 / grat_sz.x();
+
+    glColor3f(1.0, 0.0, 0.0);
+    glBegin(GL_QUADS);
+    for(const LimitViolation &v : limitViolations) {
+        double x0 = v.start * xScale;
+        double x1 = bb_lib::max2((v.stop - 1) * xScale, x0 + minWidth);
+        glVertex2f(x0, 0.0);
+        glVertex2f(x1, 0.0);
+        glVertex2f(x1, 0.015);
+        glVertex2f(x0, 0.015);
+    }
+    glEnd();
+}
+
 void TraceView::DrawBackdrop(QPoint pos, QPoint size)
 {
 //    glMatrixMode(GL_MODELVIEW);
@@ -1172,10 +1261,11 @@ void TraceView::DrawBackdrop(QPoint pos, QPoint size)
 //    glPopMatrix();
 }
 
-void TraceView::AddToPersistence(const GLVector &v)
+// Decay is lazy, the buffer is decayed once per frame for every sweep
+//   drawn this frame, and each sweep is drawn pre-decayed by the number
+//   of sweeps that follow it, so one FBO pass serves every buffered sweep
+void TraceView::BeginPersistence(int sweeps)
 {
-    if(v.size() < 1) return;
-
     // Prep GL state, bind FBO
     glBindFramebuffer(GL_FRAMEBUFFER, persist_fbo);
 
@@ -1204,9 +1294,10 @@ void TraceView::AddToPersistence(const GLVector &v)
     glEnable(GL_BLEND);
     glBlendEquation(GL_FUNC_ADD);
 
-    // Reduce current color by blending a big full screen quad
+    // Reduce current color by blending a big full screen quad, one
+    //   quad covers the decay of every sweep this frame
     glBlendFunc(GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
-    glColor4f(0.0, 0.0, 0.0, 0.02);
+    glColor4f(0.0, 0.0, 0.0, 1.0 - pow(1.0 - PERSIST_DECAY, sweeps));
     glBegin(GL_QUADS);
     glTexCoord2f(0,0); glVertex2f(0,0);
     glTexCoord2f(0,1); glVertex2f(0,1);
@@ -1214,10 +1305,18 @@ void TraceView::AddToPersistence(const GLVector &v)
     glTexCoord2f(1,0); glVertex2f(1,0);
     glEnd();
 
-    // Prep the trace, use decay rate to add to persistence
     glBlendFunc(GL_ONE, GL_ONE);
     glBindBuffer(GL_ARRAY_BUFFER, traceVBO);
-    glColor3f(0.04, 0.04, 0.04);
+}
+
+// age, sweeps drawn after this one in the same frame
+void TraceView::AddToPersistence(const GLVector &v, int age)
+{
+    if(v.size() < 1) return;
+
+    // Prep the trace, use decay rate to add to persistence
+    float add = PERSIST_ADD * pow(1.0 - PERSIST_DECAY, age);
+    glColor3f(add, add, add);
     glBufferData(GL_ARRAY_BUFFER, v.size() * sizeof(float),
                   &v[0], GL_DYNAMIC_DRAW);
     glVertexPointer(2, GL_FLOAT, 0, (GLvoid*)0);
@@ -1232,7 +1331,11 @@ void TraceView::AddToPersistence(const GLVector &v)
     glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
     glDrawArrays(GL_QUAD_STRIP, 0, v.size() / 2);
     glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glTranslatef(0, 0, 0.5);
+}
 
+void TraceView::EndPersistence()
+{
     // Revert GL state
     glDisable(GL_BLEND);
     glDepthFunc(GL_LEQUAL);
@@ -12,6 +12,7 @@
 #include <QApplication>
 
 #include "lib/bb_lib.h"
+#include "model/import_table.h"
 #include "gl_sub_view.h"
 
 //#define MAX_WATERFALL_LINES 128
@@ -62,9 +63,12 @@ protected:
     void DrawPersistence();
     void DrawRealTimeFrame();
     void DrawLimitLines(const Trace *limitTrace, const GLVector &v);
+    void DrawLimitViolations(const Trace *limitTrace);
     void DrawBackdrop(QPoint pos, QPoint size);
 
-    void AddToPersistence(const GLVector &v);
+    void BeginPersistence(int sweeps);
+    void AddToPersistence(const GLVector &v, int age);
+    void EndPersistence();
     void AddToWaterfall(const GLVector &v);
     void ClearWaterfall();
     void DrawWaterfall();
@@ -101,6 +105,9 @@ private:
     bool hasOpenGL3; // true when gl version greater than 3.*
     bool canDrawRealTimePersistence;
     bool clear_persistence; // When true, clears buffer next frame update
+    // Persist/waterfall buffer dropped sweeps since the last frame
+    bool traceBufferOverflow;
+    quint64 lastTraceBufferDrops;
     std::unique_ptr<GLProgram> persist_program; // Shaders for persistence
     std::unique_ptr<GLProgram> realTimeShader; // Shader for real-time
     GLuint persist_fbo; // Frame-Buffer-Object for persistent
@@ -112,6 +119,7 @@ private:
     GLuint waterfall_tex; // Waterfall spectrum texture
     std::vector<GLVector*> waterfall_verts;
     std::vector<GLVector*> waterfall_coords;
+    std::vector<LimitViolation> limitViolations; // Last painted
 
     bool realTimePersistOn;
     int realTimeIntensity;
@@ -0,0 +1,107 @@
+#include "channel_power_dialog.h"
+#include "lib/bb_lib.h"
+
+#include <QFileDialog>
+#include <QHeaderView>
+#include <QMessageBox>
+
+static const int REFRESH_INTERVAL_MS = 250;
+
+enum ChannelColumn {
+    ColumnChannel = 0,
+    ColumnCenter,
+    ColumnWidth,
+    ColumnPower,
+    ColumnRelative,
+    ColumnCount
+};
+
+ChannelPowerDialog::ChannelPowerDialog(const ChannelPower *channelPower, QWidget *parent) :
+    QDialog(parent),
+    cp(channelPower)
+{
+    setWindowTitle("Channel Power Table");
+    setObjectName("SH_Page");
+    setFixedSize(560, 480);
+
+    QPoint pos(5, 5);
+    QSize entrySize(350, 25);
+
+    exportClose = new DualButtonEntry("Export CSV", "Close", this);
+    exportClose->move(pos);
+    exportClose->resize(entrySize);
+    pos += QPoint(0, entrySize.height() + 5);
+
+    table = new QTableWidget(0, ColumnCount, this);
+    table->setHorizontalHeaderLabels(QStringList() << "Channel" << "Center" << "Width"
+                                     << "Power" << "Relative");
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+    table->verticalHeader()->hide();
+    table->move(pos);
+    table->resize(width() - 10, height() - pos.y() - 5);
+
+    connect(exportClose, SIGNAL(leftPressed()), this, SLOT(exportResults()));
+    connect(exportClose, SIGNAL(rightPressed()), this, SLOT(close()));
+    connect(&refreshTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+
+    refresh();
+    refreshTimer.start(REFRESH_INTERVAL_MS);
+}
+
+ChannelPowerDialog::~ChannelPowerDialog()
+{
+    refreshTimer.stop();
+}
+
+void ChannelPowerDialog::refresh()
+{
+    cp->GetResults(results);
+    table->setRowCount(results.size());
+
+    int reference = cp->ReferenceChannel();
+
+    for(int i = 0; i < (int)results.size(); i++) {
+        const ChannelResult &r = results[i];
+
+        QStringList row;
+        row << r.label
+            << Frequency((r.start + r.stop) / 2.0).GetFreqString(3, true)
+            << Frequency(r.stop - r.start).GetFreqString(3, true);
+
+        if(!cp->IsEnabled() || !r.inView) {
+            row << "--" << "--";
+        } else {
+            row << QString::number(r.power, 'f', 2);
+            if(reference >= 0 && i != reference) {
+                row << QString::number(r.relative, 'f', 2);
+            } else {
+                row << "--";
+            }
+        }
+
+        for(int c = 0; c < ColumnCount; c++) {
+            QTableWidgetItem *item = table->item(i, c);
+            if(!item) {
+                item = new QTableWidgetItem();
+                table->setItem(i, c, item);
+            }
+            item->setText(row[c]);
+        }
+    }
+}
+
+void ChannelPowerDialog::exportResults()
+{
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Export Channel Power"),
+                                                    bb_lib::get_my_documents_path(),
+                                                    tr("CSV File (*.csv)"));
+    if(fileName.isNull()) {
+        return;
+    }
+
+    if(!cp->ExportResults(fileName)) {
+        QMessageBox::warning(this, "Signal Hound", "Unable to write " + fileName);
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef CHANNEL_POWER_DIALOG_H
+#define CHANNEL_POWER_DIALOG_H
+
+#include <QDialog>
+#include <QTableWidget>
+#include <QTimer>
+
+#include "model/channel_power.h"
+#include "entry_widgets.h"
+
+// Table of every channel in the channel power plan,
+//   refreshed while the dialog is open
+class ChannelPowerDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    ChannelPowerDialog(const ChannelPower *channelPower, QWidget *parent = 0);
+    ~ChannelPowerDialog();
+
+private:
+    const ChannelPower *cp; // Does not own
+
+    DualButtonEntry *exportClose;
+    QTableWidget *table;
+    QTimer refreshTimer;
+
+    std::vector<ChannelResult> results;
+
+private slots:
+    void refresh();
+    void exportResults();
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(ChannelPowerDialog)
+};
+
+#endif // CHANNEL_POWER_DIALOG_H
@@ -0,0 +1,293 @@
+#include "device_monitor_dialog.h"
+#include "device_trace_dialog.h"
+#include "progress_dialog.h"
+
+#include <QEventLoop>
+#include <QHeaderView>
+#include <QMessageBox>
+
+#include <thread>
+
+static const int REFRESH_INTERVAL_MS = 500;
+
+enum MonitorColumn {
+    ColumnDevice = 0,
+    ColumnCenter,
+    ColumnSpan,
+    ColumnSweepRate,
+    ColumnPeakFreq,
+    ColumnPeakAmp,
+    ColumnCount
+};
+
+DeviceMonitorDialog::DeviceMonitorDialog(Session *sPtr, QWidget *parent) :
+    QDialog(parent),
+    session(sPtr)
+{
+    setWindowTitle("Multi-Device Monitor");
+    setObjectName("SH_Page");
+    setFixedSize(660, 400);
+
+    QPoint pos(5, 5);
+    QSize entrySize(350, 25);
+
+    available = new ComboEntry("Available Devices", this);
+    available->move(pos);
+    available->resize(entrySize);
+    pos += QPoint(0, entrySize.height());
+
+    addRemove = new DualButtonEntry("Add Device", "Remove Device", this);
+    addRemove->move(pos);
+    addRemove->resize(entrySize);
+
+    showTraces = new SHPushButton("Show Traces", this);
+    showTraces->move(pos + QPoint(entrySize.width() + 5, 0));
+    showTraces->resize(120, entrySize.height());
+    showTraces->setEnabled(false);
+    pos += QPoint(0, entrySize.height());
+
+    center = new FrequencyEntry("Center", session->sweep_settings->Center(), this);
+    center->move(pos);
+    center->resize(entrySize);
+    pos += QPoint(0, entrySize.height());
+
+    span = new FrequencyEntry("Span", session->sweep_settings->Span(), this);
+    span->move(pos);
+    span->resize(entrySize);
+    pos += QPoint(0, entrySize.height() + 5);
+
+    table = new QTableWidget(0, ColumnCount, this);
+    table->setHorizontalHeaderLabels(QStringList() << "Device" << "Center" << "Span"
+                                     << "Sweeps/s" << "Peak Freq" << "Peak Amp");
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table->setSelectionMode(QAbstractItemView::SingleSelection);
+    table->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+    table->verticalHeader()->hide();
+    table->move(pos);
+    table->resize(width() - 10, height() - pos.y() - 5);
+
+    connect(addRemove, SIGNAL(leftPressed()), this, SLOT(addDevice()));
+    connect(addRemove, SIGNAL(rightPressed()), this, SLOT(removeDevice()));
+    connect(showTraces, SIGNAL(clicked()), this, SLOT(showDeviceTraces()));
+    connect(center, SIGNAL(freqViewChanged(Frequency)),
+            this, SLOT(centerChanged(Frequency)));
+    connect(span, SIGNAL(freqViewChanged(Frequency)),
+            this, SLOT(spanChanged(Frequency)));
+    connect(table, SIGNAL(itemSelectionChanged()), this, SLOT(selectionChanged()));
+    connect(&refreshTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+
+    PopulateAvailable();
+    refresh();
+    refreshTimer.start(REFRESH_INTERVAL_MS);
+}
+
+DeviceMonitorDialog::~DeviceMonitorDialog()
+{
+    refreshTimer.stop();
+}
+
+// Only devices of the same series as the primary device can be added,
+//   the device traits are shared by the whole program
+void DeviceMonitorDialog::PopulateAvailable()
+{
+    availableList.clear();
+    QStringList names;
+
+    DeviceSeries primarySeries = session->PrimarySeries();
+
+    for(const DeviceConnectionInfo &info : session->device->GetDeviceList()) {
+        if(info.series != primarySeries || session->IsDeviceInUse(info)) {
+            continue;
+        }
+        availableList.push_back(info);
+        names.push_back(QString("Serial %1").arg(info.serialNumber));
+    }
+
+    if(names.empty()) {
+        names.push_back("No Devices Available");
+    }
+    available->setComboText(names);
+    addRemove->LeftButton()->setEnabled(!availableList.empty());
+}
+
+void DeviceMonitorDialog::OpenInThread(QEventLoop *el, Device *device, int serialToOpen)
+{
+    device->OpenDeviceWithSerial(serialToOpen);
+
+    while(!el->isRunning()) {
+        Sleep(1);
+    }
+    el->exit();
+}
+
+DeviceAcquisition* DeviceMonitorDialog::SelectedAcquisition()
+{
+    QList<DeviceAcquisition*> devices = session->Devices();
+    int row = table->currentRow();
+    if(row < 0 || row >= devices.size()) {
+        return nullptr;
+    }
+    return devices[row];
+}
+
+void DeviceMonitorDialog::addDevice()
+{
+    int ix = available->CurrentIndex();
+    if(ix < 0 || ix >= availableList.size()) {
+        return;
+    }
+
+    DeviceConnectionInfo info = availableList[ix];
+    Device *device = session->CreateDevice(info.series);
+
+    SHProgressDialog pd("Connecting Device", this);
+    pd.show();
+
+    QEventLoop el;
+    std::thread t = std::thread(&DeviceMonitorDialog::OpenInThread,
+                                this, &el, device, info.serialNumber);
+    el.exec();
+    if(t.joinable()) {
+        t.join();
+    }
+
+    pd.hide();
+
+    if(!device->IsOpen()) {
+        delete device;
+        QMessageBox::warning(this, "Signal Hound", "Unable to open device.");
+        PopulateAvailable();
+        return;
+    }
+
+    session->AddDevice(device, info);
+    lastSweepCounts.push_back(0);
+
+    PopulateAvailable();
+    refresh();
+}
+
+void DeviceMonitorDialog::removeDevice()
+{
+    DeviceAcquisition *acquisition = SelectedAcquisition();
+    if(!acquisition) {
+        return;
+    }
+
+    int row = table->currentRow();
+    if(!session->RemoveDevice(acquisition)) {
+        QMessageBox::warning(this, "Signal Hound",
+                             "The device is in use by a stitched sweep.");
+        return;
+    }
+    lastSweepCounts.removeAt(row);
+
+    PopulateAvailable();
+    refresh();
+}
+
+// Non-modal, one dialog per request
+void DeviceMonitorDialog::showDeviceTraces()
+{
+    DeviceAcquisition *acquisition = SelectedAcquisition();
+    if(!acquisition) {
+        return;
+    }
+
+    DeviceTraceDialog *dlg = new DeviceTraceDialog(session, acquisition, this);
+    dlg->setAttribute(Qt::WA_DeleteOnClose);
+    dlg->show();
+}
+
+void DeviceMonitorDialog::refresh()
+{
+    QList<DeviceAcquisition*> devices = session->Devices();
+    table->setRowCount(devices.size());
+
+    // Devices may be removed outside the dialog when the primary device changes
+    while(lastSweepCounts.size() > devices.size()) {
+        lastSweepCounts.removeLast();
+    }
+    while(lastSweepCounts.size() < devices.size()) {
+        lastSweepCounts.push_back(0);
+    }
+
+    for(int i = 0; i < devices.size(); i++) {
+        DeviceAcquisition *acquisition = devices[i];
+        SweepSettings ss = acquisition->GetSweepSettings();
+
+        long long count = acquisition->SweepCount();
+        double rate = (count - lastSweepCounts[i]) * 1000.0 / REFRESH_INTERVAL_MS;
+        lastSweepCounts[i] = count;
+
+        QString name = QString("Serial %1").arg(acquisition->ConnectionInfo().serialNumber);
+        if(session->DevicesBorrowed()) {
+            name += " - Stitched";
+        } else if(!acquisition->IsRunning()) {
+            name += " - Stopped";
+        }
+
+        QStringList row;
+        row << name
+            << ss.Center().GetFreqString(3, true)
+            << ss.Span().GetFreqString(3, true)
+            << QString::number(rate, 'f', 1);
+
+        double peakFreq, peakAmp;
+        if(acquisition->GetLastPeak(&peakFreq, &peakAmp)) {
+            row << Frequency(peakFreq).GetFreqString(3, true)
+                << QString::number(peakAmp, 'f', 2);
+        } else {
+            row << "--" << "--";
+        }
+
+        for(int c = 0; c < ColumnCount; c++) {
+            QTableWidgetItem *item = table->item(i, c);
+            if(!item) {
+                item = new QTableWidgetItem();
+                table->setItem(i, c, item);
+            }
+            item->setText(row[c]);
+        }
+    }
+}
+
+void DeviceMonitorDialog::selectionChanged()
+{
+    DeviceAcquisition *acquisition = SelectedAcquisition();
+    showTraces->setEnabled(acquisition != nullptr);
+    if(!acquisition) {
+        return;
+    }
+
+    SweepSettings ss = acquisition->GetSweepSettings();
+    center->SetFrequency(ss.Center());
+    span->SetFrequency(ss.Span());
+}
+
+void DeviceMonitorDialog::centerChanged(Frequency f)
+{
+    DeviceAcquisition *acquisition = SelectedAcquisition();
+    if(!acquisition) {
+        return;
+    }
+
+    SweepSettings ss = acquisition->GetSweepSettings();
+    ss.setCenter(f);
+    acquisition->SetSweepSettings(ss);
+    center->SetFrequency(ss.Center());
+}
+
+void DeviceMonitorDialog::spanChanged(Frequency f)
+{
+    DeviceAcquisition *acquisition = SelectedAcquisition();
+    if(!acquisition) {
+        return;
+    }
+
+    SweepSettings ss = acquisition->GetSweepSettings();
+    ss.setSpan(f);
+    acquisition->SetSweepSettings(ss);
+    span->SetFrequency(ss.Span());
+}
@@ -0,0 +1,51 @@
+#ifndef DEVICE_MONITOR_DIALOG_H
+#define DEVICE_MONITOR_DIALOG_H
+
+#include <QDialog>
+#include <QTableWidget>
+#include <QTimer>
+
+#include "model/session.h"
+#include "entry_widgets.h"
+
+// Opens additional devices in the session and shows a
+//   summary of each while they sweep in the background
+class DeviceMonitorDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    DeviceMonitorDialog(Session *sPtr, QWidget *parent = 0);
+    ~DeviceMonitorDialog();
+
+private:
+    void PopulateAvailable();
+    void OpenInThread(QEventLoop *el, Device *device, int serialToOpen);
+    DeviceAcquisition* SelectedAcquisition();
+
+    Session *session; // Does not own
+
+    ComboEntry *available;
+    DualButtonEntry *addRemove;
+    SHPushButton *showTraces;
+    FrequencyEntry *center, *span;
+    QTableWidget *table;
+    QTimer refreshTimer;
+
+    QList<DeviceConnectionInfo> availableList;
+    // Sweep counts at the last refresh, for the sweep rate column
+    QList<long long> lastSweepCounts;
+
+private slots:
+    void addDevice();
+    void removeDevice();
+    void showDeviceTraces();
+    void refresh();
+    void selectionChanged();
+    void centerChanged(Frequency f);
+    void spanChanged(Frequency f);
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(DeviceMonitorDialog)
+};
+
+#endif // DEVICE_MONITOR_DIALOG_H
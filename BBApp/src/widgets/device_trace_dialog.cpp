@@ -0,0 +1,99 @@
+#include "device_trace_dialog.h"
+
+#include <QPainter>
+
+static const int REFRESH_INTERVAL_MS = 50;
+static const int MARGIN = 20;
+
+DeviceTraceDialog::DeviceTraceDialog(Session *sPtr,
+                                     DeviceAcquisition *acquisitionPtr,
+                                     QWidget *parent) :
+    QDialog(parent),
+    session(sPtr),
+    acquisition(acquisitionPtr)
+{
+    setWindowTitle(QString("Device Traces - Serial %1")
+                   .arg(acquisition->ConnectionInfo().serialNumber));
+    resize(640, 400);
+
+    connect(&refreshTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+    refreshTimer.start(REFRESH_INTERVAL_MS);
+}
+
+DeviceTraceDialog::~DeviceTraceDialog()
+{
+    refreshTimer.stop();
+}
+
+// Acquisitions are only removed on the GUI thread
+void DeviceTraceDialog::refresh()
+{
+    if(!session->Devices().contains(acquisition)) {
+        refreshTimer.stop();
+        close();
+        return;
+    }
+
+    update();
+}
+
+void DeviceTraceDialog::paintEvent(QPaintEvent *)
+{
+    QPainter p(this);
+    p.fillRect(rect(), session->colors.background);
+
+    // May be removed between the refresh and this paint
+    if(!session->Devices().contains(acquisition)) {
+        return;
+    }
+
+    QRect grat(MARGIN, MARGIN, width() - 2 * MARGIN, height() - 3 * MARGIN);
+    if(grat.width() <= 0 || grat.height() <= 0) {
+        return;
+    }
+
+    // 10 x 10 divisions
+    p.setPen(QPen(session->colors.graticule, 1, Qt::DotLine));
+    for(int i = 1; i < 10; i++) {
+        int x = grat.left() + grat.width() * i / 10;
+        int y = grat.top() + grat.height() * i / 10;
+        p.drawLine(x, grat.top(), x, grat.bottom());
+        p.drawLine(grat.left(), y, grat.right(), y);
+    }
+    p.setPen(session->colors.graticule);
+    p.drawRect(grat);
+
+    SweepSettings ss = acquisition->GetSweepSettings();
+    p.setPen(session->colors.text);
+    p.drawText(QRect(MARGIN, grat.bottom(), grat.width(), 2 * MARGIN),
+               Qt::AlignVCenter | Qt::AlignLeft,
+               "Center " + ss.Center().GetFreqString(3, true) +
+               "    Span " + ss.Span().GetFreqString(3, true) +
+               "    Ref " + ss.RefLevel().GetString());
+
+    // Each column of the normalized trace is a min/max pair in [0,1]
+    p.setClipRect(grat);
+    p.setRenderHint(QPainter::Antialiasing, false);
+
+    TraceManager *tm = acquisition->GetTraceManager();
+    tm->Lock();
+    for(int i = 0; i < TRACE_COUNT; i++) {
+        const Trace *t = tm->GetTrace(i);
+        if(!t->Active() || t->Length() <= 0) {
+            continue;
+        }
+
+        normalize_trace(t, normalized, QPoint(grat.width(), grat.height()));
+
+        QPolygonF line;
+        line.reserve(normalized.size() / 2);
+        for(size_t j = 0; j + 1 < normalized.size(); j += 2) {
+            line.push_back(QPointF(grat.left() + normalized[j] * grat.width(),
+                                   grat.bottom() - normalized[j + 1] * grat.height()));
+        }
+
+        p.setPen(t->Color());
+        p.drawPolyline(line);
+    }
+    tm->Unlock();
+}
@@ -0,0 +1,37 @@
+#ifndef DEVICE_TRACE_DIALOG_H
+#define DEVICE_TRACE_DIALOG_H
+
+#include <QDialog>
+#include <QTimer>
+
+#include "lib/bb_lib.h"
+#include "model/session.h"
+
+// Plots the traces of one additional device
+// Closes itself once the device is removed from the session
+class DeviceTraceDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    DeviceTraceDialog(Session *sPtr, DeviceAcquisition *acquisitionPtr,
+                      QWidget *parent = 0);
+    ~DeviceTraceDialog();
+
+protected:
+    void paintEvent(QPaintEvent *);
+
+private:
+    Session *session; // Does not own
+    DeviceAcquisition *acquisition; // Does not own
+    QTimer refreshTimer;
+
+    GLVector normalized; // Last trace drawn, reused between paints
+
+private slots:
+    void refresh();
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(DeviceTraceDialog)
+};
+
+#endif // DEVICE_TRACE_DIALOG_H
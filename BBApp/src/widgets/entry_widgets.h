@@ -386,6 +386,8 @@ public:
     ComboEntry(const QString &label_text, QWidget *parent = 0);
     ~ComboEntry() {}
 
+    int CurrentIndex() const { return combo_box->currentIndex(); }
+
 protected:
     void resizeEvent(QResizeEvent *);
 
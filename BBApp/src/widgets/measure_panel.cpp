@@ -1,6 +1,8 @@
 #include "measure_panel.h"
+#include "channel_power_dialog.h"
 #include "../model/trace_manager.h"
 
+#include <QFileDialog>
 #include <QMessageBox>
 
 MeasurePanel::MeasurePanel(const QString &title,
@@ -16,6 +18,7 @@ MeasurePanel::MeasurePanel(const QString &title,
     DockPage *offset_page = new DockPage("Offsets");
     channel_power_page = new DockPage("Channel Power");
     occupied_bandwidth_page = new DockPage("Occupied Bandwidth");
+    density_page = new DockPage("Spectral Density");
 
     QStringList string_list;
 
@@ -125,21 +128,42 @@ MeasurePanel::MeasurePanel(const QString &title,
     connect(ref_offset, SIGNAL(valueChanged(double)),
             trace_manager_ptr, SLOT(setRefOffset(double)));
 
+    channel_plan = new ComboEntry("Plan");
+    string_list.clear();
+    string_list << "Adjacent" << "Raster" << "Imported";
+    channel_plan->setComboText(string_list);
     channel_width = new FrequencyEntry("Width",
                                        20.0e6);
     channel_spacing = new FrequencyEntry("Spacing", 20.0e6);
+    channel_first = new FrequencyEntry("First Center", 1.0e9);
+    channel_count = new NumericEntry("Channels", 10, "");
+    channel_import_table = new DualButtonEntry("Import Plan", "Table");
     channel_power_enabled = new CheckBoxEntry("Enabled");
 
+    channel_power_page->AddWidget(channel_plan);
     channel_power_page->AddWidget(channel_width);
     channel_power_page->AddWidget(channel_spacing);
+    channel_power_page->AddWidget(channel_first);
+    channel_power_page->AddWidget(channel_count);
+    channel_power_page->AddWidget(channel_import_table);
     channel_power_page->AddWidget(channel_power_enabled);
 
     AppendPage(channel_power_page);
 
+    connect(channel_plan, SIGNAL(comboIndexChanged(int)),
+            this, SLOT(channelPowerUpdated()));
     connect(channel_width, SIGNAL(freqViewChanged(Frequency)),
             this, SLOT(channelPowerUpdated()));
     connect(channel_spacing, SIGNAL(freqViewChanged(Frequency)),
             this, SLOT(channelPowerUpdated()));
+    connect(channel_first, SIGNAL(freqViewChanged(Frequency)),
+            this, SLOT(channelPowerUpdated()));
+    connect(channel_count, SIGNAL(valueChanged(double)),
+            this, SLOT(channelPowerUpdated()));
+    connect(channel_import_table, SIGNAL(leftPressed()),
+            this, SLOT(importChannelPlan()));
+    connect(channel_import_table, SIGNAL(rightPressed()),
+            this, SLOT(showChannelTable()));
     connect(channel_power_enabled, SIGNAL(clicked(bool)),
             this, SLOT(channelPowerUpdated()));
 
@@ -155,6 +179,34 @@ MeasurePanel::MeasurePanel(const QString &title,
     connect(ocbw_enabled, SIGNAL(clicked(bool)), SLOT(occupiedBandwidthUpdated()));
     connect(percentPower, SIGNAL(valueChanged(double)), SLOT(occupiedBandwidthUpdated()));
 
+    // Columns of 0 follow the sweep length
+    density_enabled = new CheckBoxEntry("Enabled");
+    density_columns = new NumericEntry("Columns", 0, "");
+    density_rows = new NumericEntry("Rows", 512, "");
+    density_top = new NumericEntry("Top", 0.0, "dBm");
+    density_bottom = new NumericEntry("Bottom", -130.0, "dBm");
+    density_half_life = new NumericEntry("Half Life", 0, "sweeps");
+    density_export = new DualButtonEntry("Export Data", "Export Image");
+
+    density_page->AddWidget(density_enabled);
+    density_page->AddWidget(density_columns);
+    density_page->AddWidget(density_rows);
+    density_page->AddWidget(density_top);
+    density_page->AddWidget(density_bottom);
+    density_page->AddWidget(density_half_life);
+    density_page->AddWidget(density_export);
+
+    AppendPage(density_page);
+
+    connect(density_enabled, SIGNAL(clicked(bool)), SLOT(densityUpdated()));
+    connect(density_columns, SIGNAL(valueChanged(double)), SLOT(densityUpdated()));
+    connect(density_rows, SIGNAL(valueChanged(double)), SLOT(densityUpdated()));
+    connect(density_top, SIGNAL(valueChanged(double)), SLOT(densityUpdated()));
+    connect(density_bottom, SIGNAL(valueChanged(double)), SLOT(densityUpdated()));
+    connect(density_half_life, SIGNAL(valueChanged(double)), SLOT(densityUpdated()));
+    connect(density_export, SIGNAL(leftPressed()), SLOT(exportDensityData()));
+    connect(density_export, SIGNAL(rightPressed()), SLOT(exportDensityImage()));
+
     // Done connected DockPages to TraceManager
     updateTraceView(0);
     updateMarkerView(0);
@@ -235,6 +287,8 @@ void MeasurePanel::setMode(OperationalMode mode)
 
     channel_power_page->SetPageEnabled(pagesEnabled);
     occupied_bandwidth_page->SetPageEnabled(pagesEnabled);
+    // Only swept data is accumulated
+    density_page->SetPageEnabled(pagesEnabled && mode != MODE_REAL_TIME);
 }
 
 void MeasurePanel::channelPowerUpdated()
@@ -245,9 +299,56 @@ void MeasurePanel::channelPowerUpdated()
                              "Detector = Average\n"
                              "Video Units = Power");
     }
-    trace_manager_ptr->SetChannelPower(channel_power_enabled->IsChecked(),
-                                       channel_width->GetFrequency(),
-                                       channel_spacing->GetFrequency());
+
+    bool enabled = channel_power_enabled->IsChecked();
+    switch(channel_plan->CurrentIndex()) {
+    case ChannelPlanRaster:
+        trace_manager_ptr->SetChannelRaster(enabled,
+                                            channel_first->GetFrequency(),
+                                            channel_spacing->GetFrequency(),
+                                            channel_width->GetFrequency(),
+                                            (int)channel_count->GetValue());
+        break;
+    case ChannelPlanCustom:
+        // First channel of an imported plan is the reference
+        trace_manager_ptr->SetChannelPlan(enabled, imported_plan, 0);
+        break;
+    default:
+        trace_manager_ptr->SetChannelPower(enabled,
+                                           channel_width->GetFrequency(),
+                                           channel_spacing->GetFrequency());
+        break;
+    }
+}
+
+void MeasurePanel::importChannelPlan()
+{
+    QString fileName = QFileDialog::getOpenFileName(0, tr("Select Channel Plan CSV"),
+                                                    bb_lib::get_my_documents_path(),
+                                                    tr("CSV File (*.csv)"));
+    if(fileName.isNull()) {
+        return;
+    }
+
+    std::vector<ChannelDef> plan;
+    if(!ChannelPower::ImportPlan(fileName, plan)) {
+        QMessageBox::warning(0, "Channel Plan",
+                             "No channels found, each row should be\n"
+                             "center MHz, width MHz, optional label");
+        return;
+    }
+
+    imported_plan = plan;
+    channel_plan->setComboIndex(ChannelPlanCustom);
+    channelPowerUpdated();
+}
+
+void MeasurePanel::showChannelTable()
+{
+    ChannelPowerDialog *dlg = new ChannelPowerDialog(
+                trace_manager_ptr->GetChannelPowerInfo(), this);
+    dlg->setAttribute(Qt::WA_DeleteOnClose);
+    dlg->show();
 }
 
 void MeasurePanel::occupiedBandwidthUpdated()
@@ -266,6 +367,57 @@ void MeasurePanel::occupiedBandwidthUpdated()
                                             percentPower->GetValue());
 }
 
+void MeasurePanel::densityUpdated()
+{
+    int columns = bb_lib::max2((int)density_columns->GetValue(), 0);
+    int rows = (int)density_rows->GetValue();
+    bb_lib::clamp(rows, 16, 4096);
+    int halfLife = bb_lib::max2((int)density_half_life->GetValue(), 0);
+
+    density_columns->SetValue(columns);
+    density_rows->SetValue(rows);
+    density_half_life->SetValue(halfLife);
+
+    // Any change starts a new histogram
+    trace_manager_ptr->GetSpectralDensity()->Configure(density_enabled->IsChecked(),
+                                                       columns,
+                                                       rows,
+                                                       density_bottom->GetValue(),
+                                                       density_top->GetValue(),
+                                                       halfLife,
+                                                       0);
+}
+
+void MeasurePanel::exportDensityData()
+{
+    QString fileName = QFileDialog::getSaveFileName(0, tr("Export Spectral Density"),
+                                                    bb_lib::get_my_documents_path(),
+                                                    tr("Density File (*.bin)"));
+    if(fileName.isNull()) {
+        return;
+    }
+
+    if(!trace_manager_ptr->GetSpectralDensity()->ExportBinary(fileName)) {
+        QMessageBox::warning(0, "Spectral Density",
+                             "Nothing accumulated or unable to write\n" + fileName);
+    }
+}
+
+void MeasurePanel::exportDensityImage()
+{
+    QString fileName = QFileDialog::getSaveFileName(0, tr("Export Spectral Density Image"),
+                                                    bb_lib::get_my_documents_path(),
+                                                    tr("Images (*.png *.bmp *.jpg)"));
+    if(fileName.isNull()) {
+        return;
+    }
+
+    if(!trace_manager_ptr->GetSpectralDensity()->ExportImage(fileName)) {
+        QMessageBox::warning(0, "Spectral Density",
+                             "Nothing accumulated or unable to write\n" + fileName);
+    }
+}
+
 void MeasurePanel::setMarkerFrequencyChanged(Frequency f)
 {
     if(f.Val() < 0.0) {
@@ -4,6 +4,7 @@
 #include "dock_panel.h"
 #include "entry_widgets.h"
 #include "lib/bb_lib.h"
+#include "model/channel_power.h"
 
 class TraceManager;
 class SweepSettings;
@@ -21,6 +22,7 @@ public:
 private:
     DockPage *channel_power_page;
     DockPage *occupied_bandwidth_page;
+    DockPage *density_page;
 
     // Trace Widgets
     ComboEntry *trace_select;
@@ -44,14 +46,29 @@ private:
     NumericEntry *ref_offset;
 
     // Channel Power
+    ComboEntry *channel_plan;
     FrequencyEntry *channel_width;
     FrequencyEntry *channel_spacing;
+    FrequencyEntry *channel_first;
+    NumericEntry *channel_count;
+    DualButtonEntry *channel_import_table;
     CheckBoxEntry *channel_power_enabled;
+    // Last imported plan, used when the plan is set to imported
+    std::vector<ChannelDef> imported_plan;
 
     // Occupied Bandwidth
     CheckBoxEntry *ocbw_enabled;
     NumericEntry *percentPower;
 
+    // Spectral Density
+    CheckBoxEntry *density_enabled;
+    NumericEntry *density_columns;
+    NumericEntry *density_rows;
+    NumericEntry *density_top;
+    NumericEntry *density_bottom;
+    NumericEntry *density_half_life;
+    DualButtonEntry *density_export;
+
     // Copy of the pointer, does not own
     TraceManager *trace_manager_ptr;
     const SweepSettings *settings_ptr;
@@ -65,7 +82,12 @@ public slots:
 
 private slots:
     void channelPowerUpdated();
+    void importChannelPlan();
+    void showChannelTable();
     void occupiedBandwidthUpdated();
+    void densityUpdated();
+    void exportDensityData();
+    void exportDensityImage();
 
     void setMarkerFrequencyChanged(Frequency);
 
@@ -19,6 +19,11 @@ BBStatusBar::BBStatusBar(QWidget *parent) :
     deviceType->setText("No Device Connected");
     addPermanentWidget(deviceType, 0);
 
+    performance = new Label();
+    performance->setAlignment(Qt::AlignRight);
+    performance->setVisible(false);
+    addPermanentWidget(performance, 0);
+
     diagnostics = new Label();
     diagnostics->setMinimumWidth(100);
     diagnostics->setAlignment(Qt::AlignRight);
@@ -16,6 +16,12 @@ public:
     void SetCursorPos(const QString &locStr) { cursorLoc->setText(locStr); }
     void SetDeviceType(const QString &text) { deviceType->setText(text); }
     void UpdateDeviceInfo(const QString &text) { deviceInfo->setText(text); }
+    void SetPerformance(const QString &text) {
+        performance->setText(text);
+        performance->setVisible(!text.isEmpty());
+    }
+
+public slots:
     void SetDiagnostics(const QString &text) { diagnostics->setText(text); }
 
 private:
@@ -24,6 +30,7 @@ private:
     Label *deviceType; // What device is connected
     Label *deviceInfo; // SN and FW of device
     Label *diagnostics; // Operating diagnostics
+    Label *performance; // Sweep rate and per-stage timing
 };
 
 #endif // STATUS_BAR_H